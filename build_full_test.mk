@@ -25,9 +25,10 @@ $(TEST)_SRC= \
 	tests/test_common/matrix.c \
 	tests/test_common/test_driver.cpp \
 	tests/test_common/keyboard_report_util.cpp \
-	tests/test_common/test_fixture.cpp
+	tests/test_common/test_fixture.cpp \
+	tests/test_common/trace_replay.cpp
 $(TEST)_SRC += $(patsubst $(ROOTDIR)/%,%,$(wildcard $(TEST_PATH)/*.cpp))
 
 $(TEST)_DEFS=$(TMK_COMMON_DEFS) $(OPT_DEFS)
 $(TEST)_CONFIG=$(TEST_PATH)/config.h
-VPATH+=$(TOP_DIR)/tests/test_common
\ No newline at end of file
+VPATH+=$(TOP_DIR)/tests/test_common $(TOP_DIR)/$(TEST_PATH)
\ No newline at end of file
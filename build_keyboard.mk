@@ -329,6 +329,10 @@ ifneq ("$(wildcard $(KEYMAP_PATH)/config.h)","")
     CONFIG_H += $(KEYMAP_PATH)/config.h
 endif
 
+# Everything added to SRC so far comes from the keyboard, keymap or userspace.
+# The rest is core code that is shared between targets (see CORE_OUTPUT below).
+TARGET_SRC := $(SRC) $(KEYBOARD_SRC) $(KEYMAP_C)
+
 # project specific files
 SRC += $(KEYBOARD_SRC) \
     $(KEYMAP_C) \
@@ -382,6 +386,45 @@ CONFIG_H += $(POST_CONFIG_H)
 ALL_CONFIGS := $(PROJECT_CONFIG) $(CONFIG_H)
 
 OUTPUTS := $(KEYMAP_OUTPUT) $(KEYBOARD_OUTPUT)
+
+# Core objects (tmk_core, quantum, drivers, protocol) only depend on the keymap
+# through its config.h and rules.mk. They are built in a directory named after a
+# fingerprint of the compiler, flags, source list and the macros the config
+# headers end up defining, so keymaps with the same effective configuration
+# reuse each other's objects instead of recompiling them. Keymap and userspace
+# folders are left off the core include path, unless a feature makes core code
+# include files from them. Those files are then hashed into the fingerprint too.
+SHARE_CORE_OBJECTS ?= yes
+ifeq ($(strip $(SHARE_CORE_OBJECTS)), yes)
+    CORE_SRC := $(filter-out $(TARGET_SRC) %.clib,$(SRC))
+    SRC := $(filter-out $(CORE_SRC),$(SRC))
+    CORE_DEFS := $(OPT_DEFS) $(GFXDEFS) \
+        -DQMK_KEYBOARD=\"$(KEYBOARD)\" -DQMK_KEYBOARD_H=\"$(QMK_KEYBOARD_H)\" -DQMK_KEYBOARD_CONFIG_H=\"$(KEYBOARD_PATH_1)/config.h\" \
+        -DQMK_SUBPROJECT -DQMK_SUBPROJECT_H -DQMK_SUBPROJECT_CONFIG_H
+    CORE_INC := $(filter-out $(KEYMAP_PATH) $(USER_PATH),$(VPATH)) $(EXTRAINCDIRS)
+    ifneq ($(filter yes,$(strip $(RGB_MATRIX_CUSTOM_KB)) $(strip $(RGB_MATRIX_CUSTOM_USER))),)
+        # rgb_matrix.c includes rgb_matrix_kb.inc and rgb_matrix_user.inc
+        CORE_INC := $(VPATH) $(EXTRAINCDIRS)
+        CORE_INCLUDED := $(wildcard $(addsuffix /rgb_matrix_kb.inc,$(VPATH)) $(addsuffix /rgb_matrix_user.inc,$(VPATH)))
+    endif
+    CORE_HASH ?= $(if $(shell command -v sha1sum 2>/dev/null),sha1sum,shasum)
+    CORE_FINGERPRINT := $(shell { \
+        $(CC) --version; \
+        echo '$(MCUFLAGS) $(CFLAGS) $(CPPFLAGS) $(ASFLAGS) $(EXTRAFLAGS) $(CORE_SRC) $(CORE_INC)'; \
+        $(if $(CORE_INCLUDED),cat $(CORE_INCLUDED);) \
+        $(CC) $(MCUFLAGS) -E -dM $(CORE_DEFS) $(patsubst %,-I%,$(CORE_INC)) $(patsubst %,-include %,$(CONFIG_H)) -x c /dev/null; \
+    } 2>&1 | $(CORE_HASH) | cut -c 1-16)
+    CORE_OUTPUT := $(BUILD_DIR)/obj_core_$(KEYBOARD_FILESAFE)_$(CORE_FINGERPRINT)
+
+    OUTPUTS += $(CORE_OUTPUT)
+    $(CORE_OUTPUT)_SRC := $(CORE_SRC)
+    $(CORE_OUTPUT)_DEFS := $(CORE_DEFS)
+    $(CORE_OUTPUT)_INC := $(CORE_INC)
+    $(CORE_OUTPUT)_CONFIG := $(CONFIG_H)
+    # The config paths differ between sharing keymaps, so track the fingerprint instead of the raw flags
+    $(CORE_OUTPUT)_FLAGS_ID := $(CORE_FINGERPRINT)
+endif
+
 $(KEYMAP_OUTPUT)_SRC := $(SRC)
 $(KEYMAP_OUTPUT)_DEFS := $(OPT_DEFS) $(GFXDEFS) \
 -DQMK_KEYBOARD=\"$(KEYBOARD)\" -DQMK_KEYBOARD_H=\"$(QMK_KEYBOARD_H)\" -DQMK_KEYBOARD_CONFIG_H=\"$(KEYBOARD_PATH_1)/config.h\" \
@@ -399,6 +442,7 @@ all: build check-size
 build: elf cpfirmware
 check-size: build
 objs-size: build
+size-report: build
 
 include show_options.mk
 include $(TMK_PATH)/rules.mk
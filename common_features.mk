@@ -39,6 +39,7 @@ ifeq ($(strip $(AUDIO_ENABLE)), yes)
         SRC += $(QUANTUM_DIR)/audio/audio.c
     else
         SRC += $(QUANTUM_DIR)/audio/audio_arm.c
+        SRC += $(QUANTUM_DIR)/audio/audio_synth.c
     endif
     SRC += $(QUANTUM_DIR)/audio/voices.c
     SRC += $(QUANTUM_DIR)/audio/luts.c
@@ -107,6 +108,7 @@ ifeq ($(strip $(RGBLIGHT_ENABLE)), yes)
     OPT_DEFS += -DRGBLIGHT_ENABLE
     SRC += $(QUANTUM_DIR)/color.c
     SRC += $(QUANTUM_DIR)/rgblight.c
+    SRC += $(QUANTUM_DIR)/animation_clock.c
     CIE1931_CURVE = yes
     LED_BREATHING_TABLE = yes
     ifeq ($(strip $(RGBLIGHT_CUSTOM_DRIVER)), yes)
@@ -125,6 +127,7 @@ ifneq ($(strip $(LED_MATRIX_ENABLE)), no)
     else
         OPT_DEFS += -DLED_MATRIX_ENABLE -DBACKLIGHT_ENABLE -DBACKLIGHT_CUSTOM_DRIVER
         SRC += $(QUANTUM_DIR)/led_matrix.c
+        SRC += $(QUANTUM_DIR)/animation_clock.c
         SRC += $(QUANTUM_DIR)/led_matrix_drivers.c
     endif
 endif
@@ -145,6 +148,7 @@ endif
     OPT_DEFS += -DRGB_MATRIX_ENABLE
     SRC += $(QUANTUM_DIR)/color.c
     SRC += $(QUANTUM_DIR)/rgb_matrix.c
+    SRC += $(QUANTUM_DIR)/animation_clock.c
     SRC += $(QUANTUM_DIR)/rgb_matrix_drivers.c
     CIE1931_CURVE = yes
 endif
@@ -345,6 +349,10 @@ endif
 ifeq ($(strip $(DYNAMIC_KEYMAP_ENABLE)), yes)
     OPT_DEFS += -DDYNAMIC_KEYMAP_ENABLE
     SRC += $(QUANTUM_DIR)/dynamic_keymap.c
+    ifeq ($(strip $(DYNAMIC_KEYMAP_STREAM_ENABLE)), yes)
+        OPT_DEFS += -DDYNAMIC_KEYMAP_STREAM_ENABLE
+        SRC += $(QUANTUM_DIR)/dynamic_keymap_stream.c
+    endif
 endif
 
 ifeq ($(strip $(LEADER_ENABLE)), yes)
@@ -57,6 +57,13 @@ void raw_hid_receive( uint8_t *data, uint8_t length )
 {
 	uint8_t *command_id = &(data[0]);
 	uint8_t *command_data = &(data[1]);
+#ifdef DYNAMIC_KEYMAP_STREAM_ENABLE
+	// Streams queue their own replies
+	if ( dynamic_keymap_stream_receive( data, length ) )
+	{
+		return;
+	}
+#endif
 	switch ( *command_id )
 	{
 		case id_get_protocol_version:
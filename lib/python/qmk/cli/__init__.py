@@ -9,9 +9,12 @@ from . import docs
 from . import doctor
 from . import flash
 from . import hello
+from . import info
 from . import json
 from . import list
+from . import multibuild
 from . import kle2json
 from . import new
 from . import pyformat
 from . import pytest
+from . import size_report
@@ -2,52 +2,140 @@
 
 You can compile a keymap already in the repo or using a QMK Configurator export.
 """
+import os
 import subprocess
-from argparse import FileType
+from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
 
 from milc import cli
 from qmk.commands import create_make_command
 from qmk.commands import parse_configurator_json
 from qmk.commands import compile_configurator_json
 
+import qmk.keyboard_index
 import qmk.keymap
 import qmk.path
 
 
-@cli.argument('filename', nargs='?', arg_only=True, type=FileType('r'), help='The configurator export to compile')
-@cli.argument('-kb', '--keyboard', help='The keyboard to build a firmware for. Ignored when a configurator export is supplied.')
-@cli.argument('-km', '--keymap', help='The keymap to build a firmware for. Ignored when a configurator export is supplied.')
-@cli.subcommand('Compile a QMK Firmware.')
-def compile(cli):
-    """Compile a QMK Firmware.
+def configurator_export(target):
+    """Return the path of a configurator export named on the command line, or None if `target` is a keyboard:keymap.
+    """
+    for path in (target, os.path.join(os.environ.get('ORIG_CWD', ''), target)):
+        if os.path.isfile(path):
+            return path
 
-    If a Configurator export is supplied this command will create a new keymap, overwriting an existing keymap if one exists.
+    if ':' not in target:
+        raise ValueError('%s is neither a configurator export nor a keyboard:keymap target' % target)
 
-    FIXME(skullydazed): add code to check and warn if the keymap already exists
+    return None
 
-    If --keyboard and --keymap are provided this command will build a firmware based on that.
 
+def target_command(target):
+    """Turn one command line target into the keyboard it builds and the make command to run.
     """
-    if cli.args.filename:
-        # Parse the configurator json
-        user_keymap = parse_configurator_json(cli.args.filename)
+    filename = configurator_export(target)
+
+    if filename:
+        with open(filename) as configurator_file:
+            user_keymap = parse_configurator_json(configurator_file)
+
+        # Only this keyboard is parsed, the index of the whole tree is not needed for one build
+        keyboard_dir = qmk.keyboard_index.keyboard_dirs(user_keymap['keyboard'])[-1]
+        if not os.path.exists(os.path.join(keyboard_dir, 'rules.mk')):
+            raise ValueError('%s is for %s, which is not a keyboard' % (target, user_keymap['keyboard']))
+        keyboard = qmk.keyboard_index.parse_keyboard(user_keymap['keyboard'])
+        if keyboard['layouts'] and user_keymap['layout'] not in keyboard['layouts']:
+            cli.log.warning('%s does not define {fg_cyan}%s{style_reset_all}, it has %s', user_keymap['keyboard'], user_keymap['layout'], ', '.join(keyboard['layouts']))
 
         # Generate the keymap
         keymap_path = qmk.path.keymap(user_keymap['keyboard'])
         cli.log.info('Creating {fg_cyan}%s{style_reset_all} keymap in {fg_cyan}%s', user_keymap['keymap'], keymap_path)
 
-        # Compile the keymap
         command = compile_configurator_json(user_keymap)
 
         cli.log.info('Wrote keymap to {fg_cyan}%s/%s/keymap.c', keymap_path, user_keymap['keymap'])
+        return user_keymap['keyboard'], command
+
+    keyboard, keymap = target.split(':', 1)
+    return keyboard, create_make_command(keyboard, keymap)
+
+
+def compile_group(commands):
+    """Run the make commands for one keyboard one after another.
+
+    Keymaps of the same keyboard can share core objects in .build, so they must not be compiled at the same time.
+    """
+    results = []
+
+    for command in commands:
+        cli.log.info('Compiling keymap with {fg_cyan}%s', ' '.join(command))
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        results.append((command, result))
+
+    return results
+
+
+def compile_parallel(commands, jobs):
+    """Compile several (keyboard, command) pairs, one worker per keyboard at most.
+
+    Returns True if every target built.
+    """
+    groups = OrderedDict()
+    for keyboard, command in commands:
+        groups.setdefault(keyboard, []).append(command)
+
+    with ThreadPoolExecutor(max_workers=jobs) as executor:
+        results = [result for group in executor.map(compile_group, groups.values()) for result in group]
+
+    failed = 0
+    for command, result in results:
+        if result.returncode:
+            failed += 1
+            cli.log.error('{fg_red}Failed{style_reset_all} %s\n%s', ' '.join(command), result.stdout)
+        else:
+            cli.log.info('{fg_green}Built{style_reset_all} %s', ' '.join(command))
+
+    cli.log.info('Compiled %d targets, %d failed.', len(results), failed)
+    return failed == 0
+
+
+@cli.argument('targets', nargs='*', arg_only=True, help='Configurator exports or keyboard:keymap targets to compile')
+@cli.argument('-kb', '--keyboard', help='The keyboard to build a firmware for. Ignored when targets are supplied.')
+@cli.argument('-km', '--keymap', help='The keymap to build a firmware for. Ignored when targets are supplied.')
+@cli.argument('-j', '--parallel', type=int, default=0, help='How many keyboards to compile at once when several targets are given. Defaults to the number of CPUs.')
+@cli.subcommand('Compile a QMK Firmware.')
+def compile(cli):
+    """Compile a QMK Firmware.
+
+    If a Configurator export is supplied this command will create a new keymap, overwriting an existing keymap if one exists.
+
+    FIXME(skullydazed): add code to check and warn if the keymap already exists
+
+    If --keyboard and --keymap are provided this command will build a firmware based on that.
+
+    Several targets may be given at once. Keymaps of the same keyboard are compiled in order so they can reuse each other's core objects, while different keyboards are compiled in parallel.
+    """
+    commands = []
+
+    if cli.args.targets:
+        try:
+            for target in cli.args.targets:
+                commands.append(target_command(target))
+        except ValueError as e:
+            cli.log.error(str(e))
+            return False
 
     elif cli.config.compile.keyboard and cli.config.compile.keymap:
         # Generate the make command for a specific keyboard/keymap.
-        command = create_make_command(cli.config.compile.keyboard, cli.config.compile.keymap)
+        commands.append((cli.config.compile.keyboard, create_make_command(cli.config.compile.keyboard, cli.config.compile.keymap)))
 
     else:
-        cli.log.error('You must supply a configurator export or both `--keyboard` and `--keymap`.')
+        cli.log.error('You must supply a configurator export, keyboard:keymap targets, or both `--keyboard` and `--keymap`.')
         return False
 
-    cli.log.info('Compiling keymap with {fg_cyan}%s\n\n', ' '.join(command))
-    subprocess.run(command)
+    if len(commands) == 1:
+        command = commands[0][1]
+        cli.log.info('Compiling keymap with {fg_cyan}%s\n\n', ' '.join(command))
+        return subprocess.run(command).returncode == 0
+
+    return compile_parallel(commands, cli.config.compile.parallel or os.cpu_count() or 1)
@@ -0,0 +1,41 @@
+"""Show what QMK knows about a keyboard.
+"""
+import json
+
+from milc import cli
+
+import qmk.keyboard_index
+
+
+@cli.argument('-kb', '--keyboard', help='The keyboard to show, for example clueboard/66/rev3')
+@cli.argument('--json', arg_only=True, action='store_true', help='Print the metadata as JSON')
+@cli.subcommand('Show the MCU, matrix size, layouts and features of a keyboard.')
+def info(cli):
+    """Show the metadata the keyboard index holds for a keyboard.
+    """
+    if not cli.config.info.keyboard:
+        cli.log.error('You must supply a keyboard with `--keyboard`.')
+        return False
+
+    keyboard = qmk.keyboard_index.keyboard_info(cli.config.info.keyboard)
+
+    if not keyboard:
+        cli.log.error('Unknown keyboard: {fg_cyan}%s', cli.config.info.keyboard)
+        return False
+
+    if cli.args.json:
+        print(json.dumps({key: value for key, value in keyboard.items() if key != 'files'}, indent=4, sort_keys=True))
+        return True
+
+    cli.echo('{fg_blue}Keyboard Name{fg_reset}: %s', keyboard['keyboard_name'])
+    cli.echo('{fg_blue}Maintainer{fg_reset}: %s', keyboard['maintainer'] or 'unknown')
+    cli.echo('{fg_blue}MCU{fg_reset}: %s', keyboard['mcu'] or 'unknown')
+    cli.echo('{fg_blue}Bootloader{fg_reset}: %s', keyboard['bootloader'] or 'unknown')
+    cli.echo('{fg_blue}Matrix Size{fg_reset}: %s rows x %s cols', keyboard['matrix_size']['rows'], keyboard['matrix_size']['cols'])
+    cli.echo('{fg_blue}Layouts{fg_reset}: %s', ', '.join(keyboard['layouts']) or 'none')
+    cli.echo('{fg_blue}Features{fg_reset}: %s', ', '.join(keyboard['features']) or 'none')
+
+    if keyboard['default_folder']:
+        cli.echo('{fg_blue}Default Folder{fg_reset}: %s', keyboard['default_folder'])
+
+    return True
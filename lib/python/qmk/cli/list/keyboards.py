@@ -1,27 +1,24 @@
 """List the keyboards currently defined within QMK
 """
-import os
-import glob
-
 from milc import cli
 
-BASE_PATH = os.path.join(os.getcwd(), "keyboards") + os.path.sep
-KB_WILDCARD = os.path.join(BASE_PATH, "**", "rules.mk")
-
-
-def find_name(path):
-    """Determine the keyboard name by stripping off the base_path and rules.mk.
-    """
-    return path.replace(BASE_PATH, "").replace(os.path.sep + "rules.mk", "")
+import qmk.keyboard_index
 
 
+@cli.argument('--mcu', arg_only=True, help='Only list keyboards with this MCU')
+@cli.argument('--feature', arg_only=True, action='append', default=[], help='Only list keyboards with this feature enabled, e.g. rgblight. May be given more than once.')
+@cli.argument('--rebuild', arg_only=True, action='store_true', help='Parse every keyboard again instead of using the cached index')
 @cli.subcommand("List the keyboards currently defined within QMK")
 def list_keyboards(cli):
     """List the keyboards currently defined within QMK
     """
-    # find everywhere we have rules.mk where keymaps isn't in the path
-    paths = [path for path in glob.iglob(KB_WILDCARD, recursive=True) if 'keymaps' not in path]
+    index = qmk.keyboard_index.update_index(rebuild=cli.args.rebuild)
+
+    for keyboard_name, info in sorted(index['keyboards'].items()):
+        if cli.args.mcu and info['mcu'] != cli.args.mcu:
+            continue
+
+        if not all(feature.lower() in info['features'] for feature in cli.args.feature):
+            continue
 
-    # Extract the keyboard name from the path and print it
-    for keyboard_name in sorted(map(find_name, paths)):
         print(keyboard_name)
@@ -0,0 +1,237 @@
+"""Compile a keymap for every keyboard, skipping the ones that have not changed.
+"""
+import fnmatch
+import hashlib
+import json
+import os
+import subprocess
+import time
+from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
+
+from milc import cli
+from qmk.commands import create_make_command
+
+import qmk.keyboard_index
+import qmk.path
+
+CACHE_FILE = os.path.join('.build', 'multibuild.json')
+CACHE_VERSION = 2
+REPORT_FILE = os.path.join('.build', 'multibuild_report.json')
+
+# Everything under these goes into every target's hash
+CORE_PATHS = ['Makefile', 'bootloader.mk', 'build_keyboard.mk', 'common.mk', 'common_features.mk', 'message.mk', 'drivers', 'lib', 'quantum', 'tmk_core']
+
+
+class FileHasher(object):
+    """Hashes file contents, remembering each digest for as long as the file's mtime and size stay the same.
+    """
+    def __init__(self, known):
+        self.known = known
+        self.seen = {}
+
+    def file(self, path):
+        stat = os.stat(path)
+        known = self.known.get(path)
+
+        if not known or known[0] != stat.st_mtime or known[1] != stat.st_size:
+            with open(path, 'rb') as fd:
+                known = [stat.st_mtime, stat.st_size, hashlib.sha1(fd.read()).hexdigest()]
+
+        self.seen[path] = known
+        return known[2]
+
+    def tree(self, path, recursive=True):
+        """Returns a digest of the names and contents of the files under `path`.
+        """
+        digest = hashlib.sha1()
+
+        if os.path.isfile(path):
+            digest.update(path.encode() + b'\0' + self.file(path).encode())
+            return digest.hexdigest()
+
+        for root, dirs, files in os.walk(path):
+            dirs[:] = sorted(d for d in dirs if recursive and not d.startswith('.') and os.path.join(root, d) != os.path.join('lib', 'python'))
+            for name in sorted(files):
+                file_path = os.path.join(root, name)
+                digest.update(file_path.encode() + b'\0' + self.file(file_path).encode())
+
+        return digest.hexdigest()
+
+
+def target_inputs(keyboard, keymap):
+    """Returns the paths a keyboard:keymap build reads besides the core, and whether to walk them recursively.
+
+    Subdirectories of the keyboard's directories are left out, they hold other revisions and keymaps.
+    """
+    inputs = [(directory, False) for directory in qmk.keyboard_index.keyboard_dirs(keyboard)]
+
+    for directory in qmk.keyboard_index.keyboard_dirs(keyboard):
+        keymap_dir = os.path.join(directory, 'keymaps', keymap)
+        if os.path.isdir(keymap_dir):
+            inputs.append((keymap_dir, True))
+
+    if os.path.isdir(os.path.join('users', keymap)):
+        inputs.append((os.path.join('users', keymap), True))
+
+    return inputs
+
+
+def target_deps(keyboard, keymap):
+    """Returns the files the last build of a target compiled or included that are not core files, from the dependency files the compiler wrote.
+
+    This catches what target_inputs() can not see, like layouts/ keymaps and sources shared between keyboards.
+    """
+    keyboard_filesafe = keyboard.replace('/', '_')
+    deps = set()
+
+    for output in ('obj_' + keyboard_filesafe, 'obj_%s_%s' % (keyboard_filesafe, keymap)):
+        for root, dirs, files in os.walk(os.path.join('.build', output)):
+            for name in fnmatch.filter(files, '*.d'):
+                with open(os.path.join(root, name), errors='replace') as fd:
+                    for line in fd.read().replace('\\\n', ' ').splitlines():
+                        deps.update(path for path in line.partition(':')[2].split() if not os.path.isabs(path))
+
+    return sorted(path for path in deps if os.path.normpath(path).split(os.sep)[0] not in CORE_PATHS)
+
+
+def deps_hash(hasher, deps):
+    """Returns a digest of the contents of `deps`, a file that is gone counts as a change.
+    """
+    digest = hashlib.sha1()
+
+    for path in deps:
+        digest.update(path.encode() + b'\0' + (hasher.file(path) if os.path.isfile(path) else 'missing').encode())
+
+    return digest.hexdigest()
+
+
+def has_keymap(keyboard, keymap):
+    return any(os.path.isdir(os.path.join(directory, 'keymaps', keymap)) for directory in qmk.keyboard_index.keyboard_dirs(keyboard))
+
+
+def firmware_size(keyboard, keymap):
+    """Returns the size in bytes of a target's firmware, or None if it can not be found.
+    """
+    target = os.path.join('.build', '%s_%s' % (keyboard.replace('/', '_'), keymap))
+
+    if os.path.exists(target + '.bin'):
+        return os.path.getsize(target + '.bin')
+
+    if os.path.exists(target + '.hex'):
+        size = 0
+        with open(target + '.hex') as fd:
+            for line in fd:
+                # :LLAAAATT data records are type 00
+                if line.startswith(':') and line[7:9] == '00':
+                    size += int(line[1:3], 16)
+        return size
+
+    return None
+
+
+def build_group(targets, hasher):
+    """Build the targets of one keyboard one after another, so they can share its core objects.
+    """
+    results = []
+
+    for target in targets:
+        command = create_make_command(target['keyboard'], target['keymap'])
+        start = time.time()
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+
+        target['seconds'] = round(time.time() - start, 2)
+        target['status'] = 'failed' if result.returncode else 'built'
+        target['size'] = None if result.returncode else firmware_size(target['keyboard'], target['keymap'])
+        target['deps'] = target_deps(target['keyboard'], target['keymap'])
+        target['deps_hash'] = deps_hash(hasher, target['deps'])
+
+        if result.returncode:
+            cli.log.error('{fg_red}Failed{style_reset_all} %s:%s\n%s', target['keyboard'], target['keymap'], result.stdout)
+        else:
+            cli.log.info('{fg_green}Built{style_reset_all} %s:%s in %.1fs', target['keyboard'], target['keymap'], target['seconds'])
+
+        results.append(target)
+
+    return results
+
+
+def load_cache():
+    try:
+        with open(CACHE_FILE) as fd:
+            cache = json.load(fd)
+        if cache.get('version') == CACHE_VERSION:
+            return cache
+    except (OSError, ValueError):
+        pass
+
+    return {'version': CACHE_VERSION, 'files': {}, 'targets': {}}
+
+
+@cli.argument('-kb', '--keyboard', arg_only=True, action='append', default=[], help='Only build keyboards matching this pattern, e.g. clueboard/*. May be given more than once.')
+@cli.argument('-km', '--keymap', default='default', help='The keymap to build for every keyboard that has it. Default: default')
+@cli.argument('-j', '--parallel', type=int, default=0, help='How many keyboards to build at once. Defaults to the number of CPUs.')
+@cli.argument('-f', '--force', arg_only=True, action='store_true', help='Build every target, even if its inputs have not changed since it last built')
+@cli.argument('-r', '--report', arg_only=True, help='Where to write the JSON report of every target. Default: .build/multibuild_report.json')
+@cli.subcommand('Compile a keymap for many keyboards at once, skipping the unchanged ones.')
+def multibuild(cli):
+    """Compile a keymap for every keyboard that has it.
+
+    Each target's inputs are hashed: the core build files, the files of the keyboard's directories, its keymap and userspace, and every other file its last build compiled or included. A target that built before with the same hash and still has its firmware is skipped. Keyboards build in parallel, keymaps of the same keyboard in order.
+    """
+    keymap = cli.config.multibuild.keymap
+    index = qmk.keyboard_index.update_index()
+    cache = load_cache()
+    hasher = FileHasher(cache['files'])
+
+    core_hash = hashlib.sha1()
+    for path in CORE_PATHS:
+        if os.path.exists(path):
+            core_hash.update(hasher.tree(path).encode())
+
+    # Keyboards with a DEFAULT_FOLDER are built as that folder
+    keyboards = [kb for kb, info in sorted(index['keyboards'].items()) if not info['default_folder'] and has_keymap(kb, keymap)]
+    if cli.args.keyboard:
+        keyboards = [kb for kb in keyboards if any(fnmatch.fnmatch(kb, pattern) for pattern in cli.args.keyboard)]
+
+    groups = OrderedDict()
+    skipped = []
+
+    for keyboard in keyboards:
+        digest = hashlib.sha1(core_hash.hexdigest().encode())
+        for path, recursive in target_inputs(keyboard, keymap):
+            digest.update(hasher.tree(path, recursive).encode())
+
+        name = '%s:%s' % (keyboard, keymap)
+        target = {'keyboard': keyboard, 'keymap': keymap, 'hash': digest.hexdigest()}
+        cached = cache['targets'].get(name)
+
+        if not cli.args.force and cached and cached['hash'] == target['hash'] and cached['status'] != 'failed' and firmware_size(keyboard, keymap) is not None and cached['deps_hash'] == deps_hash(hasher, cached['deps']):
+            target.update(status='skipped', seconds=0, size=cached['size'], deps=cached['deps'], deps_hash=cached['deps_hash'])
+            skipped.append(target)
+        else:
+            groups.setdefault(keyboard, []).append(target)
+
+    cli.log.info('Building %d targets, %d unchanged.', sum(map(len, groups.values())), len(skipped))
+
+    with ThreadPoolExecutor(max_workers=cli.config.multibuild.parallel or os.cpu_count() or 1) as executor:
+        results = skipped + [target for group in executor.map(build_group, groups.values(), [hasher] * len(groups)) for target in group]
+
+    for target in results:
+        cache['targets']['%s:%s' % (target['keyboard'], target['keymap'])] = target
+    cache['files'].update(hasher.seen)
+
+    os.makedirs(os.path.dirname(CACHE_FILE), exist_ok=True)
+    with open(CACHE_FILE, 'w') as fd:
+        json.dump(cache, fd)
+
+    results.sort(key=lambda target: target['keyboard'])
+    report_file = qmk.path.normpath(cli.args.report) if cli.args.report else REPORT_FILE
+    os.makedirs(os.path.dirname(report_file), exist_ok=True)
+    with open(report_file, 'w') as fd:
+        json.dump([{key: target[key] for key in ('keyboard', 'keymap', 'status', 'seconds', 'size')} for target in results], fd, indent=4)
+
+    failed = sum(1 for target in results if target['status'] == 'failed')
+    cli.log.info('%d built, %d skipped, %d failed. Wrote {fg_cyan}%s', len(results) - len(skipped) - failed, len(skipped), failed, report_file)
+
+    return failed == 0
@@ -0,0 +1,87 @@
+"""Show where a firmware's flash and RAM go.
+"""
+import json
+import os
+
+from milc import cli
+
+import qmk.path
+import qmk.size_report
+
+
+def print_table(title, rows, total_flash, total_ram):
+    """Print (name, flash, ram) rows with their share of the totals.
+    """
+    cli.echo('{fg_blue}%s{fg_reset}', title)
+
+    for name, flash, ram in rows:
+        flash_share = ' (%4.1f%%)' % (100.0 * flash / total_flash) if total_flash else ''
+        ram_share = ' (%4.1f%%)' % (100.0 * ram / total_ram) if total_ram else ''
+        cli.echo('  %-40s %7d%s flash %6d%s RAM', name, flash, flash_share, ram, ram_share)
+
+    cli.echo('')
+
+
+def print_budget(kind, used, size):
+    if size:
+        color = '{fg_red}' if used > size else '{fg_yellow}' if used > size * 0.95 else '{fg_green}'
+        cli.echo('%s%s: %d of %d bytes (%d free){fg_reset}', color, kind, used, size, size - used)
+    else:
+        cli.echo('%s: %d bytes', kind, used)
+
+
+@cli.argument('map_file', arg_only=True, help='The linker map of the firmware, e.g. .build/planck_rev4_default.map')
+@cli.argument('--mcu', arg_only=True, help='The MCU the firmware is for, to check RAM use against')
+@cli.argument('--flash-size', arg_only=True, type=int, default=0, help='How much flash is available to the firmware, in bytes')
+@cli.argument('--ram-size', arg_only=True, type=int, default=0, help='How much RAM there is, in bytes. Known for most AVR MCUs.')
+@cli.argument('--baseline', arg_only=True, help='A JSON report from an earlier build to compare against')
+@cli.argument('-o', '--output', arg_only=True, help='Write the report as JSON to this file')
+@cli.argument('-n', '--count', arg_only=True, type=int, default=15, help='How many of the largest symbols to list. Default: 15')
+@cli.subcommand('Attribute flash and RAM use to features and symbols using the linker map.')
+def size_report(cli):
+    """Attribute flash and RAM use to features and symbols using the linker map.
+
+    Sizes come from the input sections in the map. They are grouped by the feature in common_features.mk or tmk_core/common.mk that compiles their source, or otherwise by process_keycode module or part of the tree.
+    """
+    map_file = qmk.path.normpath(cli.args.map_file)
+    if not os.path.exists(map_file):
+        cli.log.error('Linker map {fg_cyan}%s{style_reset_all} does not exist.', map_file)
+        return False
+
+    sections = qmk.size_report.parse_map(map_file)
+    if not sections:
+        cli.log.error('Found no sections in {fg_cyan}%s{style_reset_all}, is it a GNU ld map?', map_file)
+        return False
+
+    report = qmk.size_report.summarize(sections, qmk.size_report.feature_sources())
+    report['mcu'] = cli.args.mcu
+    report['flash_size'] = cli.args.flash_size or None
+    report['ram_size'] = cli.args.ram_size or qmk.size_report.MCU_RAM.get(cli.args.mcu)
+
+    features = qmk.size_report.largest(report['features'], len(report['features']))
+    print_table('Features', [(name, entry['flash'], entry['ram']) for name, entry in features], report['flash'], report['ram'])
+
+    symbols = qmk.size_report.largest(report['symbols'], cli.args.count)
+    print_table('Largest symbols', [('%s [%s]' % (name, entry['feature']), entry['flash'], entry['ram']) for name, entry in symbols], report['flash'], report['ram'])
+
+    symbols = [item for item in qmk.size_report.largest(report['symbols'], cli.args.count, 'ram') if item[1]['ram']]
+    print_table('Largest RAM users', [('%s [%s]' % (name, entry['feature']), entry['flash'], entry['ram']) for name, entry in symbols], report['flash'], report['ram'])
+
+    if cli.args.baseline:
+        with open(qmk.path.normpath(cli.args.baseline)) as fd:
+            changes = qmk.size_report.diff(report, json.load(fd))
+
+        cli.echo('{fg_blue}Since the baseline{fg_reset}: %+d flash, %+d RAM', changes['flash'], changes['ram'])
+        for table in ('features', 'symbols'):
+            for name, change in qmk.size_report.largest(changes[table], cli.args.count):
+                cli.echo('  %-40s %+7d flash %+6d RAM', name, change['flash'], change['ram'])
+            cli.echo('')
+
+    print_budget('Flash', report['flash'], report['flash_size'])
+    print_budget('RAM', report['ram'], report['ram_size'])
+
+    if cli.args.output:
+        with open(qmk.path.normpath(cli.args.output), 'w') as fd:
+            json.dump(report, fd, indent=4, sort_keys=True)
+
+    return True
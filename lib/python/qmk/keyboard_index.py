@@ -0,0 +1,222 @@
+"""A cached index of keyboard metadata.
+
+Scanning keyboards/ and parsing every rules.mk, config.h and info.json takes seconds, so the results are kept in `.build/keyboard_index.json`. Each entry remembers the files it was parsed from and their mtimes, and only keyboards whose files have changed are parsed again. Parsing is spread over one process per CPU.
+"""
+import json
+import os
+import re
+from concurrent.futures import ProcessPoolExecutor
+
+KEYBOARDS_PATH = 'keyboards'
+INDEX_FILE = os.path.join('.build', 'keyboard_index.json')
+INDEX_VERSION = 1
+
+RULES_RE = re.compile(r'^\s*([A-Za-z0-9_]+)\s*([:?]?=)\s*(.*?)\s*(#.*)?$')
+MATRIX_RE = re.compile(r'^\s*#\s*define\s+(MATRIX_ROWS|MATRIX_COLS)\s+(.+?)\s*(//.*|/\*.*)?$')
+LAYOUT_RE = re.compile(r'^\s*#\s*define\s+(LAYOUT\w*)\b', re.MULTILINE)
+
+
+def keyboard_dirs(keyboard):
+    """Returns the directories that make up a keyboard, outermost first.
+
+    Args:
+        keyboard
+            The name of the keyboard. Example: clueboard/66/rev3
+    """
+    parts = keyboard.split('/')
+    return [os.path.join(KEYBOARDS_PATH, *parts[:i]) for i in range(1, len(parts) + 1)]
+
+
+def keyboard_files(keyboard):
+    """Returns the files a keyboard's metadata is read from that exist, outermost first.
+    """
+    files = []
+
+    for directory in keyboard_dirs(keyboard):
+        for name in ('rules.mk', 'config.h', 'info.json', os.path.basename(directory) + '.h'):
+            path = os.path.join(directory, name)
+            if os.path.exists(path):
+                files.append(path)
+
+    return files
+
+
+def parse_rules_mk(path, rules):
+    """Adds the variables assigned in a rules.mk to `rules`. Later files override earlier ones, except for `?=`.
+    """
+    with open(path, errors='replace') as fd:
+        for line in fd:
+            match = RULES_RE.match(line)
+            if match and (match.group(2) != '?=' or match.group(1) not in rules):
+                rules[match.group(1)] = match.group(3)
+
+
+def parse_keyboard(keyboard):
+    """Returns the metadata for one keyboard.
+
+    Args:
+        keyboard
+            The name of the keyboard. Example: clueboard/66/rev3
+    """
+    rules = {}
+    matrix = {}
+    layouts = []
+    info = {}
+    stamps = {}
+    default_folder = None
+
+    # Directories are stamped too, so a file added anywhere along the way is noticed
+    for directory in keyboard_dirs(keyboard):
+        stamps[directory] = os.stat(directory).st_mtime
+
+    for path in keyboard_files(keyboard):
+        stamps[path] = os.stat(path).st_mtime
+        name = os.path.basename(path)
+
+        if name == 'rules.mk':
+            parse_rules_mk(path, rules)
+
+            # DEFAULT_FOLDER only means something for the directory that sets it
+            if os.path.dirname(path) == keyboard_dirs(keyboard)[-1]:
+                own_rules = {}
+                parse_rules_mk(path, own_rules)
+                default_folder = own_rules.get('DEFAULT_FOLDER')
+
+        elif name == 'config.h':
+            with open(path, errors='replace') as fd:
+                for line in fd:
+                    match = MATRIX_RE.match(line)
+                    if match:
+                        matrix[match.group(1)] = int(match.group(2)) if match.group(2).isdigit() else match.group(2)
+
+        elif name == 'info.json':
+            try:
+                with open(path) as fd:
+                    info.update(json.load(fd))
+            except ValueError:
+                pass
+
+        else:
+            with open(path, errors='replace') as fd:
+                layouts.extend(LAYOUT_RE.findall(fd.read()))
+
+    for layout in info.get('layouts', {}):
+        if layout not in layouts:
+            layouts.append(layout)
+
+    return {
+        'keyboard_name': info.get('keyboard_name', keyboard),
+        'maintainer': info.get('maintainer'),
+        'mcu': rules.get('MCU'),
+        'bootloader': rules.get('BOOTLOADER'),
+        'features': sorted(key[:-7].lower() for key, value in rules.items() if key.endswith('_ENABLE') and value.lower() == 'yes'),
+        'matrix_size': {'rows': matrix.get('MATRIX_ROWS'), 'cols': matrix.get('MATRIX_COLS')},
+        'layouts': sorted(set(layouts)),
+        'default_folder': default_folder,
+        'files': stamps,
+    }
+
+
+def scan_keyboards():
+    """Walks keyboards/ for every directory with a rules.mk, outside of keymaps.
+
+    Returns the keyboard names and the mtime of every directory walked.
+    """
+    keyboards = []
+    directories = {}
+
+    for root, dirs, files in os.walk(KEYBOARDS_PATH):
+        dirs[:] = sorted(d for d in dirs if d != 'keymaps')
+        directories[root] = os.stat(root).st_mtime
+
+        if root != KEYBOARDS_PATH and 'rules.mk' in files:
+            keyboards.append(os.path.relpath(root, KEYBOARDS_PATH).replace(os.path.sep, '/'))
+
+    return keyboards, directories
+
+
+def is_current(stamps):
+    """Returns True if none of the files or directories in `stamps` have changed.
+    """
+    try:
+        return all(os.stat(path).st_mtime == mtime for path, mtime in stamps.items())
+    except OSError:
+        return False
+
+
+def load_index():
+    """Returns the index as it was last written, or an empty one.
+    """
+    try:
+        with open(INDEX_FILE) as fd:
+            index = json.load(fd)
+        if index.get('version') == INDEX_VERSION:
+            return index
+    except (OSError, ValueError):
+        pass
+
+    return {'version': INDEX_VERSION, 'directories': {}, 'keyboards': {}}
+
+
+def save_index(index):
+    """Writes the index, replacing the old one in a single step so readers never see half of it.
+    """
+    os.makedirs(os.path.dirname(INDEX_FILE), exist_ok=True)
+    temp_file = INDEX_FILE + '.%d' % os.getpid()
+
+    with open(temp_file, 'w') as fd:
+        json.dump(index, fd, sort_keys=True)
+
+    os.replace(temp_file, INDEX_FILE)
+
+
+def update_index(rebuild=False, jobs=None):
+    """Brings the index up to date and returns it.
+
+    Args:
+        rebuild
+            Parse every keyboard again, even if its files have not changed.
+
+        jobs
+            How many processes to parse keyboards with. Defaults to the number of CPUs.
+    """
+    index = {'version': INDEX_VERSION, 'directories': {}, 'keyboards': {}} if rebuild else load_index()
+    changed = False
+
+    # A keyboard can only have been added or removed if a directory changed
+    if not index['directories'] or not is_current(index['directories']):
+        keyboards, index['directories'] = scan_keyboards()
+        index['keyboards'] = {keyboard: index['keyboards'].get(keyboard) for keyboard in keyboards}
+        changed = True
+
+    stale = [keyboard for keyboard, entry in index['keyboards'].items() if not entry or not is_current(entry['files'])]
+
+    if stale:
+        if len(stale) == 1:
+            index['keyboards'][stale[0]] = parse_keyboard(stale[0])
+        else:
+            with ProcessPoolExecutor(max_workers=jobs or os.cpu_count() or 1) as executor:
+                for keyboard, entry in zip(stale, executor.map(parse_keyboard, stale, chunksize=16)):
+                    index['keyboards'][keyboard] = entry
+        changed = True
+
+    if changed:
+        save_index(index)
+
+    return index
+
+
+def list_keyboards():
+    """Returns the names of all keyboards, sorted.
+    """
+    return sorted(update_index()['keyboards'])
+
+
+def keyboard_info(keyboard):
+    """Returns the metadata for a keyboard, or None if there is no such keyboard.
+
+    Args:
+        keyboard
+            The name of the keyboard. Example: clueboard/66/rev3
+    """
+    return update_index()['keyboards'].get(keyboard)
@@ -0,0 +1,278 @@
+"""Work out where a firmware's flash and RAM go.
+
+The linker map lists every input section that made it into the image, with its size and the object it came from. Built with -ffunction-sections and -fdata-sections, most input sections hold a single function or variable, so the map is enough to attribute sizes to symbols, source files and the features in common_features.mk that compile them.
+"""
+import os
+import re
+
+# RAM sizes in bytes, flash budgets come from the build since they depend on the bootloader
+MCU_RAM = {
+    'at90usb1286': 8192,
+    'at90usb1287': 8192,
+    'at90usb646': 4096,
+    'at90usb647': 4096,
+    'atmega16u2': 512,
+    'atmega16u4': 1280,
+    'atmega328': 2048,
+    'atmega328p': 2048,
+    'atmega32a': 2048,
+    'atmega32u2': 1024,
+    'atmega32u4': 2560,
+}
+
+FEATURE_FILES = ['common_features.mk', os.path.join('tmk_core', 'common.mk')]
+DIRECTORY_VARIABLES = {'$(QUANTUM_DIR)': 'quantum', '$(QUANTUM_PATH)': 'quantum', '$(COMMON_DIR)': 'tmk_core/common', '$(DRIVER_PATH)': 'drivers', '$(SERIAL_DIR)': 'quantum/serial_link'}
+
+# Output sections by where they end up. .data is stored in flash and copied to RAM.
+FLASH_SECTIONS = ('.text', '.rodata', '.vectors', '.xtors', '.init', '.fini', '.ARM.ex', '.eh_frame', '.progmem', '.trampolines')
+RAM_SECTIONS = ('.bss', '.noinit', '.ram', '.mstack', '.pstack', '.heap', '.stack', '.nocache')
+DATA_SECTIONS = ('.data', )
+
+IF_RE = re.compile(r'^\s*(else\s+)?if(?:n?eq|n?def)\b')
+CONDITION_RE = re.compile(r'if(?:n?eq|n?def)\s*\(?\s*(?:\$\(strip\s+)?(?:\$\()?(\w+)')
+SOURCE_RE = re.compile(r'^\s*(?:SRC|QUANTUM_SRC|TMK_COMMON_SRC)\s*\+?=\s*(.*)$')
+OUTPUT_SECTION_RE = re.compile(r'^(\.\S+)(?:\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+)?')
+INPUT_SECTION_RE = re.compile(r'^ (\.\S+|COMMON)(?:\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)\s+(\S.*))?$')
+CONTINUATION_RE = re.compile(r'^\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+SYMBOL_RE = re.compile(r'^\s+0x[0-9a-fA-F]+\s+([A-Za-z_]\w*)$')
+SECTION_SYMBOL_RE = re.compile(r'^\.(?:text|rodata|data|bss|noinit|progmem\.data|progmem\.gcc_sw_table|progmem)\.(.+)$')
+
+
+def memory_kind(section):
+    """Returns 'flash', 'ram' or 'data' for an output section, or None if it is not part of the image.
+    """
+    if section.startswith(DATA_SECTIONS):
+        return 'data'
+    if section.startswith(RAM_SECTIONS):
+        return 'ram'
+    if section.startswith(FLASH_SECTIONS):
+        return 'flash'
+    return None
+
+
+def read_makefile_lines(path):
+    """Yields the logical lines of a makefile, with backslash continuations joined.
+    """
+    line = ''
+
+    with open(path) as fd:
+        for raw in fd:
+            raw = raw.split('#', 1)[0].rstrip()
+            if raw.endswith('\\'):
+                line += raw[:-1] + ' '
+                continue
+            yield line + raw
+            line = ''
+
+
+def feature_sources(makefiles=FEATURE_FILES):
+    """Returns a dict of source path (without extension) to the features that compile it.
+
+    Features are named after the variable of the innermost conditional around the source, AUDIO_ENABLE becomes audio.
+    """
+    sources = {}
+
+    for makefile in makefiles:
+        if not os.path.exists(makefile):
+            continue
+
+        conditions = []
+        for line in read_makefile_lines(makefile):
+            branch = IF_RE.match(line)
+            source = SOURCE_RE.match(line)
+
+            if branch:
+                condition = CONDITION_RE.search(line).group(1)
+                if branch.group(1) and conditions:
+                    conditions[-1] = condition
+                else:
+                    conditions.append(condition)
+            elif re.match(r'^\s*endif\b', line):
+                conditions = conditions[:-1]
+            elif source and conditions:
+                # Platform checks and the like inside a feature's block still belong to the feature
+                names = [name for name in conditions if name.isupper()]
+                enables = [name for name in names if name.endswith('_ENABLE')]
+                if not names:
+                    continue
+                feature = re.sub(r'_ENABLE$', '', (enables or names)[-1]).lower()
+                for path in source.group(1).split():
+                    for variable, directory in DIRECTORY_VARIABLES.items():
+                        path = path.replace(variable, directory)
+                    if '$' not in path:
+                        sources.setdefault(os.path.splitext(path)[0], []).append(feature)
+
+    return sources
+
+
+def object_source(path):
+    """Returns the source path, without extension, that an object in the map was built from, or None for toolchain objects.
+    """
+    parts = path.replace('\\', '/').split('/')
+
+    for i, part in enumerate(parts):
+        if part.startswith('obj_'):
+            return os.path.splitext('/'.join(parts[i + 1:]))[0]
+
+    return None
+
+
+def parse_map(map_file):
+    """Returns the input sections in a linker map's memory map as a list of dicts with kind, size, object, source and symbol.
+    """
+    sections = []
+    output = None
+    pending = None
+    last = None
+    in_memory_map = False
+
+    with open(map_file, errors='replace') as fd:
+        for line in fd:
+            line = line.rstrip('\n')
+
+            if not in_memory_map:
+                in_memory_map = line.startswith('Linker script and memory map')
+                continue
+
+            match = OUTPUT_SECTION_RE.match(line)
+            if match:
+                output = memory_kind(match.group(1))
+                pending = None
+                continue
+
+            if pending:
+                match = CONTINUATION_RE.match(line)
+                if match:
+                    last = add_section(sections, output, pending, int(match.group(1), 16), match.group(2))
+                pending = None
+                continue
+
+            match = INPUT_SECTION_RE.match(line)
+            if match:
+                last = None
+                if match.group(2):
+                    last = add_section(sections, output, match.group(1), int(match.group(2), 16), match.group(3))
+                else:
+                    pending = match.group(1)
+                continue
+
+            # A section without a symbol in its name takes the first symbol the map lists in it
+            match = SYMBOL_RE.match(line)
+            if match and last and not last['symbol']:
+                last['symbol'] = match.group(1)
+
+    return sections
+
+
+def add_section(sections, kind, name, size, object_path):
+    """Records an input section that takes up space in the image and returns it, or returns None.
+    """
+    if not kind or not size or object_path.startswith('load address'):
+        return None
+
+    symbol = SECTION_SYMBOL_RE.match(name)
+    section = {
+        'kind': kind,
+        'size': size,
+        'object': object_path.strip(),
+        'source': object_source(object_path.strip()),
+        'symbol': symbol.group(1) if symbol else None,
+    }
+    sections.append(section)
+    return section
+
+
+def source_bucket(source, features, linked):
+    """Returns the feature or part of the tree a source file belongs to.
+
+    Args:
+        source
+            The source path without extension, or None for toolchain objects.
+
+        features
+            The result of feature_sources().
+
+        linked
+            Every source in the image, to pick between features that share a file.
+    """
+    if source is None:
+        return 'toolchain'
+
+    candidates = features.get(source) or features.get(os.path.basename(source))
+    if candidates:
+        # Shared files like color.c belong to whichever of their features has the most other files linked in
+        def linked_files(feature):
+            return sum(1 for path, names in features.items() if feature in names and (path in linked or os.path.basename(path) in linked))
+
+        return max(candidates, key=linked_files)
+
+    parts = source.split('/')
+    if source.startswith('quantum/process_keycode/'):
+        return 'process_keycode/' + parts[-1]
+    if parts[0] == 'keyboards':
+        return 'keymap' if 'keymaps' in parts else 'keyboard'
+    if parts[0] == 'users':
+        return 'userspace'
+    if source.startswith('tmk_core/protocol'):
+        return 'protocol'
+    if parts[0] == 'lib' and len(parts) > 1:
+        return parts[1]
+    if parts[0] in ('tmk_core', 'quantum', 'drivers'):
+        return parts[0]
+
+    return 'other'
+
+
+def summarize(sections, features):
+    """Returns the totals per feature and per symbol of the parsed sections.
+    """
+    linked = set()
+    for section in sections:
+        if section['source']:
+            linked.add(section['source'])
+            linked.add(os.path.basename(section['source']))
+
+    report = {'flash': 0, 'ram': 0, 'features': {}, 'symbols': {}}
+    buckets = {}
+
+    for section in sections:
+        flash = section['size'] if section['kind'] in ('flash', 'data') else 0
+        ram = section['size'] if section['kind'] in ('ram', 'data') else 0
+        if section['source'] not in buckets:
+            buckets[section['source']] = source_bucket(section['source'], features, linked)
+        bucket = buckets[section['source']]
+        symbol = section['symbol'] or '(%s)' % os.path.basename(section['object'])
+
+        report['flash'] += flash
+        report['ram'] += ram
+
+        for table, key in ((report['features'], bucket), (report['symbols'], symbol)):
+            entry = table.setdefault(key, {'flash': 0, 'ram': 0})
+            entry['flash'] += flash
+            entry['ram'] += ram
+
+        report['symbols'][symbol].setdefault('feature', bucket)
+
+    return report
+
+
+def diff(report, baseline):
+    """Returns how each feature and symbol changed since the baseline, leaving out the ones that did not.
+    """
+    changes = {'flash': report['flash'] - baseline['flash'], 'ram': report['ram'] - baseline['ram'], 'features': {}, 'symbols': {}}
+
+    for table in ('features', 'symbols'):
+        for key in set(report[table]) | set(baseline[table]):
+            now = report[table].get(key, {'flash': 0, 'ram': 0})
+            before = baseline[table].get(key, {'flash': 0, 'ram': 0})
+            change = {'flash': now['flash'] - before['flash'], 'ram': now['ram'] - before['ram']}
+            if change['flash'] or change['ram']:
+                changes[table][key] = change
+
+    return changes
+
+
+def largest(table, count, kind='flash'):
+    """Returns the `count` largest entries of a feature or symbol table as (name, entry) pairs.
+    """
+    return sorted(table.items(), key=lambda item: (-abs(item[1][kind]), item[0]))[:count]
@@ -14,6 +14,16 @@ def test_compile():
     assert check_subcommand('compile', '-kb', 'handwired/onekey/pytest', '-km', 'default').returncode == 0
 
 
+def test_multibuild():
+    result = check_subcommand('multibuild', '-kb', 'handwired/onekey/pytest', '-f')
+    assert result.returncode == 0
+    assert '1 built, 0 skipped' in result.stderr
+
+    result = check_subcommand('multibuild', '-kb', 'handwired/onekey/pytest')
+    assert result.returncode == 0
+    assert '0 built, 1 skipped' in result.stderr
+
+
 def test_flash():
     assert check_subcommand('flash', '-b').returncode == 1
     assert check_subcommand('flash').returncode == 1
@@ -0,0 +1,31 @@
+import os
+
+import qmk.keyboard_index
+
+
+def test_parse_keyboard_onekey_pytest():
+    info = qmk.keyboard_index.parse_keyboard('handwired/onekey/pytest')
+    assert info['matrix_size'] == {'rows': 1, 'cols': 1}
+    assert 'LAYOUT' in info['layouts']
+    assert 'keyboards/handwired/onekey/rules.mk' in info['files']
+    assert info['default_folder'] is None
+
+
+def test_update_index():
+    index = qmk.keyboard_index.update_index()
+    assert 'handwired/onekey/pytest' in index['keyboards']
+    assert not any('keymaps' in keyboard for keyboard in index['keyboards'])
+    assert os.path.exists(qmk.keyboard_index.INDEX_FILE)
+
+
+def test_update_index_reparses_changed_keyboard():
+    qmk.keyboard_index.update_index()
+    rules_mk = 'keyboards/handwired/onekey/pytest/rules.mk'
+    mtime = os.stat(rules_mk).st_mtime
+    os.utime(rules_mk, (mtime + 1, mtime + 1))
+
+    try:
+        index = qmk.keyboard_index.update_index()
+        assert index['keyboards']['handwired/onekey/pytest']['files'][rules_mk] == mtime + 1
+    finally:
+        os.utime(rules_mk, (mtime, mtime))
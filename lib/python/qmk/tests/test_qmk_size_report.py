@@ -0,0 +1,51 @@
+import os
+
+import qmk.size_report
+
+MAP_FILE = os.path.join(os.path.dirname(__file__), 'size_report.map')
+
+
+def summary():
+    return qmk.size_report.summarize(qmk.size_report.parse_map(MAP_FILE), qmk.size_report.feature_sources())
+
+
+def test_parse_map_skips_discarded_sections():
+    symbols = [section['symbol'] for section in qmk.size_report.parse_map(MAP_FILE)]
+    assert 'unused_function' not in symbols
+    assert 'ascii_to_keycode_lut' in symbols
+    assert 'big_common_buffer' in symbols
+    assert '__vectors' in symbols
+
+
+def test_summarize_totals():
+    report = summary()
+    # .text plus the .data load image, .data plus .bss
+    assert report['flash'] == 0xac + 0x80 + 0x180 + 0x20 + 0x120 + 0x200 + 0x90 + 0x60 + 0x30 + 0x50 + 0x1c + 0x10
+    assert report['ram'] == 0x10 + 0x20 + 0x60 + 0xa0
+
+
+def test_summarize_features():
+    report = summary()
+    assert report['features']['combo']['flash'] == 0x120
+    # color.c is shared with rgb_matrix, but only rgblight is linked in
+    assert report['features']['rgblight'] == {'flash': 0x90 + 0x10 + 0x60, 'ram': 0x10 + 0x60}
+    assert report['symbols']['hsv_to_rgb']['feature'] == 'rgblight'
+    assert report['features']['process_keycode/process_grave_esc']['flash'] == 0x30
+    assert report['features']['keymap']['flash'] == 0x1a0
+    assert report['features']['keyboard']['flash'] == 0x50
+    assert report['features']['protocol']['ram'] == 0x20
+    assert report['features']['toolchain']['flash'] == 0xac + 0x1c
+
+
+def test_diff_against_baseline():
+    report = summary()
+    baseline = summary()
+    baseline['flash'] -= 0x20
+    baseline['features']['keymap']['flash'] -= 0x20
+    del baseline['symbols']['key_combos']
+
+    changes = qmk.size_report.diff(report, baseline)
+    assert changes['flash'] == 0x20
+    assert changes['features'] == {'keymap': {'flash': 0x20, 'ram': 0}}
+    assert changes['symbols'] == {'key_combos': {'flash': 0x20, 'ram': 0}}
+    assert qmk.size_report.largest(report['symbols'], 1)[0][0] == 'process_record_quantum'
@@ -0,0 +1,26 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "animation_clock.h"
+#include "timer.h"
+
+static uint32_t clock_offset = 0;
+
+uint32_t animation_clock_read(void) { return timer_read32() + clock_offset; }
+
+uint32_t animation_clock_elapsed(uint32_t last) { return animation_clock_read() - last; }
+
+void animation_clock_sync(uint32_t time) { clock_offset = time - timer_read32(); }
@@ -0,0 +1,33 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Millisecond clock for the lighting animations.
+ *
+ * rgblight, rgb_matrix and led_matrix compute their frames from this clock
+ * rather than counting task calls, so a slow scan loop drops frames instead
+ * of slowing the animation down or racing to catch up afterwards. Split
+ * keyboards set the slave's clock to the master's, which makes both halves
+ * render the same frame.
+ */
+uint32_t animation_clock_read(void);
+uint32_t animation_clock_elapsed(uint32_t last);
+
+/* Make animation_clock_read() return time from now on. */
+void animation_clock_sync(uint32_t time);
@@ -0,0 +1,410 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio_synth.h"
+#include "musical_notes.h"
+
+// these are shared with voices.c
+uint16_t envelope_index = 0;
+float    note_timbre    = TIMBRE_DEFAULT;
+float    polyphony_rate = 0;
+bool     glissando      = true;
+
+float voice_envelope(float frequency);
+
+/* Pitches are in 1/256 semitone above MIDI note 0 (8.18 Hz). Scaling by a power
+ * of two is a table lookup plus a shift, so glissando and vibrato work on
+ * pitches and only the phase increment is derived from them.
+ */
+#define PITCH_SEMITONE 256
+#define PITCH_OCTAVE (12 * PITCH_SEMITONE)
+#define PITCH_A4 (69 * PITCH_SEMITONE)
+#define PITCH_MAX (11 * PITCH_OCTAVE - 1)
+#define PITCH_REST (-1)
+
+#define BASE_FREQUENCY 8.175798916f
+#define BASE_INCREMENT ((uint32_t)(8.175798916 * 4294967296.0 / AUDIO_DAC_SAMPLE_RATE + 0.5))
+#define HZ_PER_INCREMENT ((float)AUDIO_DAC_SAMPLE_RATE / 4294967296.0f)
+#define INCREMENT_PER_HZ (4294967296.0f / (float)AUDIO_DAC_SAMPLE_RATE)
+
+// 2^(i/192) in Q15, one entry per 1/16 semitone of an octave
+static const uint16_t exp2_lut[192] = {
+    32768, 32887, 33005, 33125, 33245, 33365, 33486, 33607, 33728, 33850, 33973, 34095, 34219, 34343, 34467, 34591, 34716, 34842, 34968, 35095, 35221, 35349, 35477, 35605, 35734, 35863, 35993, 36123, 36254, 36385, 36516, 36648, 36781, 36914, 37047, 37181, 37316, 37451, 37586, 37722, 37859, 37996, 38133, 38271, 38409, 38548, 38688, 38828,
+    38968, 39109, 39250, 39392, 39535, 39678, 39821, 39965, 40110, 40255, 40400, 40547, 40693, 40840, 40988, 41136, 41285, 41434, 41584, 41735, 41886, 42037, 42189, 42342, 42495, 42649, 42803, 42958, 43113, 43269, 43425, 43582, 43740, 43898, 44057, 44216, 44376, 44537, 44698, 44859, 45022, 45185, 45348, 45512, 45677, 45842, 46008, 46174,
+    46341, 46509, 46677, 46846, 47015, 47185, 47356, 47527, 47699, 47871, 48044, 48218, 48393, 48568, 48743, 48920, 49097, 49274, 49452, 49631, 49811, 49991, 50172, 50353, 50535, 50718, 50901, 51085, 51270, 51456, 51642, 51829, 52016, 52204, 52393, 52582, 52773, 52963, 53155, 53347, 53540, 53734, 53928, 54123, 54319, 54515, 54713, 54910,
+    55109, 55308, 55508, 55709, 55911, 56113, 56316, 56519, 56724, 56929, 57135, 57341, 57549, 57757, 57966, 58176, 58386, 58597, 58809, 59022, 59235, 59449, 59664, 59880, 60097, 60314, 60532, 60751, 60971, 61191, 61413, 61635, 61858, 62081, 62306, 62531, 62757, 62984, 63212, 63441, 63670, 63901, 64132, 64364, 64596, 64830, 65065, 65300,
+};
+
+// Glissando step per tick for each semitone, 220 / f semitones like the float driver
+static const uint16_t glide_lut[128] = {
+    6889, 6502, 6137, 5793, 5468, 5161, 4871, 4598, 4340, 4096, 3866, 3649, 3444, 3251, 3069, 2896, 2734, 2580, 2435, 2299, 2170, 2048, 1933, 1825, 1722, 1625, 1534, 1448, 1367, 1290, 1218, 1149, 1085, 1024, 967, 912, 861, 813, 767, 724, 683, 645, 609, 575, 542, 512, 483, 456, 431, 406, 384, 362, 342, 323, 304, 287, 271, 256, 242, 228, 215, 203, 192, 181,
+    171, 161, 152, 144, 136, 128, 121, 114, 108, 102, 96, 91, 85, 81, 76, 72, 68, 64, 60, 57, 54, 51, 48, 45, 43, 40, 38, 36, 34, 32, 30, 29, 27, 25, 24, 23, 21, 20, 19, 18, 17, 16, 15, 14, 13, 13, 12, 11, 11, 10, 10, 9, 8, 8, 8, 7, 7, 6, 6, 6, 5, 5, 5, 4,
+};
+
+#ifdef VIBRATO_ENABLE
+#    define VIBRATO_LENGTH 20
+// log2 of vibrato_lut[] in pitch steps
+static const int8_t vibrato_offsets[VIBRATO_LENGTH] = {10, 19, 26, 30, 32, 30, 26, 19, 10, 0, -10, -19, -26, -30, -32, -30, -26, -19, -10, 0};
+
+static uint32_t vibrato_counter  = 0;     // Q16 index into vibrato_offsets
+static uint32_t vibrato_rate     = 8192;  // Q16, 0.125
+static uint16_t vibrato_strength = 128;   // Q8, 0.5
+#endif
+
+typedef struct {
+    uint32_t phase;
+    uint32_t increment;
+    uint32_t duty;
+} synth_channel_t;
+
+static synth_channel_t channels[2];
+static bool            channel_2_inverted = true;
+
+static float    voice_frequencies[AUDIO_SYNTH_MAX_VOICES];
+static int32_t  voice_pitches[AUDIO_SYNTH_MAX_VOICES];
+static uint8_t  voice_count     = 0;
+static uint8_t  voice_place     = 0;
+static uint16_t polyphony_place = 0;
+static uint16_t polyphony_limit = 0;
+static int32_t  glide_pitch[2]  = {PITCH_REST, PITCH_REST};
+
+static bool playing_note  = false;
+static bool playing_notes = false;
+
+static float (*notes_pointer)[][2];
+static uint16_t notes_count;
+static bool     notes_repeat;
+static uint16_t current_note;
+static uint16_t note_position;
+static uint16_t note_ticks;
+static bool     note_resting;
+static int32_t  note_pitch = PITCH_REST;
+static uint8_t  note_tempo = TEMPO_DEFAULT;
+
+/* value * 2^(pitch / PITCH_OCTAVE) */
+static uint32_t pitch_scale(uint32_t value, int32_t pitch) {
+    int32_t  octave   = pitch >= 0 ? pitch / PITCH_OCTAVE : -((PITCH_OCTAVE - 1 - pitch) / PITCH_OCTAVE);
+    uint16_t fraction = pitch - octave * PITCH_OCTAVE;
+    uint8_t  index    = fraction >> 4;
+    uint32_t low      = exp2_lut[index];
+    uint32_t high     = index < 191 ? exp2_lut[index + 1] : 65536;
+    uint64_t scaled   = ((uint64_t)value * (low + (((high - low) * (fraction & 15)) >> 4))) >> 15;
+
+    scaled = octave >= 0 ? scaled << octave : scaled >> -octave;
+    return scaled > UINT32_MAX ? UINT32_MAX : scaled;
+}
+
+static uint32_t pitch_increment(int32_t pitch) { return pitch == PITCH_REST ? 0 : pitch_scale(BASE_INCREMENT, pitch); }
+
+/* Called once per note, never per tick. */
+static int32_t frequency_to_pitch(float freq) {
+    if (!(freq >= AUDIO_SYNTH_MIN_FREQUENCY)) {
+        return PITCH_REST;
+    }
+
+    // freq relative to MIDI note 0 in Q16, so the octave is the top bit past 16
+    uint32_t ratio  = (uint32_t)(freq * (65536.0f / BASE_FREQUENCY));
+    int8_t   octave = 31 - __builtin_clz(ratio) - 16;
+    if (octave > 10) {
+        return PITCH_MAX;
+    }
+    uint16_t mantissa = ratio >> (octave + 1);
+
+    uint8_t low = 0, high = 191;
+    while (low < high) {
+        uint8_t mid = (low + high + 1) / 2;
+        if (exp2_lut[mid] <= mantissa) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    uint32_t step_low  = exp2_lut[low];
+    uint32_t step_high = low < 191 ? exp2_lut[low + 1] : 65536;
+
+    return octave * PITCH_OCTAVE + low * 16 + ((mantissa - step_low) << 4) / (step_high - step_low);
+}
+
+static uint16_t glide_step(int32_t pitch) {
+    int32_t note = pitch / PITCH_SEMITONE;
+    if (note >= 127) {
+        return glide_lut[127];
+    }
+    return glide_lut[note] - (((glide_lut[note] - glide_lut[note + 1]) * (pitch % PITCH_SEMITONE)) >> 8);
+}
+
+static int32_t synth_glide(uint8_t channel, int32_t target) {
+    int32_t pitch = glide_pitch[channel];
+
+    if (glissando && pitch != PITCH_REST) {
+        int32_t reach = glide_step(target);
+        if (pitch < target - reach) {
+            pitch += glide_step(pitch);
+        } else if (pitch > target + reach) {
+            pitch -= glide_step(pitch);
+        } else {
+            pitch = target;
+        }
+    } else {
+        pitch = target;
+    }
+
+    glide_pitch[channel] = pitch;
+    return pitch;
+}
+
+static int32_t synth_vibrato(int32_t pitch) {
+#ifdef VIBRATO_ENABLE
+    if (vibrato_strength == 0) {
+        return pitch;
+    }
+
+    int32_t offset = vibrato_offsets[vibrato_counter >> 16];
+#    ifdef VIBRATO_STRENGTH_ENABLE
+    offset = offset * vibrato_strength / 256;
+#    endif
+    // the counter runs faster for lower notes, rate * (1 + 440 / f)
+    vibrato_counter += vibrato_rate + pitch_scale(vibrato_rate, PITCH_A4 - pitch);
+    vibrato_counter %= (uint32_t)VIBRATO_LENGTH << 16;
+
+    pitch += offset;
+#endif
+    return pitch;
+}
+
+/* Point a channel at pitch, passing it through the current voice on the way. */
+static void synth_channel_set(uint8_t channel, int32_t pitch) {
+    synth_channel_t *c         = &channels[channel];
+    uint32_t         increment = pitch_increment(pitch);
+
+    if (increment) {
+        if (envelope_index < 65535) {
+            envelope_index++;
+        }
+
+        // voices work on frequencies, this is the only float math left per tick
+        float freq   = increment * HZ_PER_INCREMENT;
+        float shaped = voice_envelope(freq);
+        if (shaped != freq) {
+            increment = shaped >= AUDIO_SYNTH_MIN_FREQUENCY ? (uint32_t)(shaped * INCREMENT_PER_HZ) : 0;
+        }
+    }
+
+    c->increment = increment;
+    c->duty      = note_timbre >= 1.0f ? UINT32_MAX : (uint32_t)(note_timbre * 4294967295.0f);
+}
+
+static void synth_silence(void) {
+    channels[0].increment = 0;
+    channels[1].increment = 0;
+    glide_pitch[0]        = PITCH_REST;
+    glide_pitch[1]        = PITCH_REST;
+}
+
+static void synth_load_note(void) {
+    float *note = (*notes_pointer)[current_note];
+
+    note_pitch    = frequency_to_pitch(note[0]);
+    note_ticks    = ((uint32_t)(note[1] * 2) * note_tempo + 99) / 100;
+    note_position = 0;
+}
+
+void audio_synth_reset(void) {
+    playing_note  = false;
+    playing_notes = false;
+    voice_count   = 0;
+    voice_place   = 0;
+    synth_silence();
+}
+
+void audio_synth_note_on(float freq) {
+    if (voice_count >= AUDIO_SYNTH_MAX_VOICES) {
+        return;
+    }
+    if (playing_notes) {
+        audio_synth_reset();
+    }
+
+    playing_note   = true;
+    envelope_index = 0;
+
+    int32_t pitch = frequency_to_pitch(freq);
+    if (pitch != PITCH_REST) {
+        voice_frequencies[voice_count] = freq;
+        voice_pitches[voice_count]     = pitch;
+        voice_count++;
+    }
+}
+
+void audio_synth_note_off(float freq) {
+    if (!playing_note) {
+        return;
+    }
+
+    for (int8_t i = voice_count - 1; i >= 0; i--) {
+        if (voice_frequencies[i] == freq) {
+            for (uint8_t j = i; j < voice_count - 1; j++) {
+                voice_frequencies[j] = voice_frequencies[j + 1];
+                voice_pitches[j]     = voice_pitches[j + 1];
+            }
+            voice_count--;
+            break;
+        }
+    }
+
+    if (voice_place >= voice_count) {
+        voice_place = 0;
+    }
+    if (voice_count == 0) {
+        playing_note = false;
+        synth_silence();
+    }
+}
+
+void audio_synth_song(float (*np)[][2], uint16_t n_count, bool n_repeat) {
+    if (playing_note) {
+        audio_synth_reset();
+    }
+    if (n_count == 0) {
+        return;
+    }
+
+    notes_pointer  = np;
+    notes_count    = n_count;
+    notes_repeat   = n_repeat;
+    current_note   = 0;
+    note_resting   = false;
+    envelope_index = 0;
+    synth_load_note();
+    playing_notes = true;
+}
+
+bool audio_synth_playing_note(void) { return playing_note; }
+
+bool audio_synth_playing_song(void) { return playing_notes; }
+
+uint8_t audio_synth_voices(void) { return voice_count; }
+
+uint32_t audio_synth_increment(uint8_t channel) { return channels[channel && !channel_2_inverted].increment; }
+
+void audio_synth_set_tempo(uint8_t tempo) { note_tempo = tempo; }
+
+void audio_synth_set_vibrato(float rate, float strength) {
+#ifdef VIBRATO_ENABLE
+    vibrato_rate     = rate > 0 ? (uint32_t)(rate * 65536.0f) : 0;
+    vibrato_strength = strength > 0 ? (uint16_t)(strength * 256.0f) : 0;
+#else
+    (void)rate;
+    (void)strength;
+#endif
+}
+
+static void synth_voices_tick(void) {
+    bool    polyphony = polyphony_rate > 0;
+    int32_t pitch;
+
+    if (voice_count > 1 && !polyphony) {
+        // the second newest voice gets its own output
+        synth_channel_set(1, synth_vibrato(synth_glide(1, voice_pitches[voice_count - 2])));
+        channel_2_inverted = false;
+    } else {
+        channel_2_inverted = true;
+    }
+
+    if (polyphony) {
+        if (voice_count > 1 && polyphony_place++ > polyphony_limit) {
+            voice_place     = (voice_place + 1) % voice_count;
+            polyphony_place = 0;
+            // once per voice switch, not per tick
+            polyphony_limit = voice_frequencies[voice_place] / polyphony_rate;
+        }
+        voice_place %= voice_count;
+        pitch = voice_pitches[voice_place];
+    } else {
+        pitch = synth_glide(0, voice_pitches[voice_count - 1]);
+    }
+
+    synth_channel_set(0, synth_vibrato(pitch));
+}
+
+static void synth_song_tick(void) {
+    channel_2_inverted = true;
+    synth_channel_set(0, note_pitch == PITCH_REST ? PITCH_REST : synth_vibrato(note_pitch));
+
+    note_position++;
+    if (note_position + !note_resting < note_ticks) {
+        return;
+    }
+
+    uint16_t next_note = current_note + 1;
+    if (next_note >= notes_count) {
+        if (!notes_repeat) {
+            playing_notes = false;
+            synth_silence();
+            return;
+        }
+        next_note = 0;
+    }
+
+    if (!note_resting) {
+        // a short gap after every note, silent only when the next note repeats this one
+        note_resting = true;
+        if ((*notes_pointer)[current_note][0] == (*notes_pointer)[next_note][0]) {
+            note_pitch = PITCH_REST;
+        }
+        note_ticks    = 8;
+        note_position = 0;
+    } else {
+        note_resting   = false;
+        envelope_index = 0;
+        current_note   = next_note;
+        synth_load_note();
+    }
+}
+
+void audio_synth_tick(void) {
+    if (playing_note && voice_count > 0) {
+        synth_voices_tick();
+    }
+    if (playing_notes) {
+        synth_song_tick();
+    }
+}
+
+void audio_synth_render(uint16_t *out1, uint16_t *out2, size_t n, uint16_t high) {
+    uint32_t phase_1 = channels[0].phase, increment_1 = channels[0].increment, duty_1 = channels[0].duty;
+
+    if (channel_2_inverted) {
+        uint16_t low = increment_1 ? high : 0;
+        for (size_t i = 0; i < n; i++) {
+            bool on = increment_1 && phase_1 < duty_1;
+            out1[i] = on ? high : 0;
+            out2[i] = on ? 0 : low;
+            phase_1 += increment_1;
+        }
+    } else {
+        uint32_t phase_2 = channels[1].phase, increment_2 = channels[1].increment, duty_2 = channels[1].duty;
+        for (size_t i = 0; i < n; i++) {
+            out1[i] = increment_1 && phase_1 < duty_1 ? high : 0;
+            out2[i] = increment_2 && phase_2 < duty_2 ? high : 0;
+            phase_1 += increment_1;
+            phase_2 += increment_2;
+        }
+        channels[1].phase = phase_2;
+    }
+
+    channels[0].phase = phase_1;
+}
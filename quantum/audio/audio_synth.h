@@ -0,0 +1,69 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Fixed-point square wave synthesizer behind the ARM DAC audio driver.
+ *
+ * The DAC runs at a fixed sample rate and is fed by circular DMA. Each half
+ * buffer calls audio_synth_tick() once to advance songs, glissando, vibrato
+ * and voice envelopes, then audio_synth_render() to fill the samples from two
+ * phase accumulators. Pitches are kept in 1/256 semitone steps, so glissando
+ * and vibrato are additions and only need small lookup tables.
+ *
+ * This file has no hardware dependencies and also builds on the host, see
+ * util/audio_render.c.
+ */
+
+#ifndef AUDIO_DAC_SAMPLE_RATE
+#    define AUDIO_DAC_SAMPLE_RATE 32000U
+#endif
+
+// Samples per control tick. 128 samples at 32 kHz is a 250 Hz tick, which keeps
+// note lengths within a few percent of the AVR driver.
+#ifndef AUDIO_SYNTH_TICK_SAMPLES
+#    define AUDIO_SYNTH_TICK_SAMPLES 128U
+#endif
+
+#define AUDIO_SYNTH_MAX_VOICES 8
+
+// Frequencies below this are treated as rests.
+#define AUDIO_SYNTH_MIN_FREQUENCY 30.0f
+
+void audio_synth_reset(void);
+
+void     audio_synth_note_on(float freq);
+void     audio_synth_note_off(float freq);
+void     audio_synth_song(float (*np)[][2], uint16_t n_count, bool n_repeat);
+bool     audio_synth_playing_note(void);
+bool     audio_synth_playing_song(void);
+uint8_t  audio_synth_voices(void);
+uint32_t audio_synth_increment(uint8_t channel);
+
+void audio_synth_set_tempo(uint8_t tempo);
+void audio_synth_set_vibrato(float rate, float strength);
+
+/* Advance songs and effects by one control tick. */
+void audio_synth_tick(void);
+
+/* Fill n samples of both outputs. A silent channel renders 0, a sounding one
+ * alternates between 0 and high. With a single voice the second output plays
+ * it inverted, so a speaker across both pins sees twice the swing.
+ */
+void audio_synth_render(uint16_t *out1, uint16_t *out2, size_t n, uint16_t high);
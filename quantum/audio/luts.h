@@ -19,8 +19,7 @@
 #    include <avr/interrupt.h>
 #    include <avr/pgmspace.h>
 #else
-#    include "ch.h"
-#    include "hal.h"
+#    include <stdint.h>
 #endif
 
 #ifndef LUTS_H
@@ -52,6 +52,10 @@ void    backlight_set(uint8_t level);
 void    backlight_level(uint8_t level);
 uint8_t get_backlight_level(void);
 
+#ifdef BACKLIGHT_SOFT_TIMER
+void backlight_pin_level_set(uint8_t index, uint8_t level);
+#endif
+
 #ifdef BACKLIGHT_BREATHING
 void backlight_toggle_breathing(void);
 void backlight_enable_breathing(void);
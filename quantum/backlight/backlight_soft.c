@@ -5,8 +5,8 @@
 #    error "Backlight pin/pins not defined. Please configure."
 #endif
 
-#ifdef BACKLIGHT_BREATHING
-#    error "Backlight breathing is not available for software PWM. Please disable."
+#if defined(BACKLIGHT_BREATHING) && !defined(BACKLIGHT_SOFT_TIMER)
+#    error "Backlight breathing is only available for software PWM with BACKLIGHT_SOFT_TIMER. Please disable."
 #endif
 
 #ifndef BACKLIGHT_ON_STATE
@@ -45,6 +45,8 @@ void backlight_off(pin_t backlight_pin) {
 #endif
 }
 
+#ifndef BACKLIGHT_SOFT_TIMER
+
 void backlight_init_ports(void) {
     // Setup backlight pin as output and output to on state.
     FOR_EACH_LED(setPinOutput(backlight_pin); backlight_on(backlight_pin);)
@@ -64,3 +66,328 @@ void backlight_task(void) {
 void backlight_set(uint8_t level) {
     // noop as backlight_task uses get_backlight_level()
 }
+
+#else  // BACKLIGHT_SOFT_TIMER
+
+// Binary code modulation driven by a hardware timer.
+//
+// Every frame is split into 8 bit planes, plane n lasts 2^n ticks and has
+// all the pins with bit n of their level turned on. The pin states of each
+// plane are precomputed as one mask per port whenever a level changes, so
+// the interrupt only does a single write per port and the matrix scan does
+// not spend any time on the backlight unless it is breathing.
+
+#    define BCM_PLANES 8
+
+#    if defined(__AVR__)
+#        ifndef BACKLIGHT_BCM_TICK
+#            define BACKLIGHT_BCM_TICK (F_CPU / 125000UL)  // timer clocks per tick, 8us
+#        endif
+#        if (BACKLIGHT_BCM_TICK << (BCM_PLANES - 1)) > 0xFFFFUL
+#            error "BACKLIGHT_BCM_TICK is too large for a 16 bit timer"
+#        endif
+
+#        if !defined(B5_AUDIO) && !defined(B6_AUDIO) && !defined(B7_AUDIO)
+#            define TCCRxA TCCR1A
+#            define TCCRxB TCCR1B
+#            define OCRxA OCR1A
+#            define TIMERx_COMPA_vect TIMER1_COMPA_vect
+#            if defined(__AVR_ATmega32A__)  // This MCU has only one TIMSK register
+#                define TIMSKx TIMSK
+#            else
+#                define TIMSKx TIMSK1
+#            endif
+#            define OCIExA OCIE1A
+#            define WGMx2 WGM12
+#            define CSx0 CS10
+#        elif !defined(C6_AUDIO) && !defined(C5_AUDIO) && !defined(C4_AUDIO)
+#            define TCCRxA TCCR3A
+#            define TCCRxB TCCR3B
+#            define OCRxA OCR3A
+#            define TIMERx_COMPA_vect TIMER3_COMPA_vect
+#            define TIMSKx TIMSK3
+#            define OCIExA OCIE3A
+#            define WGMx2 WGM32
+#            define CSx0 CS30
+#        else
+#            error "Both 16 bit timers are used by Audio, BACKLIGHT_SOFT_TIMER is not available."
+#        endif
+
+typedef volatile uint8_t *bcm_port_t;
+typedef uint8_t           bcm_mask_t;
+
+#        define BCM_PORT(pin) (&PORTx_ADDRESS(pin))
+#        define BCM_MASK(pin) _BV((pin)&0xF)
+#        if BACKLIGHT_ON_STATE == 0
+#            define bcm_write(port, mask, on) (*(port) = (*(port) | (mask)) & ~(on))
+#        else
+#            define bcm_write(port, mask, on) (*(port) = (*(port) & ~(mask)) | (on))
+#        endif
+#    elif defined(PROTOCOL_CHIBIOS)
+#        ifndef BACKLIGHT_BCM_TICK
+#            define BACKLIGHT_BCM_TICK 4  // 1MHz timer clocks per tick, 4us
+#        endif
+#        ifndef BACKLIGHT_GPT_DRIVER
+#            define BACKLIGHT_GPT_DRIVER GPTD3
+#        endif
+
+typedef ioportid_t   bcm_port_t;
+typedef ioportmask_t bcm_mask_t;
+
+#        define BCM_PORT(pin) PAL_PORT(pin)
+#        define BCM_MASK(pin) PAL_PORT_BIT(PAL_PAD(pin))
+#        if BACKLIGHT_ON_STATE == 0
+#            define bcm_write(port, mask, on)        \
+                do {                                 \
+                    palClearPort(port, on);          \
+                    palSetPort(port, (mask) & ~(on)); \
+                } while (0)
+#        else
+#            define bcm_write(port, mask, on)          \
+                do {                                   \
+                    palSetPort(port, on);              \
+                    palClearPort(port, (mask) & ~(on)); \
+                } while (0)
+#        endif
+#    else
+#        error "BACKLIGHT_SOFT_TIMER is not supported on this platform."
+#    endif
+
+static bcm_port_t bcm_ports[BACKLIGHT_LED_COUNT];
+static bcm_mask_t bcm_port_masks[BACKLIGHT_LED_COUNT];
+static uint8_t    bcm_port_count = 0;
+static uint8_t    bcm_pin_port[BACKLIGHT_LED_COUNT];
+
+// double buffered so a level change never shows a half built frame
+static bcm_mask_t       bcm_planes[2][BCM_PLANES][BACKLIGHT_LED_COUNT];
+static volatile uint8_t bcm_front = 0;
+static uint8_t          bcm_plane = 0;
+
+static uint8_t backlight_pin_levels[BACKLIGHT_LED_COUNT];
+
+// See http://jared.geek.nz/2013/feb/linear-led-pwm
+static uint16_t cie_lightness(uint16_t v) {
+    if (v <= 5243)     // if below 8% of max
+        return v / 9;  // same as dividing by 900%
+    else {
+        uint32_t y = (((uint32_t)v + 10486) << 8) / (10486 + 0xFFFFUL);  // add 16% of max and compare
+        // to get a useful result with integer division, we shift left in the expression above
+        // and revert what we've done again after squaring.
+        y = y * y * y >> 8;
+        if (y > 0xFFFFUL)  // prevent overflow
+            return 0xFFFFU;
+        else
+            return (uint16_t)y;
+    }
+}
+
+static void bcm_update(void) {
+    uint8_t back = bcm_front ^ 1;
+
+    for (uint8_t plane = 0; plane < BCM_PLANES; plane++) {
+        for (uint8_t port = 0; port < bcm_port_count; port++) {
+            bcm_planes[back][plane][port] = 0;
+        }
+        FOR_EACH_LED(if (backlight_pin_levels[i] & (1 << plane)) { bcm_planes[back][plane][bcm_pin_port[i]] |= BCM_MASK(backlight_pin); })
+    }
+    bcm_front = back;
+}
+
+// Called from the timer interrupt at the start of every plane, returns the plane length in ticks
+static inline uint16_t bcm_output(void) {
+    bcm_mask_t *on = bcm_planes[bcm_front][bcm_plane];
+
+    for (uint8_t port = 0; port < bcm_port_count; port++) {
+        bcm_write(bcm_ports[port], bcm_port_masks[port], on[port]);
+    }
+    uint16_t ticks = BACKLIGHT_BCM_TICK << bcm_plane;
+    bcm_plane      = (bcm_plane + 1) % BCM_PLANES;
+    return ticks;
+}
+
+#    if defined(__AVR__)
+ISR(TIMERx_COMPA_vect) { OCRxA = bcm_output() - 1; }
+
+static void bcm_timer_init(void) {
+    // CTC mode, TOP = OCRxA, clk/1
+    TCCRxA = 0;
+    TCCRxB = _BV(WGMx2) | _BV(CSx0);
+    OCRxA  = BACKLIGHT_BCM_TICK - 1;
+    TIMSKx |= _BV(OCIExA);
+}
+#    else
+static void bcm_gpt_cb(GPTDriver *gptp) { gptChangeIntervalI(gptp, bcm_output()); }
+
+static const GPTConfig bcm_gpt_cfg = {.frequency = 1000000U, .callback = bcm_gpt_cb, .cr2 = 0U, .dier = 0U};
+
+static void bcm_timer_init(void) {
+    gptStart(&BACKLIGHT_GPT_DRIVER, &bcm_gpt_cfg);
+    gptStartContinuous(&BACKLIGHT_GPT_DRIVER, BACKLIGHT_BCM_TICK);
+}
+#    endif
+
+/** \brief Set the raw duty cycle (0-255) of a single backlight pin
+ *
+ * Useful to give for instance the Caps Lock LED its own brightness. It is overwritten by the next backlight_set().
+ */
+void backlight_pin_level_set(uint8_t index, uint8_t level) {
+    if (index >= BACKLIGHT_LED_COUNT) return;
+    backlight_pin_levels[index] = level;
+    bcm_update();
+}
+
+static void backlight_set_all(uint8_t duty) {
+    for (uint8_t i = 0; i < BACKLIGHT_LED_COUNT; i++) {
+        backlight_pin_levels[i] = duty;
+    }
+    bcm_update();
+}
+
+void backlight_init_ports(void) {
+    // Setup backlight pin as output and group the pins by port.
+    for (uint8_t i = 0; i < BACKLIGHT_LED_COUNT; i++) {
+        pin_t   backlight_pin = backlight_pins[i];
+        uint8_t port          = 0;
+
+        setPinOutput(backlight_pin);
+        backlight_off(backlight_pin);
+        while (port < bcm_port_count && bcm_ports[port] != BCM_PORT(backlight_pin)) {
+            port++;
+        }
+        if (port == bcm_port_count) {
+            bcm_ports[port]      = BCM_PORT(backlight_pin);
+            bcm_port_masks[port] = 0;
+            bcm_port_count++;
+        }
+        bcm_port_masks[port] |= BCM_MASK(backlight_pin);
+        bcm_pin_port[i] = port;
+    }
+
+    bcm_timer_init();
+
+    backlight_init();
+#    ifdef BACKLIGHT_BREATHING
+    if (is_backlight_breathing()) {
+        breathing_enable();
+    }
+#    endif
+}
+
+void backlight_set(uint8_t level) {
+    if (level > BACKLIGHT_LEVELS) level = BACKLIGHT_LEVELS;
+
+    backlight_set_all(cie_lightness(0xFFFFU * (uint32_t)level / BACKLIGHT_LEVELS) >> 8);
+}
+
+#    ifdef BACKLIGHT_BREATHING
+
+#        define BREATHING_NO_HALT 0
+#        define BREATHING_HALT_OFF 1
+#        define BREATHING_HALT_ON 2
+#        define BREATHING_STEPS 128
+
+static uint8_t  breathing_period  = BREATHING_PERIOD;
+static uint8_t  breathing_halt    = BREATHING_NO_HALT;
+static uint32_t breathing_counter = 0;  // ms into the current period
+static uint16_t breathing_timer   = 0;
+static uint8_t  breathing_index   = BREATHING_STEPS;
+static bool     breathing         = false;
+
+bool is_breathing(void) { return breathing; }
+
+static inline void breathing_min(void) { breathing_counter = 0; }
+
+static inline void breathing_max(void) { breathing_counter = breathing_period * 1000UL / 2; }
+
+static inline void breathing_interrupt_enable(void) {
+    breathing_timer = timer_read();
+    breathing_index = BREATHING_STEPS;
+    breathing       = true;
+}
+
+static inline void breathing_interrupt_disable(void) { breathing = false; }
+
+void breathing_enable(void) {
+    breathing_counter = 0;
+    breathing_halt    = BREATHING_NO_HALT;
+    breathing_interrupt_enable();
+}
+
+void breathing_pulse(void) {
+    if (get_backlight_level() == 0)
+        breathing_min();
+    else
+        breathing_max();
+    breathing_halt = BREATHING_HALT_ON;
+    breathing_interrupt_enable();
+}
+
+void breathing_disable(void) {
+    breathing_interrupt_disable();
+    // Restore backlight level
+    backlight_set(get_backlight_level());
+}
+
+void breathing_self_disable(void) {
+    if (get_backlight_level() == 0)
+        breathing_halt = BREATHING_HALT_OFF;
+    else
+        breathing_halt = BREATHING_HALT_ON;
+}
+
+void breathing_toggle(void) {
+    if (is_breathing())
+        breathing_disable();
+    else
+        breathing_enable();
+}
+
+void breathing_period_set(uint8_t value) {
+    if (!value) value = 1;
+    breathing_period = value;
+}
+
+void breathing_period_default(void) { breathing_period_set(BREATHING_PERIOD); }
+
+void breathing_period_inc(void) { breathing_period_set(breathing_period + 1); }
+
+void breathing_period_dec(void) { breathing_period_set(breathing_period - 1); }
+
+/* To generate breathing curve in python:
+ * from math import sin, pi; [int(sin(x/128.0*pi)**4*255) for x in range(128)]
+ */
+static const uint8_t breathing_table[BREATHING_STEPS] PROGMEM = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 3, 4, 5, 6, 8, 10, 12, 15, 17, 20, 24, 28, 32, 36, 41, 46, 51, 57, 63, 70, 76, 83, 91, 98, 106, 113, 121, 129, 138, 146, 154, 162, 170, 178, 185, 193, 200, 207, 213, 220, 225, 231, 235, 240, 244, 247, 250, 252, 253, 254, 255, 254, 253, 252, 250, 247, 244, 240, 235, 231, 225, 220, 213, 207, 200, 193, 185, 178, 170, 162, 154, 146, 138, 129, 121, 113, 106, 98, 91, 83, 76, 70, 63, 57, 51, 46, 41, 36, 32, 28, 24, 20, 17, 15, 12, 10, 8, 6, 5, 4, 3, 2, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// Use this before the cie_lightness function.
+static inline uint16_t scale_backlight(uint16_t v) { return v / BACKLIGHT_LEVELS * get_backlight_level(); }
+
+// Follows the same curve as the AVR driver, timed by the system timer so it
+// only rebuilds the bit planes when the curve moves on to the next step.
+void breathing_task(void) {
+    uint32_t period = breathing_period * 1000UL;
+    uint16_t now    = timer_read();
+    // resetting after one period to prevent ugly reset at overflow.
+    breathing_counter = (breathing_counter + TIMER_DIFF_16(now, breathing_timer)) % period;
+    breathing_timer   = now;
+    uint8_t index     = breathing_counter * BREATHING_STEPS / period;
+    if (index == breathing_index) return;
+    breathing_index = index;
+
+    if (((breathing_halt == BREATHING_HALT_ON) && (index == BREATHING_STEPS / 2)) || ((breathing_halt == BREATHING_HALT_OFF) && (index == BREATHING_STEPS - 1))) {
+        breathing_interrupt_disable();
+    }
+
+    backlight_set_all(cie_lightness(scale_backlight((uint16_t)pgm_read_byte(&breathing_table[index]) * 0x0101U)) >> 8);
+}
+
+#    endif  // BACKLIGHT_BREATHING
+
+void backlight_task(void) {
+#    ifdef BACKLIGHT_BREATHING
+    if (is_breathing()) {
+        breathing_task();
+    }
+#    endif
+}
+
+#endif  // BACKLIGHT_SOFT_TIMER
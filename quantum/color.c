@@ -85,3 +85,57 @@ RGB hsv_to_rgb(HSV hsv) {
 
     return rgb;
 }
+
+/* Indexes into {v, t, p, q} for the red, green and blue channel of each hue
+ * region, two bits per channel. Region 6 only occurs for h == 255 and matches
+ * region 0, entry 7 is the grey used when saturation is 0.
+ */
+static const uint8_t hsv_region_order[8] PROGMEM = {
+    0 | 1 << 2 | 2 << 4,  // v, t, p
+    3 | 0 << 2 | 2 << 4,  // q, v, p
+    2 | 0 << 2 | 1 << 4,  // p, v, t
+    2 | 3 << 2 | 0 << 4,  // p, q, v
+    1 | 2 << 2 | 0 << 4,  // t, p, v
+    0 | 2 << 2 | 3 << 4,  // v, p, q
+    0 | 1 << 2 | 2 << 4,  // v, t, p
+    0 | 0 << 2 | 0 << 4,  // v, v, v
+};
+
+void hsv_to_rgb_batch(const HSV *hsv, LED_TYPE *led, uint16_t count, uint8_t max_val) {
+    for (; count > 0; count--, hsv++, led++) {
+        uint8_t h = hsv->h;
+        uint8_t s = hsv->s;
+        uint8_t v = hsv->v < max_val ? hsv->v : max_val;
+        uint8_t c[4];
+
+#ifdef USE_CIE1931_CURVE
+        v = pgm_read_byte(&CIE1931_CURVE[v]);
+#endif
+
+        // Same as h * 6 / 255 for every 8 bit hue
+        uint8_t region    = ((uint16_t)h * 193) >> 13;
+        uint8_t remainder = (h * 2 - region * 85) * 3;
+
+        c[0] = v;
+        c[2] = (v * (255 - s)) >> 8;
+#ifdef __AVR__
+        c[3] = (v * (255 - ((s * remainder) >> 8))) >> 8;
+        c[1] = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+#else
+        // q and t in the low and high half of one word. No product exceeds
+        // 16 bits, so two multiplies do the work of four.
+        uint32_t st = ((uint32_t)remainder | (uint32_t)(255 - remainder) << 16) * s;
+        uint32_t qt = (0x00FF00FFUL - ((st >> 8) & 0x00FF00FFUL)) * v;
+        c[3]        = qt >> 8;
+        c[1]        = qt >> 24;
+#endif
+
+        uint8_t order = pgm_read_byte(&hsv_region_order[s ? region : 7]);
+        led->r        = c[order & 3];
+        led->g        = c[(order >> 2) & 3];
+        led->b        = c[order >> 4];
+#ifdef RGBW
+        led->w = 0;
+#endif
+    }
+}
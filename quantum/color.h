@@ -65,4 +65,9 @@ typedef struct PACKED {
 
 RGB hsv_to_rgb(HSV hsv);
 
+/* Convert count colors into an LED buffer, limiting each value to max_val
+ * first. The result matches hsv_to_rgb() on the limited color.
+ */
+void hsv_to_rgb_batch(const HSV *hsv, LED_TYPE *led, uint16_t count, uint8_t max_val);
+
 #endif  // COLOR_H
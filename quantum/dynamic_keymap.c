@@ -20,9 +20,14 @@
 #include "progmem.h"  // to read default from flash
 #include "quantum.h"  // for send_string()
 #include "dynamic_keymap.h"
+#include <string.h>
 
 #ifdef DYNAMIC_KEYMAP_ENABLE
 
+#    ifndef MIN
+#        define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#    endif
+
 #    ifndef DYNAMIC_KEYMAP_EEPROM_ADDR
 #        error DYNAMIC_KEYMAP_EEPROM_ADDR not defined
 #    endif
@@ -78,32 +83,27 @@ void dynamic_keymap_reset(void) {
     }
 }
 
+// Copies the part of [offset, offset + size) that lies within a buffer of
+// buffer_size bytes at address, in one block, and zero fills the rest.
+static void dynamic_keymap_read_block(void *address, uint16_t buffer_size, uint16_t offset, uint16_t size, uint8_t *data) {
+    uint16_t valid = offset < buffer_size ? MIN(size, buffer_size - offset) : 0;
+    eeprom_read_block(data, address + offset, valid);
+    memset(data + valid, 0, size - valid);
+}
+
+static void dynamic_keymap_write_block(void *address, uint16_t buffer_size, uint16_t offset, uint16_t size, uint8_t *data) {
+    uint16_t valid = offset < buffer_size ? MIN(size, buffer_size - offset) : 0;
+    eeprom_update_block(data, address + offset, valid);
+}
+
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   source                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
-    uint8_t *target                     = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < dynamic_keymap_eeprom_size) {
-            *target = eeprom_read_byte(source);
-        } else {
-            *target = 0x00;
-        }
-        source++;
-        target++;
-    }
+    dynamic_keymap_read_block((void *)DYNAMIC_KEYMAP_EEPROM_ADDR, dynamic_keymap_eeprom_size, offset, size, data);
 }
 
 void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   target                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
-    uint8_t *source                     = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < dynamic_keymap_eeprom_size) {
-            eeprom_update_byte(target, *source);
-        }
-        source++;
-        target++;
-    }
+    dynamic_keymap_write_block((void *)DYNAMIC_KEYMAP_EEPROM_ADDR, dynamic_keymap_eeprom_size, offset, size, data);
 }
 
 // This overrides the one in quantum/keymap_common.c
@@ -119,31 +119,9 @@ uint8_t dynamic_keymap_macro_get_count(void) { return DYNAMIC_KEYMAP_MACRO_COUNT
 
 uint16_t dynamic_keymap_macro_get_buffer_size(void) { return DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE; }
 
-void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   source = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
-    uint8_t *target = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
-            *target = eeprom_read_byte(source);
-        } else {
-            *target = 0x00;
-        }
-        source++;
-        target++;
-    }
-}
+void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) { dynamic_keymap_read_block((void *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR, DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE, offset, size, data); }
 
-void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   target = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
-    uint8_t *source = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
-            eeprom_update_byte(target, *source);
-        }
-        source++;
-        target++;
-    }
-}
+void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) { dynamic_keymap_write_block((void *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR, DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE, offset, size, data); }
 
 void dynamic_keymap_macro_reset(void) {
     void *p   = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
@@ -0,0 +1,338 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "quantum.h"
+#include "dynamic_keymap.h"
+#include "dynamic_keymap_stream.h"
+#ifdef RAW_ENABLE
+#    include "raw_hid.h"
+#endif
+
+#ifdef DYNAMIC_KEYMAP_STREAM_ENABLE
+
+#    ifndef MIN
+#        define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#    endif
+
+#    if (DYNAMIC_KEYMAP_STREAM_WINDOW & (DYNAMIC_KEYMAP_STREAM_WINDOW - 1)) || DYNAMIC_KEYMAP_STREAM_WINDOW > 128
+#        error DYNAMIC_KEYMAP_STREAM_WINDOW must be a power of two no larger than 128
+#    endif
+
+#    define STREAM_RUN_TOKEN 0x80
+#    define STREAM_MAX_LITERAL 128
+#    define STREAM_MAX_RUN 129
+
+typedef enum { STREAM_IDLE, STREAM_READING, STREAM_WRITING } stream_mode_t;
+
+static struct {
+    stream_mode_t mode;
+    uint8_t       region;
+    uint8_t       flags;
+    uint8_t       window;
+    uint8_t       base;  // oldest packet not acknowledged, or the next one expected when writing
+    uint8_t       next;  // next packet to send
+    uint16_t      cursor;
+    uint16_t      end;
+    // where each packet in flight starts, so it can be built again on a resend
+    uint16_t start[DYNAMIC_KEYMAP_STREAM_WINDOW];
+} stream;
+
+// A reply for the host, sent before any more data
+static uint8_t reply_op = 0;
+static uint8_t reply_seq;
+static uint8_t reply_error;
+
+static void stream_reply(uint8_t op, uint8_t seq, uint8_t error) {
+    reply_op    = op;
+    reply_seq   = seq;
+    reply_error = error;
+}
+
+static uint16_t stream_region_size(uint8_t region) {
+    switch (region) {
+        case DYNAMIC_KEYMAP_STREAM_KEYMAP:
+            return DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
+        case DYNAMIC_KEYMAP_STREAM_MACRO:
+            return DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE;
+        default:
+            return 0;
+    }
+}
+
+static void stream_read_region(uint16_t offset, uint16_t size, uint8_t *data) {
+    if (stream.region == DYNAMIC_KEYMAP_STREAM_KEYMAP) {
+        dynamic_keymap_get_buffer(offset, size, data);
+    } else {
+        dynamic_keymap_macro_get_buffer(offset, size, data);
+    }
+}
+
+static void stream_write_region(uint16_t offset, uint16_t size, uint8_t *data) {
+    if (stream.region == DYNAMIC_KEYMAP_STREAM_KEYMAP) {
+        dynamic_keymap_set_buffer(offset, size, data);
+    } else {
+        dynamic_keymap_macro_set_buffer(offset, size, data);
+    }
+}
+
+static uint16_t stream_keycode(uint16_t offset) {
+    uint8_t data[2];
+    stream_read_region(offset, sizeof(data), data);
+    return (data[0] << 8) | data[1];
+}
+
+// How many times keycode repeats from offset on, up to what one token can hold
+static uint8_t stream_run(uint16_t offset, uint16_t keycode) {
+    uint8_t run = 0;
+    while (run < STREAM_MAX_RUN && offset < stream.end && stream_keycode(offset) == keycode) {
+        run++;
+        offset += 2;
+    }
+    return run;
+}
+
+static bool stream_start(stream_mode_t mode, uint8_t region, uint8_t flags, uint16_t offset, uint16_t length) {
+    uint16_t size = stream_region_size(region);
+
+    stream.mode = STREAM_IDLE;
+    if (!size || offset > size || length > size - offset) {
+        return false;
+    }
+    if ((flags & DYNAMIC_KEYMAP_STREAM_RLE) && (region != DYNAMIC_KEYMAP_STREAM_KEYMAP || (offset & 1) || (length & 1))) {
+        return false;
+    }
+
+    stream.region = region;
+    stream.flags  = flags;
+    stream.base   = 0;
+    stream.next   = 0;
+    stream.cursor = offset;
+    stream.end    = offset + length;
+    if (length) {
+        stream.mode = mode;
+    }
+    return true;
+}
+
+static uint8_t stream_encode(uint8_t *payload) {
+    uint8_t size = 0;
+
+    if (!(stream.flags & DYNAMIC_KEYMAP_STREAM_RLE)) {
+        size = MIN(stream.end - stream.cursor, DYNAMIC_KEYMAP_STREAM_PAYLOAD_SIZE);
+        stream_read_region(stream.cursor, size, payload);
+        stream.cursor += size;
+        return size;
+    }
+
+    // Both kinds of token need at least three bytes
+    while (stream.cursor < stream.end && size + 3 <= DYNAMIC_KEYMAP_STREAM_PAYLOAD_SIZE) {
+        uint16_t keycode = stream_keycode(stream.cursor);
+        uint8_t  run     = stream_run(stream.cursor, keycode);
+
+        if (run >= 2) {
+            payload[size++] = STREAM_RUN_TOKEN | (run - 2);
+            payload[size++] = keycode >> 8;
+            payload[size++] = keycode & 0xFF;
+            stream.cursor += run * 2;
+            continue;
+        }
+
+        // Literal keycodes up to the start of the next run
+        uint8_t *token = &payload[size++];
+        uint8_t  count = 0;
+        while (stream.cursor < stream.end && size + 2 <= DYNAMIC_KEYMAP_STREAM_PAYLOAD_SIZE && count < STREAM_MAX_LITERAL) {
+            keycode = stream_keycode(stream.cursor);
+            if (count && stream.cursor + 2 < stream.end && stream_keycode(stream.cursor + 2) == keycode) {
+                break;
+            }
+            payload[size++] = keycode >> 8;
+            payload[size++] = keycode & 0xFF;
+            stream.cursor += 2;
+            count++;
+        }
+        *token = count - 1;
+    }
+    return size;
+}
+
+static bool stream_decode(uint8_t *payload, uint8_t size) {
+    if (size > DYNAMIC_KEYMAP_STREAM_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    if (!(stream.flags & DYNAMIC_KEYMAP_STREAM_RLE)) {
+        if (size > stream.end - stream.cursor) {
+            return false;
+        }
+        stream_write_region(stream.cursor, size, payload);
+        stream.cursor += size;
+        return true;
+    }
+
+    uint8_t i = 0;
+    while (i < size) {
+        uint8_t token = payload[i++];
+        if (token & STREAM_RUN_TOKEN) {
+            uint8_t run = (token & ~STREAM_RUN_TOKEN) + 2;
+            if (i + 2 > size || run * 2 > stream.end - stream.cursor) {
+                return false;
+            }
+            while (run--) {
+                stream_write_region(stream.cursor, 2, &payload[i]);
+                stream.cursor += 2;
+            }
+            i += 2;
+        } else {
+            uint16_t length = (token + 1) * 2;
+            if (i + length > size || length > stream.end - stream.cursor) {
+                return false;
+            }
+            stream_write_region(stream.cursor, length, &payload[i]);
+            stream.cursor += length;
+            i += length;
+        }
+    }
+    return true;
+}
+
+static void stream_receive_ack(uint8_t seq) {
+    // Ignore acknowledgements for packets that are not in flight
+    if ((uint8_t)(seq - stream.base) >= (uint8_t)(stream.next - stream.base)) {
+        return;
+    }
+    stream.base = seq + 1;
+    if (stream.base == stream.next && stream.cursor == stream.end) {
+        stream.mode = STREAM_IDLE;
+    }
+}
+
+static void stream_receive_resend(uint8_t seq) {
+    if ((uint8_t)(seq - stream.base) >= (uint8_t)(stream.next - stream.base)) {
+        return;
+    }
+    stream.base   = seq;
+    stream.next   = seq;
+    stream.cursor = stream.start[seq & (DYNAMIC_KEYMAP_STREAM_WINDOW - 1)];
+}
+
+static void stream_receive_data(uint8_t seq, uint8_t size, uint8_t *payload) {
+    if (seq != stream.base) {
+        // Go back N: drop everything after a lost packet and say where to resume
+        stream_reply(DYNAMIC_KEYMAP_STREAM_NAK, stream.base, DYNAMIC_KEYMAP_STREAM_OUT_OF_ORDER);
+        return;
+    }
+    if (!stream_decode(payload, size)) {
+        stream.mode = STREAM_IDLE;
+        stream_reply(DYNAMIC_KEYMAP_STREAM_NAK, seq, DYNAMIC_KEYMAP_STREAM_BAD_REQUEST);
+        return;
+    }
+    stream.base++;
+    if (stream.cursor == stream.end) {
+        stream.mode = STREAM_IDLE;
+    }
+    stream_reply(DYNAMIC_KEYMAP_STREAM_ACK, seq, 0);
+}
+
+bool dynamic_keymap_stream_receive(uint8_t *data, uint8_t length) {
+    if (length < DYNAMIC_KEYMAP_STREAM_PACKET_SIZE || data[0] != DYNAMIC_KEYMAP_STREAM_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case DYNAMIC_KEYMAP_STREAM_READ:
+            if (!stream_start(STREAM_READING, data[2], data[3], (data[5] << 8) | data[6], (data[7] << 8) | data[8])) {
+                stream_reply(DYNAMIC_KEYMAP_STREAM_NAK, 0, DYNAMIC_KEYMAP_STREAM_BAD_REQUEST);
+                break;
+            }
+            stream.window = data[4] ? MIN(data[4], DYNAMIC_KEYMAP_STREAM_WINDOW) : 1;
+            break;
+        case DYNAMIC_KEYMAP_STREAM_WRITE:
+            if (!stream_start(STREAM_WRITING, data[2], data[3], (data[4] << 8) | data[5], (data[6] << 8) | data[7])) {
+                stream_reply(DYNAMIC_KEYMAP_STREAM_NAK, 0, DYNAMIC_KEYMAP_STREAM_BAD_REQUEST);
+            }
+            break;
+        case DYNAMIC_KEYMAP_STREAM_ACK:
+            if (stream.mode == STREAM_READING) {
+                stream_receive_ack(data[2]);
+            }
+            break;
+        case DYNAMIC_KEYMAP_STREAM_RESEND:
+            if (stream.mode == STREAM_READING) {
+                stream_receive_resend(data[2]);
+            }
+            break;
+        case DYNAMIC_KEYMAP_STREAM_DATA:
+            if (stream.mode == STREAM_WRITING) {
+                stream_receive_data(data[2], data[3], &data[DYNAMIC_KEYMAP_STREAM_HEADER_SIZE]);
+            } else {
+                stream_reply(DYNAMIC_KEYMAP_STREAM_NAK, data[2], DYNAMIC_KEYMAP_STREAM_NO_STREAM);
+            }
+            break;
+        case DYNAMIC_KEYMAP_STREAM_ABORT:
+            stream.mode = STREAM_IDLE;
+            reply_op    = 0;
+            break;
+        default:
+            stream_reply(DYNAMIC_KEYMAP_STREAM_NAK, 0, DYNAMIC_KEYMAP_STREAM_BAD_REQUEST);
+            break;
+    }
+    return true;
+}
+
+bool dynamic_keymap_stream_next(uint8_t *data, uint8_t length) {
+    if (length < DYNAMIC_KEYMAP_STREAM_PACKET_SIZE) {
+        return false;
+    }
+
+    memset(data, 0, length);
+    data[0] = DYNAMIC_KEYMAP_STREAM_ID;
+
+    if (reply_op) {
+        data[1]  = reply_op;
+        data[2]  = reply_seq;
+        data[3]  = reply_error;
+        reply_op = 0;
+        return true;
+    }
+
+    if (stream.mode == STREAM_READING && stream.cursor < stream.end && (uint8_t)(stream.next - stream.base) < stream.window) {
+        stream.start[stream.next & (DYNAMIC_KEYMAP_STREAM_WINDOW - 1)] = stream.cursor;
+        data[1] = DYNAMIC_KEYMAP_STREAM_DATA;
+        data[2] = stream.next++;
+        data[3] = stream_encode(&data[DYNAMIC_KEYMAP_STREAM_HEADER_SIZE]);
+        return true;
+    }
+
+    return false;
+}
+
+#    ifdef RAW_ENABLE
+void dynamic_keymap_stream_task(void) {
+    uint8_t data[DYNAMIC_KEYMAP_STREAM_PACKET_SIZE];
+
+    // nothing to send while idle or writing
+    if (!reply_op && stream.mode != STREAM_READING) {
+        return;
+    }
+
+    while (tx_buffer_free(&raw_hid_tx_buffer) >= sizeof(data) && dynamic_keymap_stream_next(data, sizeof(data))) {
+        raw_hid_send(data, sizeof(data));
+    }
+}
+#    endif
+
+#endif  // DYNAMIC_KEYMAP_STREAM_ENABLE
@@ -0,0 +1,97 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Streaming transfer of the dynamic keymap and macro buffers over raw HID.
+ *
+ * The get/set buffer commands cost a round trip per 28 bytes. A stream moves
+ * a whole region with up to a window of packets in flight, each numbered so
+ * the host can acknowledge and request resends. Every packet starts with
+ * DYNAMIC_KEYMAP_STREAM_ID and an op:
+ *
+ *   host -> keyboard
+ *     READ     region flags window offset(2) length(2)   start sending data
+ *     ACK      seq                                       packets up to seq arrived
+ *     RESEND   seq                                       go back and send from seq
+ *     WRITE    region flags offset(2) length(2)          expect data packets
+ *     DATA     seq size payload                          data for a write
+ *     ABORT                                              drop the current stream
+ *
+ *   keyboard -> host
+ *     DATA     seq size payload                          data for a read
+ *     ACK      seq                                       write packets up to seq stored
+ *     NAK      seq error                                 expected seq, or why it failed
+ *
+ * Offsets and lengths are big endian byte counts within the region, like the
+ * buffer commands. With DYNAMIC_KEYMAP_STREAM_RLE set on the keymap region
+ * payloads are 16-bit keycodes in tokens that never cross a packet:
+ *
+ *   0nnnnnnn  n + 1 keycodes follow
+ *   1nnnnnnn  the keycode that follows repeats n + 2 times
+ *
+ * so a layer of KC_TRNS costs three bytes per 129 keys.
+ */
+
+#ifndef DYNAMIC_KEYMAP_STREAM_ID
+#    define DYNAMIC_KEYMAP_STREAM_ID 0xFE
+#endif
+
+// Most packets the keyboard sends ahead of the host's acknowledgement
+#ifndef DYNAMIC_KEYMAP_STREAM_WINDOW
+#    define DYNAMIC_KEYMAP_STREAM_WINDOW 8
+#endif
+
+#define DYNAMIC_KEYMAP_STREAM_PACKET_SIZE 32
+#define DYNAMIC_KEYMAP_STREAM_HEADER_SIZE 4
+#define DYNAMIC_KEYMAP_STREAM_PAYLOAD_SIZE (DYNAMIC_KEYMAP_STREAM_PACKET_SIZE - DYNAMIC_KEYMAP_STREAM_HEADER_SIZE)
+
+enum dynamic_keymap_stream_op {
+    DYNAMIC_KEYMAP_STREAM_READ = 0x01,
+    DYNAMIC_KEYMAP_STREAM_ACK,
+    DYNAMIC_KEYMAP_STREAM_RESEND,
+    DYNAMIC_KEYMAP_STREAM_WRITE,
+    DYNAMIC_KEYMAP_STREAM_DATA,
+    DYNAMIC_KEYMAP_STREAM_ABORT,
+    DYNAMIC_KEYMAP_STREAM_NAK,
+};
+
+enum dynamic_keymap_stream_region {
+    DYNAMIC_KEYMAP_STREAM_KEYMAP = 0x00,
+    DYNAMIC_KEYMAP_STREAM_MACRO,
+};
+
+enum dynamic_keymap_stream_error {
+    DYNAMIC_KEYMAP_STREAM_OUT_OF_ORDER = 0x00,
+    DYNAMIC_KEYMAP_STREAM_BAD_REQUEST,
+    DYNAMIC_KEYMAP_STREAM_NO_STREAM,
+};
+
+#define DYNAMIC_KEYMAP_STREAM_RLE (1 << 0)
+
+/* Handle a packet from raw_hid_receive(). Returns false if it is not a
+ * stream packet. Replies are not written to data, they are queued for
+ * dynamic_keymap_stream_next().
+ */
+bool dynamic_keymap_stream_receive(uint8_t *data, uint8_t length);
+
+/* Build the next packet for the host. Returns false when there is nothing to send. */
+bool dynamic_keymap_stream_next(uint8_t *data, uint8_t length);
+
+/* Send queued packets with raw_hid_send() while the raw HID buffer has room. */
+void dynamic_keymap_stream_task(void);
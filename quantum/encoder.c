@@ -37,8 +37,8 @@ static pin_t encoders_pad_b[] = ENCODERS_PAD_B;
 
 static int8_t encoder_LUT[] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
 
-static uint8_t encoder_state[NUMBER_OF_ENCODERS] = {0};
-static int8_t encoder_pulses[NUMBER_OF_ENCODERS] = {0};
+static uint8_t         encoder_state[NUMBER_OF_ENCODERS]  = {0};
+static volatile int8_t encoder_pulses[NUMBER_OF_ENCODERS] = {0};
 
 #ifdef SPLIT_KEYBOARD
 // right half encoders come over as second set of encoders
@@ -49,10 +49,80 @@ static uint8_t thisHand, thatHand;
 static uint8_t encoder_value[NUMBER_OF_ENCODERS] = {0};
 #endif
 
+#ifdef ENCODER_INTERRUPT
+// encoders whose pads both raise an interrupt, the others are still polled
+static bool encoder_irq[NUMBER_OF_ENCODERS] = {0};
+
+#    if defined(__AVR__)
+#        define ENCODER_LOCK()       \
+            uint8_t sreg = SREG; \
+            cli()
+#        define ENCODER_UNLOCK() SREG = sreg
+#    elif defined(PROTOCOL_CHIBIOS)
+#        define ENCODER_LOCK() chSysLock()
+#        define ENCODER_UNLOCK() chSysUnlock()
+#    endif
+#endif
+
 __attribute__((weak)) void encoder_update_user(int8_t index, bool clockwise) {}
 
 __attribute__((weak)) void encoder_update_kb(int8_t index, bool clockwise) { encoder_update_user(index, clockwise); }
 
+__attribute__((weak)) bool encoder_update_steps_user(int8_t index, int8_t steps) { return false; }
+
+__attribute__((weak)) bool encoder_update_steps_kb(int8_t index, int8_t steps) { return encoder_update_steps_user(index, steps); }
+
+static void encoder_sample(uint8_t i) {
+    encoder_state[i] <<= 2;
+    encoder_state[i] |= (readPin(encoders_pad_a[i]) << 0) | (readPin(encoders_pad_b[i]) << 1);
+    encoder_pulses[i] += encoder_LUT[encoder_state[i] & 0xF];
+}
+
+#ifdef ENCODER_INTERRUPT
+/** \brief Sample all interrupt driven encoders
+ *
+ * Safe to call from any pin change handler, e.g. when the encoder pads share an interrupt vector with something else.
+ */
+void encoder_interrupt_handler(void) {
+    for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; i++) {
+        if (encoder_irq[i]) {
+            encoder_sample(i);
+        }
+    }
+}
+
+#    if defined(__AVR__)
+#        ifndef ENCODER_NO_PCINT_VECTOR
+ISR(PCINT0_vect) { encoder_interrupt_handler(); }
+#        endif
+
+// Only PORTB has a pin change interrupt on all of the supported MCUs
+static bool encoder_irq_enable(pin_t pin) {
+    if ((pin >> PORT_SHIFTER) != PINB_ADDRESS) {
+        return false;
+    }
+    PCMSK0 |= _BV(pin & 0xF);
+    PCICR |= _BV(PCIE0);
+    return true;
+}
+#    elif defined(PROTOCOL_CHIBIOS)
+static void encoder_pal_cb(void *arg) {
+    (void)arg;
+    chSysLockFromISR();
+    encoder_interrupt_handler();
+    chSysUnlockFromISR();
+}
+
+static bool encoder_irq_enable(pin_t pin) {
+    palSetLineCallback(pin, encoder_pal_cb, NULL);
+    palEnableLineEvent(pin, PAL_EVENT_MODE_BOTH_EDGES);
+    return true;
+}
+#    else
+#        error "ENCODER_INTERRUPT is not supported on this platform."
+#    endif
+#endif
+
 void encoder_init(void) {
 #if defined(SPLIT_KEYBOARD) && defined(ENCODERS_PAD_A_RIGHT) && defined(ENCODERS_PAD_B_RIGHT)
     if (!isLeftHand) {
@@ -70,6 +140,9 @@ void encoder_init(void) {
         setPinInputHigh(encoders_pad_b[i]);
 
         encoder_state[i] = (readPin(encoders_pad_a[i]) << 0) | (readPin(encoders_pad_b[i]) << 1);
+#ifdef ENCODER_INTERRUPT
+        encoder_irq[i] = encoder_irq_enable(encoders_pad_a[i]) && encoder_irq_enable(encoders_pad_b[i]);
+#endif
     }
 
 #ifdef SPLIT_KEYBOARD
@@ -78,28 +151,44 @@ void encoder_init(void) {
 #endif
 }
 
-static void encoder_update(int8_t index, uint8_t state) {
-    uint8_t i = index;
-#ifdef SPLIT_KEYBOARD
-    index += thisHand;
-#endif
-    encoder_pulses[i] += encoder_LUT[state & 0xF];
-    if (encoder_pulses[i] >= ENCODER_RESOLUTION) {
-        encoder_value[index]++;
+// Hands the detents accumulated since the last scan to the keymap, as a single
+// event when encoder_update_steps_kb() handles it, otherwise one per detent.
+static void encoder_dispatch(int8_t index, int8_t steps) {
+    encoder_value[index] += steps;
+    if (encoder_update_steps_kb(index, steps)) {
+        return;
+    }
+    for (; steps > 0; steps--) {
         encoder_update_kb(index, true);
     }
-    if (encoder_pulses[i] <= -ENCODER_RESOLUTION) { // direction is arbitrary here, but this clockwise
-        encoder_value[index]--;
+    for (; steps < 0; steps++) {  // direction is arbitrary here, but this clockwise
         encoder_update_kb(index, false);
     }
-    encoder_pulses[i] %= ENCODER_RESOLUTION;
 }
 
 void encoder_read(void) {
     for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; i++) {
-        encoder_state[i] <<= 2;
-        encoder_state[i] |= (readPin(encoders_pad_a[i]) << 0) | (readPin(encoders_pad_b[i]) << 1);
-        encoder_update(i, encoder_state[i]);
+        int8_t steps;
+#ifdef ENCODER_INTERRUPT
+        if (!encoder_irq[i]) {
+            encoder_sample(i);
+        }
+        ENCODER_LOCK();
+#else
+        encoder_sample(i);
+#endif
+        steps = encoder_pulses[i] / ENCODER_RESOLUTION;
+        encoder_pulses[i] -= steps * ENCODER_RESOLUTION;
+#ifdef ENCODER_INTERRUPT
+        ENCODER_UNLOCK();
+#endif
+        if (steps) {
+#ifdef SPLIT_KEYBOARD
+            encoder_dispatch(i + thisHand, steps);
+#else
+            encoder_dispatch(i, steps);
+#endif
+        }
     }
 }
 
@@ -109,16 +198,10 @@ void encoder_state_raw(uint8_t* slave_state) { memcpy(slave_state, &encoder_valu
 void encoder_update_raw(uint8_t* slave_state) {
     for (uint8_t i = 0; i < NUMBER_OF_ENCODERS; i++) {
         uint8_t index = i + thatHand;
+        // the counters wrap, so the difference is the signed number of detents since the last transfer
         int8_t delta = slave_state[i] - encoder_value[index];
-        while (delta > 0) {
-            delta--;
-            encoder_value[index]++;
-            encoder_update_kb(index, true);
-        }
-        while (delta < 0) {
-            delta++;
-            encoder_value[index]--;
-            encoder_update_kb(index, false);
+        if (delta) {
+            encoder_dispatch(index, delta);
         }
     }
 }
@@ -24,6 +24,12 @@ void encoder_read(void);
 
 void encoder_update_kb(int8_t index, bool clockwise);
 void encoder_update_user(int8_t index, bool clockwise);
+bool encoder_update_steps_kb(int8_t index, int8_t steps);
+bool encoder_update_steps_user(int8_t index, int8_t steps);
+
+#ifdef ENCODER_INTERRUPT
+void encoder_interrupt_handler(void);
+#endif
 
 #ifdef SPLIT_KEYBOARD
 void encoder_state_raw(uint8_t* slave_state);
@@ -24,6 +24,7 @@
 #include "progmem.h"
 #include "config.h"
 #include "eeprom.h"
+#include "animation_clock.h"
 #include <string.h>
 #include <math.h>
 
@@ -55,18 +56,22 @@ led_config_t led_matrix_config;
 
 bool g_suspend_state = false;
 
-// Global tick at 20 Hz
+// Animation clock time of the last task, in milliseconds.
 uint32_t g_tick = 0;
 
-// Ticks since this key was last hit.
+// Milliseconds since this key was last hit, up to 255.
 uint8_t g_key_hit[LED_DRIVER_LED_COUNT];
 
-// Ticks since any key was last hit.
+// Milliseconds since any key was last hit.
 uint32_t g_any_key_hit = 0;
 
-uint32_t eeconfig_read_led_matrix(void) { return eeprom_read_dword(EECONFIG_LED_MATRIX); }
+uint32_t eeconfig_read_led_matrix(void) {
+    uint32_t config_value;
+    eeconfig_read_block(&config_value, EECONFIG_LED_MATRIX, sizeof(config_value));
+    return config_value;
+}
 
-void eeconfig_update_led_matrix(uint32_t config_value) { eeprom_update_dword(EECONFIG_LED_MATRIX, config_value); }
+void eeconfig_update_led_matrix(uint32_t config_value) { eeconfig_update_block(&config_value, EECONFIG_LED_MATRIX, sizeof(config_value)); }
 
 void eeconfig_update_led_matrix_default(void) {
     dprintf("eeconfig_update_led_matrix_default\n");
@@ -154,25 +159,31 @@ void led_matrix_task(void) {
         return;
     }
 
-    g_tick++;
+    uint32_t elapsed = animation_clock_elapsed(g_tick);
+    g_tick += elapsed;
 
-    if (g_any_key_hit < 0xFFFFFFFF) {
-        g_any_key_hit++;
+    if (elapsed > 0xFFFFFFFF - g_any_key_hit) {
+        g_any_key_hit = 0xFFFFFFFF;
+    } else {
+        g_any_key_hit += elapsed;
     }
 
     for (int led = 0; led < LED_DRIVER_LED_COUNT; led++) {
         if (g_key_hit[led] < 255) {
-            if (g_key_hit[led] == 254) g_last_led_count = MAX(g_last_led_count - 1, 0);
-            g_key_hit[led]++;
+            if (elapsed >= 255 - g_key_hit[led]) {
+                g_last_led_count = MAX(g_last_led_count - 1, 0);
+                g_key_hit[led]   = 255;
+            } else {
+                g_key_hit[led] += elapsed;
+            }
         }
     }
 
     // Ideally we would also stop sending zeros to the LED driver PWM buffers
     // while suspended and just do a software shutdown. This is a cheap hack for now.
-    bool    suspend_backlight = ((g_suspend_state && LED_DISABLE_WHEN_USB_SUSPENDED) || (LED_DISABLE_AFTER_TIMEOUT > 0 && g_any_key_hit > LED_DISABLE_AFTER_TIMEOUT * 60 * 20));
+    bool    suspend_backlight = ((g_suspend_state && LED_DISABLE_WHEN_USB_SUSPENDED) || (LED_DISABLE_AFTER_TIMEOUT > 0 && g_any_key_hit > (uint32_t)LED_DISABLE_AFTER_TIMEOUT * 60 * 1000));
     uint8_t effect            = suspend_backlight ? 0 : led_matrix_config.mode;
 
-    // this gets ticked at 20 Hz.
     // each effect can opt to do calculations
     // and/or request PWM buffer updates.
     switch (effect) {
@@ -17,6 +17,10 @@
 
 /* Author: Wojciech Siewierski < wojciech dot siewierski at onet dot pl > */
 #include "process_dynamic_macro.h"
+#include <string.h>
+#ifdef DYNAMIC_MACRO_EEPROM_ADDR
+#    include "eeprom.h"
+#endif
 
 // default feedback method
 void dynamic_macro_led_blink(void) {
@@ -37,6 +41,78 @@ __attribute__((weak)) void dynamic_macro_record_key_user(int8_t direction, keyre
 
 __attribute__((weak)) void dynamic_macro_record_end_user(int8_t direction) { dynamic_macro_led_blink(); }
 
+/* Both macros use the same buffer but read/write on different ends
+ * of it.
+ *
+ * Macro1 is written left-to-right starting from the beginning of the
+ * buffer.
+ *
+ * Macro2 is written right-to-left starting from the end of the
+ * buffer.
+ *
+ * &macro_buffer   macro_end
+ *  v                   v
+ * +------------------------------------------------------------+
+ * |>>>>>> MACRO1 >>>>>>      <<<<<<<<<<<<< MACRO2 <<<<<<<<<<<<<|
+ * +------------------------------------------------------------+
+ *                           ^                                 ^
+ *                         r_macro_end                  r_macro_buffer
+ *
+ * During the recording when one macro encounters the end of the other
+ * macro, the recording is stopped. Apart from this, there are no
+ * arbitrary limits for the macros' length in relation to each other:
+ * for example one can either have two medium sized macros or one long
+ * macro and one short macro. Or even one empty and one using the whole
+ * buffer.
+ *
+ * Events are stored as bytes, see dynamic_macro_encode(). Macro2 is
+ * read and written with the same code as macro1, just stepping through
+ * the buffer backwards.
+ */
+static uint8_t macro_buffer[DYNAMIC_MACRO_BYTES];
+
+/* The byte after the first macro. Initially points to the very
+ * beginning of the buffer since the macro is empty. */
+static uint8_t *macro_end = macro_buffer;
+
+/* The other end of the macro buffer. Serves as the beginning of the
+ * second macro. */
+static uint8_t *const r_macro_buffer = macro_buffer + DYNAMIC_MACRO_BYTES - 1;
+
+/* Like macro_end but for the second macro. */
+static uint8_t *r_macro_end = macro_buffer + DYNAMIC_MACRO_BYTES - 1;
+
+/* A persistent pointer to the current macro position (iterator) used
+ * during the recording. */
+static uint8_t *macro_pointer = NULL;
+
+/* Where the recording ends if it is stopped now: just after the last
+ * key release, so the keys held to reach DYN_REC_STOP are dropped. */
+static uint8_t *macro_trim = NULL;
+
+#ifdef DYNAMIC_MACRO_DELAYS
+static uint16_t macro_timer;
+#endif
+
+/* 0   - no macro is being recorded right now
+ * 1,2 - either macro 1 or 2 is being recorded */
+static uint8_t macro_id = 0;
+
+/* Macros being played back. A macro may play the other one, so there
+ * are at most two, the innermost last. */
+typedef struct {
+    uint8_t *     pointer;
+    uint8_t *     end;
+    int8_t        direction;
+    layer_state_t saved_layer_state;
+#ifdef DYNAMIC_MACRO_DELAYS
+    uint16_t timer;
+#endif
+} dynamic_macro_player_t;
+
+static dynamic_macro_player_t players[2];
+static uint8_t                players_count = 0;
+
 /* Convenience macros used for retrieving the debug info. All of them
  * need a `direction` variable accessible at the call site.
  */
@@ -44,13 +120,103 @@ __attribute__((weak)) void dynamic_macro_record_end_user(int8_t direction) { dyn
 #define DYNAMIC_MACRO_CURRENT_LENGTH(BEGIN, POINTER) ((int)(direction * ((POINTER) - (BEGIN))))
 #define DYNAMIC_MACRO_CURRENT_CAPACITY(BEGIN, END2) ((int)(direction * ((END2) - (BEGIN)) + 1))
 
+/* An event is a single byte holding the pressed flag in bit 7 and the
+ * key's row * MATRIX_COLS + col below it. Keys outside the matrix and
+ * events with tap state use DYNAMIC_MACRO_EXTENDED in place of the key
+ * index, followed by the row, the column and the tap state. With
+ * DYNAMIC_MACRO_DELAYS the milliseconds since the previous event follow
+ * as a varint, seven bits per byte, least significant first.
+ */
+#define DYNAMIC_MACRO_PRESSED 0x80
+#define DYNAMIC_MACRO_EXTENDED 0x7F
+#define DYNAMIC_MACRO_MAX_EVENT_SIZE 7
+
+static uint8_t dynamic_macro_encode(keyrecord_t *record, uint16_t delay, uint8_t *out) {
+    uint8_t  len   = 0;
+    uint8_t  tap   = 0;
+    uint16_t index = (uint16_t)record->event.key.row * MATRIX_COLS + record->event.key.col;
+
+#ifndef NO_ACTION_TAPPING
+    memcpy(&tap, &record->tap, sizeof(tap));
+#endif
+
+    if (record->event.key.row < MATRIX_ROWS && record->event.key.col < MATRIX_COLS && index < DYNAMIC_MACRO_EXTENDED && tap == 0) {
+        out[len++] = index;
+    } else {
+        out[len++] = DYNAMIC_MACRO_EXTENDED;
+        out[len++] = record->event.key.row;
+        out[len++] = record->event.key.col;
+        out[len++] = tap;
+    }
+    if (record->event.pressed) {
+        out[0] |= DYNAMIC_MACRO_PRESSED;
+    }
+
+#ifdef DYNAMIC_MACRO_DELAYS
+    do {
+        out[len++] = (delay & 0x7F) | (delay > 0x7F ? 0x80 : 0);
+        delay >>= 7;
+    } while (delay);
+#endif
+
+    return len;
+}
+
+/**
+ * Decode the event at `pointer`.
+ *
+ * @param pointer[in]    The first byte of the event.
+ * @param direction[in]  Either +1 or -1, which way to iterate the buffer.
+ * @param record[out]    The event, stamped with the current time.
+ * @param delay[out]     How long to wait before the event, in ms.
+ * @return The first byte of the next event.
+ */
+static uint8_t *dynamic_macro_decode(uint8_t *pointer, int8_t direction, keyrecord_t *record, uint16_t *delay) {
+    uint8_t head  = *pointer;
+    uint8_t index = head & ~DYNAMIC_MACRO_PRESSED;
+    pointer += direction;
+
+    memset(record, 0, sizeof(*record));
+    record->event.pressed = head & DYNAMIC_MACRO_PRESSED;
+    record->event.time    = timer_read() | 1;
+    if (index == DYNAMIC_MACRO_EXTENDED) {
+        uint8_t tap;
+        record->event.key.row = *pointer;
+        pointer += direction;
+        record->event.key.col = *pointer;
+        pointer += direction;
+        tap = *pointer;
+        pointer += direction;
+#ifndef NO_ACTION_TAPPING
+        memcpy(&record->tap, &tap, sizeof(tap));
+#else
+        (void)tap;
+#endif
+    } else {
+        record->event.key.row = index / MATRIX_COLS;
+        record->event.key.col = index % MATRIX_COLS;
+    }
+
+    *delay = 0;
+#ifdef DYNAMIC_MACRO_DELAYS
+    for (uint8_t shift = 0;; shift += 7) {
+        uint8_t byte = *pointer;
+        pointer += direction;
+        *delay |= (uint16_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+#endif
+
+    return pointer;
+}
+
 /**
  * Start recording of the dynamic macro.
  *
  * @param[out] macro_pointer The new macro buffer iterator.
  * @param[in]  macro_buffer  The macro buffer used to initialize macro_pointer.
  */
-void dynamic_macro_record_start(keyrecord_t **macro_pointer, keyrecord_t *macro_buffer) {
+void dynamic_macro_record_start(uint8_t **macro_pointer, uint8_t *macro_buffer) {
     dprintln("dynamic macro recording: started");
 
     dynamic_macro_record_start_user();
@@ -58,33 +224,80 @@ void dynamic_macro_record_start(keyrecord_t **macro_pointer, keyrecord_t *macro_
     clear_keyboard();
     layer_clear();
     *macro_pointer = macro_buffer;
+    macro_trim     = macro_buffer;
+#ifdef DYNAMIC_MACRO_DELAYS
+    macro_timer = timer_read();
+#endif
 }
 
 /**
- * Play the dynamic macro.
+ * Start playing the dynamic macro. The events are sent one per matrix
+ * scan by dynamic_macro_task().
  *
  * @param macro_buffer[in] The beginning of the macro buffer being played.
  * @param macro_end[in]    The element after the last macro buffer element.
  * @param direction[in]    Either +1 or -1, which way to iterate the buffer.
  */
-void dynamic_macro_play(keyrecord_t *macro_buffer, keyrecord_t *macro_end, int8_t direction) {
+void dynamic_macro_play(uint8_t *macro_buffer, uint8_t *macro_end, int8_t direction) {
+    for (uint8_t i = 0; i < players_count; i++) {
+        if (players[i].direction == direction) {
+            dprintf("dynamic macro: slot %d is already playing\n", DYNAMIC_MACRO_CURRENT_SLOT());
+            return;
+        }
+    }
+
     dprintf("dynamic macro: slot %d playback\n", DYNAMIC_MACRO_CURRENT_SLOT());
 
-    layer_state_t saved_layer_state = layer_state;
+    dynamic_macro_player_t *player = &players[players_count++];
+    player->pointer                = macro_buffer;
+    player->end                    = macro_end;
+    player->direction              = direction;
+    player->saved_layer_state      = layer_state;
+#ifdef DYNAMIC_MACRO_DELAYS
+    player->timer = timer_read();
+#endif
 
     clear_keyboard();
     layer_clear();
+}
 
-    while (macro_buffer != macro_end) {
-        process_record(macro_buffer);
-        macro_buffer += direction;
+/**
+ * Send the next event of the macro being played, if it is due. Called
+ * once per matrix scan.
+ */
+void dynamic_macro_task(void) {
+    if (players_count == 0) {
+        return;
     }
 
-    clear_keyboard();
+    dynamic_macro_player_t *player    = &players[players_count - 1];
+    int8_t                  direction = player->direction;
+
+    if (player->pointer == player->end) {
+        clear_keyboard();
 
-    layer_state = saved_layer_state;
+        layer_state = player->saved_layer_state;
+        players_count--;
+
+        dynamic_macro_play_user(direction);
+        return;
+    }
+
+    keyrecord_t record;
+    uint16_t    delay;
+    uint8_t *   next = dynamic_macro_decode(player->pointer, direction, &record, &delay);
+
+#ifdef DYNAMIC_MACRO_DELAYS
+    if (timer_elapsed(player->timer) < delay) {
+        return;
+    }
+    player->timer = timer_read();
+#else
+    (void)delay;
+#endif
 
-    dynamic_macro_play_user(direction);
+    player->pointer = next;
+    process_record(&record);
 }
 
 /**
@@ -96,19 +309,38 @@ void dynamic_macro_play(keyrecord_t *macro_buffer, keyrecord_t *macro_end, int8_
  * @param direction[in]  Either +1 or -1, which way to iterate the buffer.
  * @param record[in]     The current keypress.
  */
-void dynamic_macro_record_key(keyrecord_t *macro_buffer, keyrecord_t **macro_pointer, keyrecord_t *macro2_end, int8_t direction, keyrecord_t *record) {
+void dynamic_macro_record_key(uint8_t *macro_buffer, uint8_t **macro_pointer, uint8_t *macro2_end, int8_t direction, keyrecord_t *record) {
+    uint8_t  event[DYNAMIC_MACRO_MAX_EVENT_SIZE];
+    uint8_t  len;
+    uint16_t delay = 0;
+
     /* If we've just started recording, ignore all the key releases. */
     if (!record->event.pressed && *macro_pointer == macro_buffer) {
         dprintln("dynamic macro: ignoring a leading key-up event");
         return;
     }
 
+#ifdef DYNAMIC_MACRO_DELAYS
+    if (*macro_pointer != macro_buffer) {
+        delay = timer_elapsed(macro_timer);
+    }
+#endif
+    len = dynamic_macro_encode(record, delay, event);
+
     /* The other end of the other macro is the last buffer element it
      * is safe to use before overwriting the other macro.
      */
-    if (*macro_pointer - direction != macro2_end) {
-        **macro_pointer = *record;
-        *macro_pointer += direction;
+    if (direction * (macro2_end - *macro_pointer) + 1 >= len) {
+        for (uint8_t i = 0; i < len; i++) {
+            **macro_pointer = event[i];
+            *macro_pointer += direction;
+        }
+        if (!record->event.pressed) {
+            macro_trim = *macro_pointer;
+        }
+#ifdef DYNAMIC_MACRO_DELAYS
+        macro_timer = timer_read();
+#endif
     } else {
         dynamic_macro_record_key_user(direction, record);
     }
@@ -120,20 +352,71 @@ void dynamic_macro_record_key(keyrecord_t *macro_buffer, keyrecord_t **macro_poi
  * End recording of the dynamic macro. Essentially just update the
  * pointer to the end of the macro.
  */
-void dynamic_macro_record_end(keyrecord_t *macro_buffer, keyrecord_t *macro_pointer, int8_t direction, keyrecord_t **macro_end) {
+void dynamic_macro_record_end(uint8_t *macro_buffer, uint8_t *macro_pointer, int8_t direction, uint8_t **macro_end) {
     dynamic_macro_record_end_user(direction);
 
     /* Do not save the keys being held when stopping the recording,
      * i.e. the keys used to access the layer DYN_REC_STOP is on.
      */
-    while (macro_pointer != macro_buffer && (macro_pointer - direction)->event.pressed) {
-        dprintln("dynamic macro: trimming a trailing key-down event");
-        macro_pointer -= direction;
+    if (macro_pointer != macro_trim) {
+        dprintln("dynamic macro: trimming trailing key-down events");
+        macro_pointer = macro_trim;
     }
 
     dprintf("dynamic macro: slot %d saved, length: %d\n", DYNAMIC_MACRO_CURRENT_SLOT(), DYNAMIC_MACRO_CURRENT_LENGTH(macro_buffer, macro_pointer));
 
     *macro_end = macro_pointer;
+
+#ifdef DYNAMIC_MACRO_EEPROM_ADDR
+    dynamic_macro_save();
+#endif
+}
+
+#ifdef DYNAMIC_MACRO_EEPROM_ADDR
+/* EEPROM layout: a format byte, the length of each macro as a little
+ * endian word and then the buffer itself. Only the used ends are written.
+ */
+#    ifdef DYNAMIC_MACRO_DELAYS
+#        define DYNAMIC_MACRO_EEPROM_FORMAT 0xD1
+#    else
+#        define DYNAMIC_MACRO_EEPROM_FORMAT 0xD0
+#    endif
+#    define DYNAMIC_MACRO_EEPROM_BUFFER ((uint8_t *)(DYNAMIC_MACRO_EEPROM_ADDR) + 5)
+
+void dynamic_macro_save(void) {
+    uint16_t length1   = macro_end - macro_buffer;
+    uint16_t length2   = r_macro_buffer - r_macro_end;
+    uint8_t  header[5] = {DYNAMIC_MACRO_EEPROM_FORMAT, length1 & 0xFF, length1 >> 8, length2 & 0xFF, length2 >> 8};
+
+    eeprom_update_block(macro_buffer, DYNAMIC_MACRO_EEPROM_BUFFER, length1);
+    eeprom_update_block(r_macro_end + 1, DYNAMIC_MACRO_EEPROM_BUFFER + DYNAMIC_MACRO_BYTES - length2, length2);
+    eeprom_update_block(header, (uint8_t *)(DYNAMIC_MACRO_EEPROM_ADDR), sizeof(header));
+}
+
+bool dynamic_macro_load(void) {
+    uint8_t header[5];
+
+    eeprom_read_block(header, (uint8_t *)(DYNAMIC_MACRO_EEPROM_ADDR), sizeof(header));
+    uint16_t length1 = header[1] | header[2] << 8;
+    uint16_t length2 = header[3] | header[4] << 8;
+    if (header[0] != DYNAMIC_MACRO_EEPROM_FORMAT || (uint32_t)length1 + length2 > DYNAMIC_MACRO_BYTES) {
+        return false;
+    }
+
+    eeprom_read_block(macro_buffer, DYNAMIC_MACRO_EEPROM_BUFFER, length1);
+    eeprom_read_block(r_macro_buffer + 1 - length2, DYNAMIC_MACRO_EEPROM_BUFFER + DYNAMIC_MACRO_BYTES - length2, length2);
+    macro_end   = macro_buffer + length1;
+    r_macro_end = r_macro_buffer - length2;
+    return true;
+}
+#endif
+
+void dynamic_macro_init(void) {
+#ifdef DYNAMIC_MACRO_EEPROM_ADDR
+    if (dynamic_macro_load()) {
+        dprintln("dynamic macro: loaded from EEPROM");
+    }
+#endif
 }
 
 /* Handle the key events related to the dynamic macros. Should be
@@ -147,63 +430,24 @@ void dynamic_macro_record_end(keyrecord_t *macro_buffer, keyrecord_t *macro_poin
  *   }
  */
 bool process_dynamic_macro(uint16_t keycode, keyrecord_t *record) {
-    /* Both macros use the same buffer but read/write on different
-     * ends of it.
-     *
-     * Macro1 is written left-to-right starting from the beginning of
-     * the buffer.
-     *
-     * Macro2 is written right-to-left starting from the end of the
-     * buffer.
-     *
-     * &macro_buffer   macro_end
-     *  v                   v
-     * +------------------------------------------------------------+
-     * |>>>>>> MACRO1 >>>>>>      <<<<<<<<<<<<< MACRO2 <<<<<<<<<<<<<|
-     * +------------------------------------------------------------+
-     *                           ^                                 ^
-     *                         r_macro_end                  r_macro_buffer
-     *
-     * During the recording when one macro encounters the end of the
-     * other macro, the recording is stopped. Apart from this, there
-     * are no arbitrary limits for the macros' length in relation to
-     * each other: for example one can either have two medium sized
-     * macros or one long macro and one short macro. Or even one empty
-     * and one using the whole buffer.
-     */
-    static keyrecord_t macro_buffer[DYNAMIC_MACRO_SIZE];
-
-    /* Pointer to the first buffer element after the first macro.
-     * Initially points to the very beginning of the buffer since the
-     * macro is empty. */
-    static keyrecord_t *macro_end = macro_buffer;
-
-    /* The other end of the macro buffer. Serves as the beginning of
-     * the second macro. */
-    static keyrecord_t *const r_macro_buffer = macro_buffer + DYNAMIC_MACRO_SIZE - 1;
-
-    /* Like macro_end but for the second macro. */
-    static keyrecord_t *r_macro_end = r_macro_buffer;
-
-    /* A persistent pointer to the current macro position (iterator)
-     * used during the recording. */
-    static keyrecord_t *macro_pointer = NULL;
-
-    /* 0   - no macro is being recorded right now
-     * 1,2 - either macro 1 or 2 is being recorded */
-    static uint8_t macro_id = 0;
-
     if (macro_id == 0) {
         /* No macro recording in progress. */
         if (!record->event.pressed) {
             switch (keycode) {
                 case DYN_REC_START1:
-                    dynamic_macro_record_start(&macro_pointer, macro_buffer);
-                    macro_id = 1;
-                    return false;
                 case DYN_REC_START2:
-                    dynamic_macro_record_start(&macro_pointer, r_macro_buffer);
-                    macro_id = 2;
+                    if (players_count > 0) {
+                        /* The played events would end up in the new macro. */
+                        dprintln("dynamic macro: ignoring record key during playback");
+                        return false;
+                    }
+                    if (keycode == DYN_REC_START1) {
+                        dynamic_macro_record_start(&macro_pointer, macro_buffer);
+                        macro_id = 1;
+                    } else {
+                        dynamic_macro_record_start(&macro_pointer, r_macro_buffer);
+                        macro_id = 2;
+                    }
                     return false;
                 case DYN_MACRO_PLAY1:
                     dynamic_macro_play(macro_buffer, macro_end, +1);
@@ -20,21 +20,43 @@
 
 #include "quantum.h"
 
-/* May be overridden with a custom value. Be aware that the effective
- * macro length is half of this value: each keypress is recorded twice
- * because of the down-event and up-event. This is not a bug, it's the
- * intended behavior.
- *
- * Usually it should be fine to set the macro size to at least 256 but
- * there have been reports of it being too much in some users' cases,
- * so 128 is considered a safe default.
+/* May be overridden with a custom value. This is the size of the
+ * buffer in bytes, shared by both macros. Each keypress is recorded
+ * twice because of the down-event and up-event, and a plain key event
+ * takes one byte, so the effective macro length is about half of this
+ * value. Tap keys (mod-tap, layer-tap) and keys outside the matrix take
+ * four bytes per event, and DYNAMIC_MACRO_DELAYS adds one to three
+ * more.
+ */
+#ifndef DYNAMIC_MACRO_BYTES
+#    ifdef DYNAMIC_MACRO_SIZE
+/* DYNAMIC_MACRO_SIZE used to count recorded events of sizeof(keyrecord_t)
+ * bytes each. Keep the RAM such a setting asked for, which still holds at
+ * least that many events unless DYNAMIC_MACRO_DELAYS is on.
  */
-#ifndef DYNAMIC_MACRO_SIZE
-#    define DYNAMIC_MACRO_SIZE 128
+#        define DYNAMIC_MACRO_BYTES (DYNAMIC_MACRO_SIZE * sizeof(keyrecord_t))
+#    else
+#        define DYNAMIC_MACRO_BYTES 256
+#    endif
 #endif
 
+/* Define DYNAMIC_MACRO_DELAYS to record the time between the events
+ * and wait for it again during playback. Otherwise one event is played
+ * per matrix scan.
+ *
+ * Define DYNAMIC_MACRO_EEPROM_ADDR to keep the macros in EEPROM. They
+ * are saved whenever a recording finishes and loaded at startup. The
+ * area takes DYNAMIC_MACRO_BYTES + 5 bytes.
+ */
+
 void dynamic_macro_led_blink(void);
 bool process_dynamic_macro(uint16_t keycode, keyrecord_t *record);
+void dynamic_macro_init(void);
+void dynamic_macro_task(void);
+#ifdef DYNAMIC_MACRO_EEPROM_ADDR
+void dynamic_macro_save(void);
+bool dynamic_macro_load(void);
+#endif
 void dynamic_macro_record_start_user(void);
 void dynamic_macro_play_user(int8_t direction);
 void dynamic_macro_record_key_user(int8_t direction, keyrecord_t *record);
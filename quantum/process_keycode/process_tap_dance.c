@@ -15,6 +15,7 @@
  */
 #include "quantum.h"
 #include "action_tapping.h"
+#include <string.h>
 
 #ifndef TAPPING_TERM
 #    define TAPPING_TERM 200
@@ -24,8 +25,23 @@
 uint8_t get_oneshot_mods(void);
 #endif
 
+#ifndef TAP_DANCE_MAX_ACTIVE
+#    define TAP_DANCE_MAX_ACTIVE 8
+#endif
+
 static uint16_t last_td;
-static int8_t   highest_td = -1;
+
+/* Dances with a non-zero count, oldest first, with the time their
+ * tapping term runs out. Any key press finishes the other dances, so
+ * apart from dances still held down there is rarely more than one.
+ */
+typedef struct {
+    uint8_t  index;
+    uint16_t deadline;
+} active_td_t;
+
+static active_td_t active_td[TAP_DANCE_MAX_ACTIVE];
+static uint8_t     active_td_count = 0;
 
 void qk_tap_dance_pair_on_each_tap(qk_tap_dance_state_t *state, void *user_data) {
     qk_tap_dance_pair_t *pair = (qk_tap_dance_pair_t *)user_data;
@@ -107,22 +123,69 @@ static inline void process_tap_dance_action_on_reset(qk_tap_dance_action_t *acti
     send_keyboard_report();
 }
 
-void preprocess_tap_dance(uint16_t keycode, keyrecord_t *record) {
-    qk_tap_dance_action_t *action;
+static void active_td_remove(uint8_t index) {
+    for (uint8_t i = 0; i < active_td_count; i++) {
+        if (active_td[i].index == index) {
+            active_td_count--;
+            memmove(&active_td[i], &active_td[i + 1], (active_td_count - i) * sizeof(active_td_t));
+            return;
+        }
+    }
+}
+
+static void active_td_finish(uint8_t slot) {
+    qk_tap_dance_action_t *action = &tap_dance_actions[active_td[slot].index];
+
+    process_tap_dance_action_on_dance_finished(action);
+    reset_tap_dance(&action->state);
+}
+
+static void active_td_start(uint8_t index, uint16_t deadline) {
+    for (uint8_t i = 0; i < active_td_count; i++) {
+        if (active_td[i].index == index) {
+            active_td[i].deadline = deadline;
+            return;
+        }
+    }
+
+    if (active_td_count == TAP_DANCE_MAX_ACTIVE) {
+        /* Held dances that have finished are reset on release without
+         * the list, so drop one of those, or else end the oldest dance
+         * early. */
+        uint8_t slot = 0;
+        for (uint8_t i = 0; i < active_td_count; i++) {
+            if (tap_dance_actions[active_td[i].index].state.finished) {
+                slot = i;
+                break;
+            }
+        }
+        if (!tap_dance_actions[active_td[slot].index].state.finished) {
+            active_td_finish(slot);
+        }
+        if (active_td_count == TAP_DANCE_MAX_ACTIVE) {
+            active_td_remove(active_td[slot].index);
+        }
+    }
+
+    active_td[active_td_count].index    = index;
+    active_td[active_td_count].deadline = deadline;
+    active_td_count++;
+}
 
+void preprocess_tap_dance(uint16_t keycode, keyrecord_t *record) {
     if (!record->event.pressed) return;
 
-    if (highest_td == -1) return;
+    for (uint8_t i = 0; i < active_td_count;) {
+        uint8_t                index  = active_td[i].index;
+        qk_tap_dance_action_t *action = &tap_dance_actions[index];
 
-    for (int i = 0; i <= highest_td; i++) {
-        action = &tap_dance_actions[i];
-        if (action->state.count) {
-            if (keycode == action->state.keycode && keycode == last_td) continue;
+        if (keycode != action->state.keycode || keycode != last_td) {
             action->state.interrupted          = true;
             action->state.interrupting_keycode = keycode;
-            process_tap_dance_action_on_dance_finished(action);
-            reset_tap_dance(&action->state);
+            active_td_finish(i);
         }
+        // Finishing removes the entry unless the key is still held
+        if (i < active_td_count && active_td[i].index == index) i++;
     }
 }
 
@@ -132,7 +195,6 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 
     switch (keycode) {
         case QK_TAP_DANCE ... QK_TAP_DANCE_MAX:
-            if ((int16_t)idx > highest_td) highest_td = idx;
             action = &tap_dance_actions[idx];
 
             action->state.pressed = record->event.pressed;
@@ -147,6 +209,7 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 #endif
                 action->state.weak_mods = get_mods();
                 action->state.weak_mods |= get_weak_mods();
+                active_td_start(idx, action->state.timer + (action->custom_tapping_term > 0 ? action->custom_tapping_term : TAPPING_TERM));
                 process_tap_dance_action_on_each_tap(action);
 
                 last_td = keycode;
@@ -163,20 +226,17 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 }
 
 void matrix_scan_tap_dance() {
-    if (highest_td == -1) return;
-    uint16_t tap_user_defined;
-
-    for (uint8_t i = 0; i <= highest_td; i++) {
-        qk_tap_dance_action_t *action = &tap_dance_actions[i];
-        if (action->custom_tapping_term > 0) {
-            tap_user_defined = action->custom_tapping_term;
-        } else {
-            tap_user_defined = TAPPING_TERM;
-        }
-        if (action->state.count && timer_elapsed(action->state.timer) > tap_user_defined) {
-            process_tap_dance_action_on_dance_finished(action);
-            reset_tap_dance(&action->state);
+    if (active_td_count == 0) return;
+    uint16_t now = timer_read();
+
+    for (uint8_t i = 0; i < active_td_count;) {
+        uint8_t index = active_td[i].index;
+
+        // Times out once more than the tapping term has passed
+        if (active_td[i].deadline != now && timer_expired(now, active_td[i].deadline)) {
+            active_td_finish(i);
         }
+        if (i < active_td_count && active_td[i].index == index) i++;
     }
 }
 
@@ -194,4 +254,5 @@ void reset_tap_dance(qk_tap_dance_state_t *state) {
     state->finished             = false;
     state->interrupting_keycode = 0;
     last_td                     = 0;
+    active_td_remove(state->keycode - QK_TAP_DANCE);
 }
@@ -15,12 +15,87 @@
  */
 
 #include "process_ucis.h"
+#include <string.h>
 
 qk_ucis_state_t qk_ucis_state;
 
+/* When the symbol table is in alphabetical order, the entries starting
+ * with what has been typed so far form a run [ucis_first, ucis_last).
+ * Each key narrows it with two binary searches, so finding the symbol
+ * takes O(log n) per key rather than a walk over the whole table.
+ * Unsorted tables fall back to the linear walk.
+ */
+static uint16_t ucis_symbol_count;
+static bool     ucis_sorted;
+static uint16_t ucis_first;
+static uint16_t ucis_last;
+
+static void ucis_check_table(void) {
+    static bool checked = false;
+
+    if (checked) return;
+    checked     = true;
+    ucis_sorted = true;
+    for (ucis_symbol_count = 0; ucis_symbol_table[ucis_symbol_count].symbol; ucis_symbol_count++) {
+        if (ucis_symbol_count > 0 && strcmp(ucis_symbol_table[ucis_symbol_count - 1].symbol, ucis_symbol_table[ucis_symbol_count].symbol) > 0) {
+            ucis_sorted = false;
+        }
+    }
+    if (!ucis_sorted) {
+        dprintln("UCIS: symbol table is not sorted, using linear lookup");
+    }
+}
+
+/* The mnemonic character for a keycode. Anything else sorts after every
+ * symbol character and so never matches. */
+static uint8_t ucis_char(uint16_t keycode) {
+    switch (keycode) {
+        case KC_A ... KC_Z:
+            return keycode - KC_A + 'a';
+        case KC_1 ... KC_9:
+            return keycode - KC_1 + '1';
+        case KC_0:
+            return '0';
+    }
+    return 0xFF;
+}
+
+/* The first entry in [first, last) whose character at pos is above c, or
+ * at least c if inclusive. */
+static uint16_t ucis_bound(uint16_t first, uint16_t last, uint8_t pos, uint8_t c, bool inclusive) {
+    while (first < last) {
+        uint16_t mid = first + (last - first) / 2;
+        uint8_t  m   = ucis_symbol_table[mid].symbol[pos];
+        if (m < c || (!inclusive && m == c)) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+static void ucis_narrow(uint8_t pos) {
+    uint8_t c = ucis_char(qk_ucis_state.codes[pos]);
+
+    ucis_first = ucis_bound(ucis_first, ucis_last, pos, c, true);
+    ucis_last  = ucis_bound(ucis_first, ucis_last, pos, c, false);
+}
+
+static void ucis_reset_range(uint8_t length) {
+    ucis_first = 0;
+    ucis_last  = ucis_symbol_count;
+    if (!ucis_sorted) return;
+    for (uint8_t i = 0; i < length; i++) {
+        ucis_narrow(i);
+    }
+}
+
 void qk_ucis_start(void) {
+    ucis_check_table();
     qk_ucis_state.count       = 0;
     qk_ucis_state.in_progress = true;
+    ucis_reset_range(0);
 
     qk_ucis_start_user();
 }
@@ -37,23 +112,34 @@ static bool is_uni_seq(char *seq) {
     uint8_t i;
 
     for (i = 0; seq[i]; i++) {
-        uint16_t code;
-        if (('1' <= seq[i]) && (seq[i] <= '0'))
-            code = seq[i] - '1' + KC_1;
-        else
-            code = seq[i] - 'a' + KC_A;
-
-        if (i > qk_ucis_state.count || qk_ucis_state.codes[i] != code) return false;
+        if (i >= qk_ucis_state.count || ucis_char(qk_ucis_state.codes[i]) != (uint8_t)seq[i]) return false;
     }
 
     return (qk_ucis_state.codes[i] == KC_ENT || qk_ucis_state.codes[i] == KC_SPC);
 }
 
+/* The entry matching the typed mnemonic exactly, or -1. */
+static int16_t ucis_find(void) {
+    uint8_t length = qk_ucis_state.count - 1;
+
+    if (ucis_sorted) {
+        // A symbol that ends here sorts first in the run
+        if (ucis_first < ucis_last && ucis_symbol_table[ucis_first].symbol[length] == '\0') return ucis_first;
+        return -1;
+    }
+
+    for (uint16_t i = 0; i < ucis_symbol_count; i++) {
+        if (is_uni_seq(ucis_symbol_table[i].symbol)) return i;
+    }
+    return -1;
+}
+
 __attribute__((weak)) void qk_ucis_symbol_fallback(void) {
     for (uint8_t i = 0; i < qk_ucis_state.count - 1; i++) {
         uint8_t code = qk_ucis_state.codes[i];
         register_code(code);
         unregister_code(code);
+        host_keyboard_flush();
         wait_ms(UNICODE_TYPE_DELAY);
     }
 }
@@ -83,14 +169,38 @@ void register_ucis(const char *hex) {
         if (kc) {
             register_code(kc);
             unregister_code(kc);
+            host_keyboard_flush();
             wait_ms(UNICODE_TYPE_DELAY);
         }
     }
 }
 
-bool process_ucis(uint16_t keycode, keyrecord_t *record) {
-    uint8_t i;
+static void ucis_finish(int16_t index) {
+    unicode_input_start();
+    if (index >= 0) {
+        register_ucis(ucis_symbol_table[index].code + 2);
+    } else {
+        qk_ucis_symbol_fallback();
+    }
+    unicode_input_finish();
+
+    if (index >= 0) {
+        qk_ucis_success(index);
+    }
+
+    qk_ucis_state.in_progress = false;
+}
+
+static void ucis_erase(void) {
+    for (uint8_t i = qk_ucis_state.count; i > 0; i--) {
+        register_code(KC_BSPC);
+        unregister_code(KC_BSPC);
+        host_keyboard_flush();
+        wait_ms(UNICODE_TYPE_DELAY);
+    }
+}
 
+bool process_ucis(uint16_t keycode, keyrecord_t *record) {
     if (!qk_ucis_state.in_progress) return true;
 
     if (qk_ucis_state.count >= UCIS_MAX_SYMBOL_LENGTH && !(keycode == KC_BSPC || keycode == KC_ESC || keycode == KC_SPC || keycode == KC_ENT)) {
@@ -105,6 +215,7 @@ bool process_ucis(uint16_t keycode, keyrecord_t *record) {
     if (keycode == KC_BSPC) {
         if (qk_ucis_state.count >= 2) {
             qk_ucis_state.count -= 2;
+            ucis_reset_range(qk_ucis_state.count);
             return true;
         } else {
             qk_ucis_state.count--;
@@ -113,13 +224,7 @@ bool process_ucis(uint16_t keycode, keyrecord_t *record) {
     }
 
     if (keycode == KC_ENT || keycode == KC_SPC || keycode == KC_ESC) {
-        bool symbol_found = false;
-
-        for (i = qk_ucis_state.count; i > 0; i--) {
-            register_code(KC_BSPC);
-            unregister_code(KC_BSPC);
-            wait_ms(UNICODE_TYPE_DELAY);
-        }
+        ucis_erase();
 
         if (keycode == KC_ESC) {
             qk_ucis_state.in_progress = false;
@@ -127,25 +232,20 @@ bool process_ucis(uint16_t keycode, keyrecord_t *record) {
             return false;
         }
 
-        unicode_input_start();
-        for (i = 0; ucis_symbol_table[i].symbol; i++) {
-            if (is_uni_seq(ucis_symbol_table[i].symbol)) {
-                symbol_found = true;
-                register_ucis(ucis_symbol_table[i].code + 2);
-                break;
-            }
-        }
-        if (!symbol_found) {
-            qk_ucis_symbol_fallback();
-        }
-        unicode_input_finish();
+        ucis_finish(ucis_find());
+        return false;
+    }
 
-        if (symbol_found) {
-            qk_ucis_success(i);
+    if (ucis_sorted) {
+        ucis_narrow(qk_ucis_state.count - 1);
+#ifdef UCIS_COMPLETE_UNIQUE
+        // Only one symbol starts like this, no need to wait for Space
+        if (ucis_last - ucis_first == 1) {
+            ucis_erase();
+            ucis_finish(ucis_first);
+            return false;
         }
-
-        qk_ucis_state.in_progress = false;
-        return false;
+#endif
     }
     return true;
 }
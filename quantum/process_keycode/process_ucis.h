@@ -30,7 +30,7 @@ typedef struct {
 
 typedef struct {
     uint8_t  count;
-    uint16_t codes[UCIS_MAX_SYMBOL_LENGTH];
+    uint16_t codes[UCIS_MAX_SYMBOL_LENGTH + 1];  // room for the final Space or Enter
     bool     in_progress : 1;
 } qk_ucis_state_t;
 
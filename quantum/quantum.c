@@ -109,6 +109,7 @@ void unregister_code16(uint16_t code) {
 void tap_code16(uint16_t code) {
     register_code16(code);
 #if TAP_CODE_DELAY > 0
+    host_keyboard_flush();
     wait_ms(TAP_CODE_DELAY);
 #endif
     unregister_code16(code);
@@ -122,6 +123,7 @@ __attribute__((weak)) bool process_record_user(uint16_t keycode, keyrecord_t *re
 
 void reset_keyboard(void) {
     clear_keyboard();
+    host_keyboard_flush();
 #if defined(MIDI_ENABLE) && defined(MIDI_BASIC)
     process_midi_all_notes_off();
 #endif
@@ -141,6 +143,7 @@ void reset_keyboard(void) {
 #ifdef HAPTIC_ENABLE
     haptic_shutdown();
 #endif
+    eeconfig_flush();
 // this is also done later in bootloader.c - not sure if it's neccesary here
 #ifdef BOOTLOADER_CATERINA
     *(uint16_t *)0x0800 = 0x7777;  // these two are a-star-specific
@@ -172,6 +175,26 @@ uint16_t get_event_keycode(keyevent_t event) {
         return keymap_key_to_keycode(layer_switch_get_layer(event.key), event.key);
 }
 
+/* Handlers that only act on their feature's own keycodes are routed: they are
+ * skipped for keycodes outside their ranges. All feature keycodes sit at or
+ * above FEATURE_KEYCODE_MIN, so plain keys, mods and layer keys skip each of
+ * them on a single comparison. Handlers that watch every event (key lock,
+ * dynamic macros, clicky, combos, tap dance and the like) are always called.
+ */
+#ifdef STENO_ENABLE
+#    define FEATURE_KEYCODE_MIN QK_STENO
+#else
+#    define FEATURE_KEYCODE_MIN RESET
+#endif
+
+#if defined(UNICODE_ENABLE)
+#    define UNICODE_KEYCODE_MIN QK_UNICODE
+#elif defined(UNICODEMAP_ENABLE)
+#    define UNICODE_KEYCODE_MIN QK_UNICODEMAP
+#endif
+
+#define IS_FEATURE_KEYCODE(keycode, min, max) ((keycode) >= FEATURE_KEYCODE_MIN && (uint16_t)((keycode) - (min)) <= (uint16_t)((max) - (min)))
+
 /* Main keycode processing function. Hands off handling to other functions,
  * then processes internal Quantum keycodes, then processes ACTIONs.
  */
@@ -196,11 +219,14 @@ bool process_record_quantum(keyrecord_t *record) {
     preprocess_tap_dance(keycode, record);
 #endif
 
-    if (!(
 #if defined(KEY_LOCK_ENABLE)
-            // Must run first to be able to mask key_up events.
-            process_key_lock(&keycode, record) &&
+    // Must run first to be able to mask key_up events.
+    if (!process_key_lock(&keycode, record)) {
+        return false;
+    }
 #endif
+
+    if (!(
 #if defined(DYNAMIC_MACRO_ENABLE) && !defined(DYNAMIC_MACRO_USER_CALL)
             // Must run asap to ensure all keypresses are recorded.
             process_dynamic_macro(keycode, record) &&
@@ -216,13 +242,13 @@ bool process_record_quantum(keyrecord_t *record) {
 #endif
             process_record_kb(keycode, record) &&
 #if defined(MIDI_ENABLE) && defined(MIDI_ADVANCED)
-            process_midi(keycode, record) &&
+            (!IS_FEATURE_KEYCODE(keycode, MIDI_TONE_MIN, MI_BENDU) || process_midi(keycode, record)) &&
 #endif
 #ifdef AUDIO_ENABLE
-            process_audio(keycode, record) &&
+            (!IS_FEATURE_KEYCODE(keycode, AU_ON, MUV_DE) || process_audio(keycode, record)) &&
 #endif
 #ifdef STENO_ENABLE
-            process_steno(keycode, record) &&
+            (!IS_FEATURE_KEYCODE(keycode, QK_STENO, QK_STENO_MAX) || process_steno(keycode, record)) &&
 #endif
 #if (defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))) && !defined(NO_MUSIC_MODE)
             process_music(keycode, record) &&
@@ -230,7 +256,10 @@ bool process_record_quantum(keyrecord_t *record) {
 #ifdef TAP_DANCE_ENABLE
             process_tap_dance(keycode, record) &&
 #endif
-#if defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE) || defined(UCIS_ENABLE)
+#if defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE)
+            (!(IS_FEATURE_KEYCODE(keycode, UNICODE_MODE_FORWARD, UNICODE_MODE_WINC) || keycode >= UNICODE_KEYCODE_MIN) || process_unicode_common(keycode, record)) &&
+#elif defined(UCIS_ENABLE)
+            // UCIS reads every keypress while it is active
             process_unicode_common(keycode, record) &&
 #endif
 #ifdef LEADER_ENABLE
@@ -252,7 +281,7 @@ bool process_record_quantum(keyrecord_t *record) {
             process_space_cadet(keycode, record) &&
 #endif
 #ifdef MAGIC_KEYCODE_ENABLE
-            process_magic(keycode, record) &&
+            (!(IS_FEATURE_KEYCODE(keycode, MAGIC_SWAP_CONTROL_CAPSLOCK, MAGIC_TOGGLE_ALT_GUI) || IS_FEATURE_KEYCODE(keycode, MAGIC_SWAP_LCTL_LGUI, MAGIC_EE_HANDS_RIGHT)) || process_magic(keycode, record)) &&
 #endif
             true)) {
         return false;
@@ -589,6 +618,7 @@ void send_string_with_delay(const char *str, uint8_t interval) {
         // interval
         {
             uint8_t ms = interval;
+            if (ms) host_keyboard_flush();
             while (ms--) wait_ms(1);
         }
     }
@@ -618,6 +648,7 @@ void send_string_with_delay_P(const char *str, uint8_t interval) {
         // interval
         {
             uint8_t ms = interval;
+            if (ms) host_keyboard_flush();
             while (ms--) wait_ms(1);
         }
     }
@@ -725,6 +756,34 @@ __attribute__((weak)) void bootmagic_lite(void) {
     }
 }
 
+static inline bool peripherals_ready(void) {
+#ifdef FAST_BOOT_ENABLE
+    return keyboard_peripherals_ready();
+#else
+    return true;
+#endif
+}
+
+#ifdef FAST_BOOT_ENABLE
+/* These wait until the host is ready so the matrix is scanned as early as
+ * possible. Without FAST_BOOT_ENABLE matrix_init_quantum() runs them.
+ */
+void keyboard_deferred_init_quantum(void) {
+#    if defined(BACKLIGHT_ENABLE) && defined(LED_MATRIX_ENABLE)
+    led_matrix_init();
+#    endif
+#    ifdef AUDIO_ENABLE
+    audio_init();
+#    endif
+#    ifdef RGB_MATRIX_ENABLE
+    rgb_matrix_init();
+#    endif
+#    ifdef HAPTIC_ENABLE
+    haptic_init();
+#    endif
+}
+#endif
+
 void matrix_init_quantum() {
 #ifdef BOOTMAGIC_LITE
     bootmagic_lite();
@@ -734,15 +793,17 @@ void matrix_init_quantum() {
     }
 #ifdef BACKLIGHT_ENABLE
 #    ifdef LED_MATRIX_ENABLE
+#        ifndef FAST_BOOT_ENABLE
     led_matrix_init();
+#        endif
 #    else
     backlight_init_ports();
 #    endif
 #endif
-#ifdef AUDIO_ENABLE
+#if defined(AUDIO_ENABLE) && !defined(FAST_BOOT_ENABLE)
     audio_init();
 #endif
-#ifdef RGB_MATRIX_ENABLE
+#if defined(RGB_MATRIX_ENABLE) && !defined(FAST_BOOT_ENABLE)
     rgb_matrix_init();
 #endif
 #ifdef ENCODER_ENABLE
@@ -751,7 +812,7 @@ void matrix_init_quantum() {
 #if defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE) || defined(UCIS_ENABLE)
     unicode_input_mode_init();
 #endif
-#ifdef HAPTIC_ENABLE
+#if defined(HAPTIC_ENABLE) && !defined(FAST_BOOT_ENABLE)
     haptic_init();
 #endif
 #ifdef OUTPUT_AUTO_ENABLE
@@ -760,6 +821,9 @@ void matrix_init_quantum() {
 #ifdef DIP_SWITCH_ENABLE
     dip_switch_init();
 #endif
+#ifdef DYNAMIC_MACRO_ENABLE
+    dynamic_macro_init();
+#endif
 
     matrix_init_kb();
 }
@@ -777,16 +841,24 @@ void matrix_scan_quantum() {
     matrix_scan_combo();
 #endif
 
+#ifdef DYNAMIC_MACRO_ENABLE
+    dynamic_macro_task();
+#endif
+
 #if defined(BACKLIGHT_ENABLE)
 #    if defined(LED_MATRIX_ENABLE)
-    led_matrix_task();
+    if (peripherals_ready()) {
+        led_matrix_task();
+    }
 #    elif defined(BACKLIGHT_PIN) || defined(BACKLIGHT_PINS)
     backlight_task();
 #    endif
 #endif
 
 #ifdef RGB_MATRIX_ENABLE
-    rgb_matrix_task();
+    if (peripherals_ready()) {
+        rgb_matrix_task();
+    }
 #endif
 
 #ifdef ENCODER_ENABLE
@@ -794,13 +866,19 @@ void matrix_scan_quantum() {
 #endif
 
 #ifdef HAPTIC_ENABLE
-    haptic_task();
+    if (peripherals_ready()) {
+        haptic_task();
+    }
 #endif
 
 #ifdef DIP_SWITCH_ENABLE
     dip_switch_read(false);
 #endif
 
+#if defined(DYNAMIC_KEYMAP_STREAM_ENABLE) && defined(RAW_ENABLE)
+    dynamic_keymap_stream_task();
+#endif
+
     matrix_scan_kb();
 }
 
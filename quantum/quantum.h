@@ -153,6 +153,10 @@ extern layer_state_t layer_state;
 #    include "dip_switch.h"
 #endif
 
+#ifdef DYNAMIC_KEYMAP_STREAM_ENABLE
+#    include "dynamic_keymap_stream.h"
+#endif
+
 #ifdef DYNAMIC_MACRO_ENABLE
 #    include "process_dynamic_macro.h"
 #endif
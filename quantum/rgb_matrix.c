@@ -19,11 +19,12 @@
 #include "rgb_matrix.h"
 #include "progmem.h"
 #include "config.h"
-#include "eeprom.h"
+#include "eeconfig.h"
 #include <string.h>
 #include <math.h>
 
 #include "lib/lib8tion/lib8tion.h"
+#include "animation_clock.h"
 
 #ifndef RGB_MATRIX_CENTER
 const point_t k_rgb_matrix_center = {112, 32};
@@ -103,17 +104,107 @@ rgb_counters_t  g_rgb_counters;
 static uint32_t rgb_counters_buffer;
 
 #ifdef RGB_MATRIX_FRAMEBUFFER_EFFECTS
-uint8_t rgb_frame_buffer[MATRIX_ROWS][MATRIX_COLS] = {{0}};
-#endif
+#    if MATRIX_ROWS * MATRIX_COLS > 255
+#        error "RGB_MATRIX_FRAMEBUFFER_EFFECTS numbers matrix cells with a uint8_t, so MATRIX_ROWS * MATRIX_COLS must be 255 or less"
+#    endif
+
+// Cells that are lit, what they were last set to and when. Values fade when
+// read, so nothing walks the buffer between keypresses.
+static struct {
+    uint8_t  active[(MATRIX_ROWS * MATRIX_COLS + 7) / 8];
+    uint8_t  value[MATRIX_ROWS][MATRIX_COLS];
+    uint16_t time[MATRIX_ROWS][MATRIX_COLS];
+} rgb_frame_buffer;
+
+#    define FRAME_BUFFER_CELL(row, col) ((row)*MATRIX_COLS + (col))
+
+void rgb_frame_buffer_clear(void) { memset(rgb_frame_buffer.active, 0, sizeof(rgb_frame_buffer.active)); }
+
+void rgb_frame_buffer_set(uint8_t row, uint8_t col, uint8_t value) {
+    uint8_t cell = FRAME_BUFFER_CELL(row, col);
+    if (!value) {
+        rgb_frame_buffer.active[cell / 8] &= ~(1 << (cell % 8));
+        return;
+    }
+    rgb_frame_buffer.active[cell / 8] |= 1 << (cell % 8);
+    rgb_frame_buffer.value[row][col] = value;
+    rgb_frame_buffer.time[row][col]  = animation_clock_read();
+}
+
+uint8_t rgb_frame_buffer_get(uint8_t row, uint8_t col, uint16_t interval) {
+    uint8_t cell = FRAME_BUFFER_CELL(row, col);
+    if (!(rgb_frame_buffer.active[cell / 8] & (1 << (cell % 8)))) {
+        return 0;
+    }
+
+    uint16_t elapsed = (uint16_t)animation_clock_read() - rgb_frame_buffer.time[row][col];
+    if (elapsed >= interval) {
+        uint16_t faded = elapsed / interval;
+        if (faded >= rgb_frame_buffer.value[row][col]) {
+            rgb_frame_buffer.active[cell / 8] &= ~(1 << (cell % 8));
+            return 0;
+        }
+        // Keep the stamp within an interval of now, so the 16 bit clock
+        // can't wrap while a slow fade is still running
+        rgb_frame_buffer.value[row][col] -= faded;
+        rgb_frame_buffer.time[row][col] += faded * interval;
+    }
+    return rgb_frame_buffer.value[row][col];
+}
+
+uint8_t rgb_frame_buffer_next(uint8_t cell, uint8_t end) {
+    uint16_t i = cell;
+    while (i < end) {
+        uint8_t bits = rgb_frame_buffer.active[i / 8] >> (i % 8);
+        if (!bits) {
+            // Nothing lit in the rest of this byte
+            i = (i | 7) + 1;
+            continue;
+        }
+        while (!(bits & 1)) {
+            bits >>= 1;
+            i++;
+        }
+        break;
+    }
+    return i < end ? i : end;
+}
+#endif  // RGB_MATRIX_FRAMEBUFFER_EFFECTS
 
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
-last_hit_t        g_last_hit_tracker;
-static last_hit_t last_hit_buffer;
+last_hit_t g_last_hit_tracker;
+
+// Hits in the order they happened, stamped with the animation clock. Nothing
+// touches them between frames, they are dropped from the front once expired.
+static struct {
+    uint8_t  count;
+    uint8_t  x[LED_HITS_TO_REMEMBER];
+    uint8_t  y[LED_HITS_TO_REMEMBER];
+    uint8_t  index[LED_HITS_TO_REMEMBER];
+    uint32_t time[LED_HITS_TO_REMEMBER];
+} last_hit_buffer;
+
+static void last_hit_drop(uint8_t n) {
+    uint8_t left = last_hit_buffer.count - n;
+    memmove(&last_hit_buffer.x[0], &last_hit_buffer.x[n], left);
+    memmove(&last_hit_buffer.y[0], &last_hit_buffer.y[n], left);
+    memmove(&last_hit_buffer.index[0], &last_hit_buffer.index[n], left);
+    memmove(&last_hit_buffer.time[0], &last_hit_buffer.time[n], left * sizeof(uint32_t));
+    last_hit_buffer.count = left;
+}
+
+// How long a hit can still light anything. Every reactive effect is done
+// with an LED once its scaled tick is 255 past the LED's distance, and no
+// distance is over 255.
+static uint32_t last_hit_lifetime(void) {
+    uint32_t lifetime = (510UL << 8) / (rgb_matrix_config.speed + 1) + 1;
+    return lifetime < UINT16_MAX ? lifetime : UINT16_MAX;
+}
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
 
-void eeconfig_read_rgb_matrix(void) { eeprom_read_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
+void eeconfig_read_rgb_matrix(void) { eeconfig_read_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
 
-void eeconfig_update_rgb_matrix(void) { eeprom_update_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
+void eeconfig_update_rgb_matrix(void) { eeconfig_update_block(&rgb_matrix_config, EECONFIG_RGB_MATRIX, sizeof(rgb_matrix_config)); }
 
 void eeconfig_update_rgb_matrix_default(void) {
     dprintf("eeconfig_update_rgb_matrix_default\n");
@@ -170,19 +261,16 @@ bool process_rgb_matrix(uint16_t keycode, keyrecord_t *record) {
 #    endif  // defined(RGB_MATRIX_KEYRELEASES)
 
     if (last_hit_buffer.count + led_count > LED_HITS_TO_REMEMBER) {
-        memcpy(&last_hit_buffer.x[0], &last_hit_buffer.x[led_count], LED_HITS_TO_REMEMBER - led_count);
-        memcpy(&last_hit_buffer.y[0], &last_hit_buffer.y[led_count], LED_HITS_TO_REMEMBER - led_count);
-        memcpy(&last_hit_buffer.tick[0], &last_hit_buffer.tick[led_count], (LED_HITS_TO_REMEMBER - led_count) * 2);  // 16 bit
-        memcpy(&last_hit_buffer.index[0], &last_hit_buffer.index[led_count], LED_HITS_TO_REMEMBER - led_count);
-        last_hit_buffer.count--;
+        last_hit_drop(last_hit_buffer.count + led_count - LED_HITS_TO_REMEMBER);
     }
 
+    uint32_t now = animation_clock_read();
     for (uint8_t i = 0; i < led_count; i++) {
         uint8_t index                = last_hit_buffer.count;
         last_hit_buffer.x[index]     = g_led_config.point[led[i]].x;
         last_hit_buffer.y[index]     = g_led_config.point[led[i]].y;
         last_hit_buffer.index[index] = led[i];
-        last_hit_buffer.tick[index]  = 0;
+        last_hit_buffer.time[index]  = now;
         last_hit_buffer.count++;
     }
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
@@ -235,12 +323,49 @@ static bool rgb_matrix_none(effect_params_t *params) {
 static uint8_t         rgb_last_enable   = UINT8_MAX;
 static uint8_t         rgb_last_effect   = UINT8_MAX;
 static effect_params_t rgb_effect_params = {0, 0xFF};
+
+#if defined(RGB_MATRIX_LED_PROCESS_LIMIT) && RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL
+#    define RGB_MATRIX_LED_CHUNK RGB_MATRIX_LED_PROCESS_LIMIT
+#else
+#    define RGB_MATRIX_LED_CHUNK UINT8_MAX
+#endif
+
+#ifdef RGB_MATRIX_RENDER_BUDGET
+// Render time of one LED with the current effect, in 1/256 us
+static uint32_t rgb_render_cost     = 0;
+static bool     rgb_render_measured = false;
+
+static uint8_t rgb_render_chunk(void) {
+    if (!rgb_render_measured) return RGB_MATRIX_LED_CHUNK;
+    if (!rgb_render_cost) return UINT8_MAX;
+
+    uint32_t leds = ((uint32_t)RGB_MATRIX_RENDER_BUDGET << 8) / rgb_render_cost;
+    return leds < 1 ? 1 : leds > UINT8_MAX ? UINT8_MAX : leds;
+}
+
+static void rgb_render_measure(uint16_t elapsed, bool rendering) {
+    uint8_t leds = rgb_effect_params.led_count;
+    // The last call of a frame only renders what was left
+    if (!rendering && DRIVER_LED_TOTAL > rgb_effect_params.led_start && DRIVER_LED_TOTAL - rgb_effect_params.led_start < leds) {
+        leds = DRIVER_LED_TOTAL - rgb_effect_params.led_start;
+    }
+
+    uint32_t sample = ((uint32_t)elapsed << 8) / leds;
+    if (!rgb_render_measured) {
+        rgb_render_cost     = sample;
+        rgb_render_measured = true;
+    } else {
+        // Average over a few calls, coarse timers only show up as an average
+        rgb_render_cost = rgb_render_cost - rgb_render_cost / 4 + sample / 4;
+    }
+}
+#endif
 static rgb_task_states rgb_task_state    = SYNCING;
 
 static void rgb_task_timers(void) {
     // Update double buffer timers
-    uint16_t deltaTime  = timer_elapsed32(rgb_counters_buffer);
-    rgb_counters_buffer = timer_read32();
+    uint32_t deltaTime  = animation_clock_elapsed(rgb_counters_buffer);
+    rgb_counters_buffer = animation_clock_read();
     if (g_rgb_counters.any_key_hit < UINT32_MAX) {
         if (UINT32_MAX - deltaTime < g_rgb_counters.any_key_hit) {
             g_rgb_counters.any_key_hit = UINT32_MAX;
@@ -248,33 +373,44 @@ static void rgb_task_timers(void) {
             g_rgb_counters.any_key_hit += deltaTime;
         }
     }
-
-    // Update double buffer last hit timers
-#ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
-    uint8_t count = last_hit_buffer.count;
-    for (uint8_t i = 0; i < count; ++i) {
-        if (UINT16_MAX - deltaTime < last_hit_buffer.tick[i]) {
-            last_hit_buffer.count--;
-            continue;
-        }
-        last_hit_buffer.tick[i] += deltaTime;
-    }
-#endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
 }
 
 static void rgb_task_sync(void) {
     // next task
-    if (timer_elapsed32(g_rgb_counters.tick) >= RGB_MATRIX_LED_FLUSH_LIMIT) rgb_task_state = STARTING;
+    if (animation_clock_elapsed(g_rgb_counters.tick) >= RGB_MATRIX_LED_FLUSH_LIMIT) rgb_task_state = STARTING;
 }
 
 static void rgb_task_start(void) {
     // reset iter
-    rgb_effect_params.iter = 0;
+    rgb_effect_params.iter      = 0;
+    rgb_effect_params.led_start = 0;
+#ifdef RGB_MATRIX_RENDER_BUDGET
+    rgb_effect_params.led_count = rgb_render_chunk();
+#else
+    rgb_effect_params.led_count = RGB_MATRIX_LED_CHUNK;
+#endif
 
     // update double buffers
     g_rgb_counters.tick = rgb_counters_buffer;
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
-    g_last_hit_tracker = last_hit_buffer;
+    // Expire old hits, then hand the effects their ages for this frame
+    uint32_t lifetime = last_hit_lifetime();
+    uint8_t  expired  = 0;
+    while (expired < last_hit_buffer.count && g_rgb_counters.tick - last_hit_buffer.time[expired] >= lifetime) {
+        expired++;
+    }
+    if (expired) {
+        last_hit_drop(expired);
+    }
+
+    uint8_t count            = last_hit_buffer.count;
+    g_last_hit_tracker.count = count;
+    memcpy(g_last_hit_tracker.x, last_hit_buffer.x, count);
+    memcpy(g_last_hit_tracker.y, last_hit_buffer.y, count);
+    memcpy(g_last_hit_tracker.index, last_hit_buffer.index, count);
+    for (uint8_t i = 0; i < count; i++) {
+        g_last_hit_tracker.tick[i] = g_rgb_counters.tick - last_hit_buffer.time[i];
+    }
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
 
     // next task
@@ -284,6 +420,12 @@ static void rgb_task_start(void) {
 static void rgb_task_render(uint8_t effect) {
     bool rendering         = false;
     rgb_effect_params.init = (effect != rgb_last_effect) || (rgb_matrix_config.enable != rgb_last_enable);
+#ifdef RGB_MATRIX_RENDER_BUDGET
+    if (rgb_effect_params.init && rgb_effect_params.iter == 0) {
+        rgb_render_measured = false;
+    }
+    uint16_t render_start = timer_read_us();
+#endif
 
     // each effect can opt to do calculations
     // and/or request PWM buffer updates.
@@ -325,7 +467,15 @@ static void rgb_task_render(uint8_t effect) {
             return;
     }
 
+#ifdef RGB_MATRIX_RENDER_BUDGET
+    // Init frames clear buffers and aren't representative
+    if (!rgb_effect_params.init) {
+        rgb_render_measure(timer_read_us() - render_start, rendering);
+    }
+#endif
+
     rgb_effect_params.iter++;
+    rgb_effect_params.led_start += rgb_effect_params.led_count;
 
     // next task
     if (!rendering) {
@@ -398,9 +548,6 @@ void rgb_matrix_init(void) {
     }
 
     last_hit_buffer.count = 0;
-    for (uint8_t i = 0; i < LED_HITS_TO_REMEMBER; ++i) {
-        last_hit_buffer.tick[i] = UINT16_MAX;
-    }
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
 
     if (!eeconfig_is_enabled()) {
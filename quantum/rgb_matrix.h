@@ -44,16 +44,17 @@
 #    define RGB_MATRIX_LED_PROCESS_LIMIT (DRIVER_LED_TOTAL + 4) / 5
 #endif
 
-#if defined(RGB_MATRIX_LED_PROCESS_LIMIT) && RGB_MATRIX_LED_PROCESS_LIMIT > 0 && RGB_MATRIX_LED_PROCESS_LIMIT < DRIVER_LED_TOTAL
-#    define RGB_MATRIX_USE_LIMITS(min, max)                        \
-        uint8_t min = RGB_MATRIX_LED_PROCESS_LIMIT * params->iter; \
-        uint8_t max = min + RGB_MATRIX_LED_PROCESS_LIMIT;          \
-        if (max > DRIVER_LED_TOTAL) max = DRIVER_LED_TOTAL;
-#else
-#    define RGB_MATRIX_USE_LIMITS(min, max) \
-        uint8_t min = 0;                    \
-        uint8_t max = DRIVER_LED_TOTAL;
-#endif
+// Renders a frame over several rgb_matrix_task() calls. With a budget in
+// microseconds the number of LEDs per call follows the measured cost of the
+// current effect, otherwise it is RGB_MATRIX_LED_PROCESS_LIMIT.
+// #define RGB_MATRIX_RENDER_BUDGET 100
+
+#define RGB_MATRIX_USE_LIMITS_ITER(min, max, total) \
+    uint8_t min = params->led_start;                \
+    uint8_t max = total;                            \
+    if (params->led_count < max - min) max = min + params->led_count;
+
+#define RGB_MATRIX_USE_LIMITS(min, max) RGB_MATRIX_USE_LIMITS_ITER(min, max, DRIVER_LED_TOTAL)
 
 #define RGB_MATRIX_TEST_LED_FLAGS() \
     if (!HAS_ANY_FLAGS(g_led_config.flags[i], params->flags)) continue
@@ -172,7 +173,16 @@ extern led_config_t   g_led_config;
 extern last_hit_t g_last_hit_tracker;
 #endif
 #ifdef RGB_MATRIX_FRAMEBUFFER_EFFECTS
-extern uint8_t rgb_frame_buffer[MATRIX_ROWS][MATRIX_COLS];
+// A value per matrix cell for effects that track keys rather than LEDs. Only
+// cells set since they last faded out are active. A value fades by one every
+// interval milliseconds, worked out when it is read, which also deactivates
+// the cell once it reaches zero. Active cells must be read at least once a
+// minute, as effects do every frame.
+void    rgb_frame_buffer_clear(void);
+void    rgb_frame_buffer_set(uint8_t row, uint8_t col, uint8_t value);
+uint8_t rgb_frame_buffer_get(uint8_t row, uint8_t col, uint16_t interval);
+// First active cell from cell on, numbered row * MATRIX_COLS + col, or end if none
+uint8_t rgb_frame_buffer_next(uint8_t cell, uint8_t end);
 #endif
 
 #endif
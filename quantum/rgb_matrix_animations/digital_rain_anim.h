@@ -7,64 +7,79 @@ RGB_MATRIX_EFFECT(DIGITAL_RAIN)
 #            define RGB_DIGITAL_RAIN_DROPS 24
 #        endif
 
-bool DIGITAL_RAIN(effect_params_t* params) {
+#        ifndef RGB_DIGITAL_RAIN_DECAY_MS
+// how long a trail takes to fade by one step, drops fall a row every 29 steps
+#            define RGB_DIGITAL_RAIN_DECAY_MS RGB_MATRIX_LED_FLUSH_LIMIT
+#        endif
+
+// The bright head of each drop, a bit per column. Trails are left in the framebuffer.
+static uint8_t digital_rain_heads[MATRIX_ROWS][(MATRIX_COLS + 7) / 8];
+
+static void digital_rain_paint(uint8_t row, uint8_t col, uint8_t intensity) {
     // algorithm ported from https://github.com/tremby/Kaleidoscope-LEDEffect-DigitalRain
-    const uint8_t drop_ticks           = 28;
     const uint8_t pure_green_intensity = 0xd0;
     const uint8_t max_brightness_boost = 0xc0;
     const uint8_t max_intensity        = 0xff;
 
-    static uint8_t drop = 0;
+    RGB rgb = {0, 0, 0};
+    if (intensity > pure_green_intensity) {
+        const uint8_t boost = (uint8_t)((uint16_t)max_brightness_boost * (intensity - pure_green_intensity) / (max_intensity - pure_green_intensity));
+        rgb                 = (RGB){boost, max_intensity, boost};
+    } else {
+        rgb.g = (uint8_t)((uint16_t)max_intensity * intensity / pure_green_intensity);
+    }
+
+    uint8_t led[LED_HITS_TO_REMEMBER];
+    uint8_t led_count = rgb_matrix_map_row_column_to_led(row, col, led);
+    for (uint8_t i = 0; i < led_count; i++) {
+        rgb_matrix_set_color(led[i], rgb.r, rgb.g, rgb.b);
+    }
+}
+
+bool DIGITAL_RAIN(effect_params_t* params) {
+    const uint8_t drop_ticks = 28;
+
+    static uint32_t drop_timer = 0;
 
     if (params->init) {
         rgb_matrix_set_color_all(0, 0, 0);
-        memset(rgb_frame_buffer, 0, sizeof(rgb_frame_buffer));
-        drop = 0;
+        rgb_frame_buffer_clear();
+        memset(digital_rain_heads, 0, sizeof(digital_rain_heads));
+        drop_timer = animation_clock_read();
     }
 
-    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-            if (row == 0 && drop == 0 && rand() < RAND_MAX / RGB_DIGITAL_RAIN_DROPS) {
-                // top row, pixels have just fallen and we're
-                // making a new rain drop in this column
-                rgb_frame_buffer[row][col] = max_intensity;
-            } else if (rgb_frame_buffer[row][col] > 0 && rgb_frame_buffer[row][col] < max_intensity) {
-                // neither fully bright nor dark, decay it
-                rgb_frame_buffer[row][col]--;
-            }
-            // set the pixel colour
-            uint8_t led[LED_HITS_TO_REMEMBER];
-            uint8_t led_count = rgb_matrix_map_row_column_to_led(row, col, led);
-
-            // TODO: multiple leds are supported mapped to the same row/column
-            if (led_count > 0) {
-                if (rgb_frame_buffer[row][col] > pure_green_intensity) {
-                    const uint8_t boost = (uint8_t)((uint16_t)max_brightness_boost * (rgb_frame_buffer[row][col] - pure_green_intensity) / (max_intensity - pure_green_intensity));
-                    rgb_matrix_set_color(led[0], boost, max_intensity, boost);
-                } else {
-                    const uint8_t green = (uint8_t)((uint16_t)max_intensity * rgb_frame_buffer[row][col] / pure_green_intensity);
-                    rgb_matrix_set_color(led[0], 0, green, 0);
+    if (animation_clock_elapsed(drop_timer) > (uint32_t)drop_ticks * RGB_DIGITAL_RAIN_DECAY_MS) {
+        drop_timer = animation_clock_read();
+        // Move every head down a row from the bottom up, leaving a fading trail
+        for (uint8_t row = MATRIX_ROWS; row-- > 0;) {
+            for (uint8_t byte = 0; byte < sizeof(digital_rain_heads[row]); byte++) {
+                uint8_t heads = digital_rain_heads[row][byte];
+                for (uint8_t col = byte * 8; heads; heads >>= 1, col++) {
+                    if (heads & 1) rgb_frame_buffer_set(row, col, 0xfe);
                 }
+                if (row + 1 < MATRIX_ROWS) digital_rain_heads[row + 1][byte] = digital_rain_heads[row][byte];
+                digital_rain_heads[row][byte] = 0;
+            }
+        }
+        // Pixels have just fallen, start new drops on the top row
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (rand() < RAND_MAX / RGB_DIGITAL_RAIN_DROPS) {
+                digital_rain_heads[0][col / 8] |= 1 << (col % 8);
             }
         }
     }
 
-    if (++drop > drop_ticks) {
-        // reset drop timer
-        drop = 0;
-        for (uint8_t row = MATRIX_ROWS - 1; row > 0; row--) {
-            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-                // if ths is on the bottom row and bright allow decay
-                if (row == MATRIX_ROWS - 1 && rgb_frame_buffer[row][col] == max_intensity) {
-                    rgb_frame_buffer[row][col]--;
-                }
-                // check if the pixel above is bright
-                if (rgb_frame_buffer[row - 1][col] == max_intensity) {
-                    // allow old bright pixel to decay
-                    rgb_frame_buffer[row - 1][col]--;
-                    // make this pixel bright
-                    rgb_frame_buffer[row][col] = max_intensity;
-                }
+    const uint8_t cells = MATRIX_ROWS * MATRIX_COLS;
+    for (uint8_t i = rgb_frame_buffer_next(0, cells); i < cells; i = rgb_frame_buffer_next(i + 1, cells)) {
+        uint8_t row = i / MATRIX_COLS;
+        uint8_t col = i % MATRIX_COLS;
+        digital_rain_paint(row, col, rgb_frame_buffer_get(row, col, RGB_DIGITAL_RAIN_DECAY_MS));
+    }
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t byte = 0; byte < sizeof(digital_rain_heads[row]); byte++) {
+            uint8_t heads = digital_rain_heads[row][byte];
+            for (uint8_t col = byte * 8; heads; heads >>= 1, col++) {
+                if (heads & 1) digital_rain_paint(row, col, 0xff);
             }
         }
     }
@@ -7,17 +7,28 @@ typedef HSV (*reactive_splash_f)(HSV hsv, int16_t dx, int16_t dy, uint8_t dist,
 bool effect_runner_reactive_splash(uint8_t start, effect_params_t* params, reactive_splash_f effect_func) {
     RGB_MATRIX_USE_LIMITS(led_min, led_max);
 
-    uint8_t count = g_last_hit_tracker.count;
+    // Once a hit's tick is 255 past an LED's distance no effect lights that
+    // LED any more, so LEDs inside that radius skip the hit without working
+    // out the distance. Hits that have left every LED behind have already
+    // been expired.
+    uint8_t  count = g_last_hit_tracker.count;
+    uint16_t tick[LED_HITS_TO_REMEMBER];
+    uint32_t passed[LED_HITS_TO_REMEMBER];
+    for (uint8_t j = start; j < count; j++) {
+        tick[j]   = scale16by8(g_last_hit_tracker.tick[j], rgb_matrix_config.speed);
+        passed[j] = tick[j] >= 255 ? (uint32_t)(tick[j] - 254) * (tick[j] - 254) : 0;
+    }
+
     for (uint8_t i = led_min; i < led_max; i++) {
         RGB_MATRIX_TEST_LED_FLAGS();
         HSV hsv = rgb_matrix_config.hsv;
         hsv.v   = 0;
         for (uint8_t j = start; j < count; j++) {
-            int16_t  dx   = g_led_config.point[i].x - g_last_hit_tracker.x[j];
-            int16_t  dy   = g_led_config.point[i].y - g_last_hit_tracker.y[j];
-            uint8_t  dist = sqrt16(dx * dx + dy * dy);
-            uint16_t tick = scale16by8(g_last_hit_tracker.tick[j], rgb_matrix_config.speed);
-            hsv           = effect_func(hsv, dx, dy, dist, tick);
+            int16_t  dx    = g_led_config.point[i].x - g_last_hit_tracker.x[j];
+            int16_t  dy    = g_led_config.point[i].y - g_last_hit_tracker.y[j];
+            uint16_t dist2 = dx * dx + dy * dy;
+            if (dist2 < passed[j]) continue;
+            hsv = effect_func(hsv, dx, dy, sqrt16(dist2), tick[j]);
         }
         hsv.v   = scale8(hsv.v, rgb_matrix_config.hsv.v);
         RGB rgb = hsv_to_rgb(hsv);
@@ -41,12 +41,14 @@ typedef struct PACKED {
     uint8_t     iter;
     led_flags_t flags;
     bool        init;
+    uint8_t     led_start;  // first LED this call renders
+    uint8_t     led_count;  // how many LEDs it may render
 } effect_params_t;
 
 typedef struct PACKED {
-    // Global tick at 20 Hz
+    // Animation clock time of the frame being rendered, in milliseconds.
     uint32_t tick;
-    // Ticks since this key was last hit.
+    // Milliseconds since any key was last hit.
     uint32_t any_key_hit;
 } rgb_counters_t;
 
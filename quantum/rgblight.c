@@ -31,6 +31,7 @@
 #include "color.h"
 #include "debug.h"
 #include "led_tables.h"
+#include "animation_clock.h"
 #include "lib/lib8tion/lib8tion.h"
 #ifdef VELOCIKEY_ENABLE
 #    include "velocikey.h"
@@ -42,13 +43,13 @@
 #    define RGBLIGHT_SPLIT_SET_CHANGE_HSVS rgblight_status.change_flags |= RGBLIGHT_STATUS_CHANGE_HSVS
 #    define RGBLIGHT_SPLIT_SET_CHANGE_MODEHSVS rgblight_status.change_flags |= (RGBLIGHT_STATUS_CHANGE_MODE | RGBLIGHT_STATUS_CHANGE_HSVS)
 #    define RGBLIGHT_SPLIT_SET_CHANGE_TIMER_ENABLE rgblight_status.change_flags |= RGBLIGHT_STATUS_CHANGE_TIMER
-#    define RGBLIGHT_SPLIT_ANIMATION_TICK rgblight_status.change_flags |= RGBLIGHT_STATUS_ANIMATION_TICK
+#    define RGBLIGHT_SPLIT_ANIMATION_SYNC rgblight_status.change_flags |= RGBLIGHT_STATUS_ANIMATION_SYNC
 #else
 #    define RGBLIGHT_SPLIT_SET_CHANGE_MODE
 #    define RGBLIGHT_SPLIT_SET_CHANGE_HSVS
 #    define RGBLIGHT_SPLIT_SET_CHANGE_MODEHSVS
 #    define RGBLIGHT_SPLIT_SET_CHANGE_TIMER_ENABLE
-#    define RGBLIGHT_SPLIT_ANIMATION_TICK
+#    define RGBLIGHT_SPLIT_ANIMATION_SYNC
 #endif
 
 #define _RGBM_SINGLE_STATIC(sym) RGBLIGHT_MODE_##sym,
@@ -122,6 +123,16 @@ void sethsv_raw(uint8_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
 
 void sethsv(uint8_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) { sethsv_raw(hue, sat, val > RGBLIGHT_LIMIT_VAL ? RGBLIGHT_LIMIT_VAL : val, led1); }
 
+/* Effects that give every LED its own hue collect up to RGBLIGHT_HSV_BATCH
+ * colors on the stack and convert them with one hsv_to_rgb_batch() call.
+ * `end` is one past the last LED of the batch.
+ */
+#ifndef RGBLIGHT_HSV_BATCH
+#    define RGBLIGHT_HSV_BATCH 8
+#endif
+
+static inline void sethsv_batch(const HSV *hsv, uint8_t count, uint8_t end) { hsv_to_rgb_batch(hsv, (LED_TYPE *)&led[end - count], count, RGBLIGHT_LIMIT_VAL); }
+
 void setrgb(uint8_t r, uint8_t g, uint8_t b, LED_TYPE *led1) {
     (*led1).r = r;
     (*led1).g = g;
@@ -147,7 +158,9 @@ void rgblight_check_config(void) {
 
 uint32_t eeconfig_read_rgblight(void) {
 #if defined(__AVR__) || defined(STM32_EEPROM_ENABLE) || defined(PROTOCOL_ARM_ATSAM) || defined(EEPROM_SIZE)
-    return eeprom_read_dword(EECONFIG_RGBLIGHT);
+    uint32_t val;
+    eeconfig_read_block(&val, EECONFIG_RGBLIGHT, sizeof(val));
+    return val;
 #else
     return 0;
 #endif
@@ -156,7 +169,7 @@ uint32_t eeconfig_read_rgblight(void) {
 void eeconfig_update_rgblight(uint32_t val) {
 #if defined(__AVR__) || defined(STM32_EEPROM_ENABLE) || defined(PROTOCOL_ARM_ATSAM) || defined(EEPROM_SIZE)
     rgblight_check_config();
-    eeprom_update_dword(EECONFIG_RGBLIGHT, val);
+    eeconfig_update_block(&val, EECONFIG_RGBLIGHT, sizeof(val));
 #endif
 }
 
@@ -466,6 +479,8 @@ void rgblight_sethsv_eeprom_helper(uint8_t hue, uint8_t sat, uint8_t val, bool w
 #    else
                 uint8_t range = RGBLED_GRADIENT_RANGES[delta / 2];
 #    endif
+                HSV     hsv[RGBLIGHT_HSV_BATCH];
+                uint8_t n = 0;
                 for (uint8_t i = 0; i < effect_num_leds; i++) {
                     uint8_t _hue = ((uint16_t)i * (uint16_t)range) / effect_num_leds;
                     if (direction) {
@@ -474,7 +489,11 @@ void rgblight_sethsv_eeprom_helper(uint8_t hue, uint8_t sat, uint8_t val, bool w
                         _hue = hue - _hue;
                     }
                     dprintf("rgblight rainbow set hsv: %d,%d,%d,%u\n", i, _hue, direction, range);
-                    sethsv(_hue, sat, val, (LED_TYPE *)&led[i + effect_start_pos]);
+                    hsv[n] = (HSV){_hue, sat, val};
+                    if (++n == RGBLIGHT_HSV_BATCH || i + 1 == effect_num_leds) {
+                        sethsv_batch(hsv, n, i + 1 + effect_start_pos);
+                        n = 0;
+                    }
                 }
                 rgblight_set();
             }
@@ -633,6 +652,9 @@ void rgblight_clear_change_flags(void) { rgblight_status.change_flags = 0; }
 void rgblight_get_syncinfo(rgblight_syncinfo_t *syncinfo) {
     syncinfo->config = rgblight_config;
     syncinfo->status = rgblight_status;
+#    ifdef RGBLIGHT_USE_TIMER
+    syncinfo->time = animation_clock_read();
+#    endif
 }
 
 /* for split keyboard slave side */
@@ -658,7 +680,8 @@ void rgblight_update_sync(rgblight_syncinfo_t *syncinfo, bool write_to_eeprom) {
         }
     }
 #        ifndef RGBLIGHT_SPLIT_NO_ANIMATION_SYNC
-    if (syncinfo->status.change_flags & RGBLIGHT_STATUS_ANIMATION_TICK) {
+    if (syncinfo->status.change_flags & RGBLIGHT_STATUS_ANIMATION_SYNC) {
+        animation_clock_sync(syncinfo->time);
         animation_status.restart = true;
     }
 #        endif /* RGBLIGHT_SPLIT_NO_ANIMATION_SYNC */
@@ -695,7 +718,7 @@ void rgblight_timer_enable(void) {
     if (!is_static_effect(rgblight_config.mode)) {
         rgblight_status.timer_enabled = true;
     }
-    animation_status.last_timer = timer_read();
+    animation_status.restart = true;
     RGBLIGHT_SPLIT_SET_CHANGE_TIMER_ENABLE;
     dprintf("rgblight timer enabled.\n");
 }
@@ -727,7 +750,7 @@ static void rgblight_effect_dummy(animation_status_t *anim) {
     dprintf("mode = %d, base_mode = %d, timer_enabled %d, ",
             rgblight_config.mode, rgblight_status.base_mode,
             rgblight_status.timer_enabled);
-    dprintf("last_timer = %d\n",anim->last_timer);
+    dprintf("step = %lu\n",anim->step);
     **/
 }
 
@@ -796,33 +819,38 @@ void rgblight_task(void) {
             effect_func   = (effect_func_t)rgblight_effect_alternating;
         }
 #    endif
+
+        // Frames are numbered by how many intervals have passed on the
+        // animation clock, so the effect stays in time when the scan loop is
+        // slow and simply skips the frames it missed.
+        uint32_t now = animation_clock_read();
         if (animation_status.restart) {
-            animation_status.restart    = false;
-            animation_status.last_timer = timer_read() - interval_time - 1;
-            animation_status.pos16      = 0;  // restart signal to local each effect
+            // Count from the clock's origin, so split halves agree on the frame
+            animation_status.restart   = false;
+            animation_status.base_time = 0;
+            animation_status.base_step = 0;
+            animation_status.interval  = interval_time;
+            animation_status.next_time = now;
+        } else if (animation_status.interval != interval_time) {
+            // The speed changed (velocikey), carry on from the current frame
+            animation_status.base_time = now;
+            animation_status.base_step = animation_status.step;
+            animation_status.interval  = interval_time;
+            animation_status.next_time = now + interval_time;
         }
-        if (timer_elapsed(animation_status.last_timer) >= interval_time) {
 #    if defined(RGBLIGHT_SPLIT) && !defined(RGBLIGHT_SPLIT_NO_ANIMATION_SYNC)
-            static uint16_t report_last_timer = 0;
-            static bool     tick_flag         = false;
-            uint16_t        oldpos16;
-            if (tick_flag) {
-                tick_flag = false;
-                if (timer_elapsed(report_last_timer) >= 30000) {
-                    report_last_timer = timer_read();
-                    dprintf("rgblight animation tick report to slave\n");
-                    RGBLIGHT_SPLIT_ANIMATION_TICK;
-                }
-            }
-            oldpos16 = animation_status.pos16;
+        static uint32_t report_last_time = 0;
+        if (animation_clock_elapsed(report_last_time) >= RGBLIGHT_SPLIT_ANIMATION_SYNC_INTERVAL) {
+            report_last_time = now;
+            dprintf("rgblight animation time report to slave\n");
+            RGBLIGHT_SPLIT_ANIMATION_SYNC;
+        }
 #    endif
-            animation_status.last_timer += interval_time;
+        if (timer_expired32(now, animation_status.next_time)) {
+            uint32_t frames            = (now - animation_status.base_time) / interval_time;
+            animation_status.step      = animation_status.base_step + frames;
+            animation_status.next_time = animation_status.base_time + (frames + 1) * interval_time;
             effect_func(&animation_status);
-#    if defined(RGBLIGHT_SPLIT) && !defined(RGBLIGHT_SPLIT_NO_ANIMATION_SYNC)
-            if (animation_status.pos16 == 0 && oldpos16 != 0) {
-                tick_flag = true;
-            }
-#    endif
         }
     }
 }
@@ -842,16 +870,16 @@ void rgblight_task(void) {
 __attribute__((weak)) const uint8_t RGBLED_BREATHING_INTERVALS[] PROGMEM = {30, 20, 10, 5};
 
 void rgblight_effect_breathing(animation_status_t *anim) {
-    float val;
+    uint8_t pos = anim->step;
+    float   val;
 
     // http://sean.voisen.org/blog/2011/10/breathing-led-with-arduino/
 #    ifdef RGBLIGHT_EFFECT_BREATHE_TABLE
-    val = pgm_read_byte(&rgblight_effect_breathe_table[anim->pos / table_scale]);
+    val = pgm_read_byte(&rgblight_effect_breathe_table[pos / table_scale]);
 #    else
-    val = (exp(sin((anim->pos / 255.0) * M_PI)) - RGBLIGHT_EFFECT_BREATHE_CENTER / M_E) * (RGBLIGHT_EFFECT_BREATHE_MAX / (M_E - 1 / M_E));
+    val = (exp(sin((pos / 255.0) * M_PI)) - RGBLIGHT_EFFECT_BREATHE_CENTER / M_E) * (RGBLIGHT_EFFECT_BREATHE_MAX / (M_E - 1 / M_E));
 #    endif
     rgblight_sethsv_noeeprom_old(rgblight_config.hue, rgblight_config.sat, val);
-    anim->pos = (anim->pos + 1);
 }
 #endif
 
@@ -859,8 +887,7 @@ void rgblight_effect_breathing(animation_status_t *anim) {
 __attribute__((weak)) const uint8_t RGBLED_RAINBOW_MOOD_INTERVALS[] PROGMEM = {120, 60, 30};
 
 void rgblight_effect_rainbow_mood(animation_status_t *anim) {
-    rgblight_sethsv_noeeprom_old(anim->current_hue, rgblight_config.sat, rgblight_config.val);
-    anim->current_hue++;
+    rgblight_sethsv_noeeprom_old(rgblight_config.hue + anim->step, rgblight_config.sat, rgblight_config.val);
 }
 #endif
 
@@ -872,20 +899,21 @@ void rgblight_effect_rainbow_mood(animation_status_t *anim) {
 __attribute__((weak)) const uint8_t RGBLED_RAINBOW_SWIRL_INTERVALS[] PROGMEM = {100, 50, 20};
 
 void rgblight_effect_rainbow_swirl(animation_status_t *anim) {
+    HSV     hsv[RGBLIGHT_HSV_BATCH];
     uint8_t hue;
     uint8_t i;
+    uint8_t n      = 0;
+    uint8_t offset = anim->delta % 2 ? anim->step : -anim->step;
 
     for (i = 0; i < effect_num_leds; i++) {
-        hue = (RGBLIGHT_RAINBOW_SWIRL_RANGE / effect_num_leds * i + anim->current_hue);
-        sethsv(hue, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i + effect_start_pos]);
+        hue    = (RGBLIGHT_RAINBOW_SWIRL_RANGE / effect_num_leds * i + offset);
+        hsv[n] = (HSV){hue, rgblight_config.sat, rgblight_config.val};
+        if (++n == RGBLIGHT_HSV_BATCH || i + 1 == effect_num_leds) {
+            sethsv_batch(hsv, n, i + 1 + effect_start_pos);
+            n = 0;
+        }
     }
     rgblight_set();
-
-    if (anim->delta % 2) {
-        anim->current_hue++;
-    } else {
-        anim->current_hue--;
-    }
 }
 #endif
 
@@ -893,26 +921,17 @@ void rgblight_effect_rainbow_swirl(animation_status_t *anim) {
 __attribute__((weak)) const uint8_t RGBLED_SNAKE_INTERVALS[] PROGMEM = {100, 50, 20};
 
 void rgblight_effect_snake(animation_status_t *anim) {
-    static uint8_t pos = 0;
-    uint8_t        i, j;
-    int8_t         k;
-    int8_t         increment = 1;
+    uint8_t i, j;
+    int8_t  k;
+    int8_t  increment = 1;
+    uint8_t pos       = anim->step % effect_num_leds;
 
     if (anim->delta % 2) {
         increment = -1;
+    } else if (pos) {
+        pos = effect_num_leds - pos;
     }
 
-#    if defined(RGBLIGHT_SPLIT) && !defined(RGBLIGHT_SPLIT_NO_ANIMATION_SYNC)
-    if (anim->pos == 0) {  // restart signal
-        if (increment == 1) {
-            pos = effect_num_leds - 1;
-        } else {
-            pos = 0;
-        }
-        anim->pos = 1;
-    }
-#    endif
-
     for (i = 0; i < effect_num_leds; i++) {
         LED_TYPE *ledp = led + i + effect_start_pos;
         ledp->r        = 0;
@@ -935,24 +954,6 @@ void rgblight_effect_snake(animation_status_t *anim) {
         }
     }
     rgblight_set();
-    if (increment == 1) {
-        if (pos - 1 < 0) {
-            pos = effect_num_leds - 1;
-#    if defined(RGBLIGHT_SPLIT) && !defined(RGBLIGHT_SPLIT_NO_ANIMATION_SYNC)
-            anim->pos = 0;
-#    endif
-        } else {
-            pos -= 1;
-#    if defined(RGBLIGHT_SPLIT) && !defined(RGBLIGHT_SPLIT_NO_ANIMATION_SYNC)
-            anim->pos = 1;
-#    endif
-        }
-    } else {
-        pos = (pos + 1) % effect_num_leds;
-#    if defined(RGBLIGHT_SPLIT) && !defined(RGBLIGHT_SPLIT_NO_ANIMATION_SYNC)
-        anim->pos = pos;
-#    endif
-    }
 }
 #endif
 
@@ -960,19 +961,14 @@ void rgblight_effect_snake(animation_status_t *anim) {
 __attribute__((weak)) const uint8_t RGBLED_KNIGHT_INTERVALS[] PROGMEM = {127, 63, 31};
 
 void rgblight_effect_knight(animation_status_t *anim) {
-    static int8_t low_bound  = 0;
-    static int8_t high_bound = RGBLIGHT_EFFECT_KNIGHT_LENGTH - 1;
-    static int8_t increment  = 1;
-    uint8_t       i, cur;
+    // The lit bar runs from hanging off one end of the LEDs to hanging off
+    // the other and back, which takes 2 * span steps
+    const uint16_t span       = RGBLIGHT_EFFECT_KNIGHT_LED_NUM + RGBLIGHT_EFFECT_KNIGHT_LENGTH - 2;
+    uint16_t       phase      = (anim->step + RGBLIGHT_EFFECT_KNIGHT_LENGTH - 1) % (span ? 2 * span : 1);
+    int16_t        low_bound  = (phase <= span ? phase : 2 * span - phase) - (RGBLIGHT_EFFECT_KNIGHT_LENGTH - 1);
+    int16_t        high_bound = low_bound + RGBLIGHT_EFFECT_KNIGHT_LENGTH - 1;
+    uint8_t        i, cur;
 
-#    if defined(RGBLIGHT_SPLIT) && !defined(RGBLIGHT_SPLIT_NO_ANIMATION_SYNC)
-    if (anim->pos == 0) {  // restart signal
-        anim->pos  = 1;
-        low_bound  = 0;
-        high_bound = RGBLIGHT_EFFECT_KNIGHT_LENGTH - 1;
-        increment  = 1;
-    }
-#    endif
     // Set all the LEDs to 0
     for (i = effect_start_pos; i < effect_end_pos; i++) {
         led[i].r = 0;
@@ -998,20 +994,6 @@ void rgblight_effect_knight(animation_status_t *anim) {
         }
     }
     rgblight_set();
-
-    // Move from low_bound to high_bound changing the direction we increment each
-    // time a boundary is hit.
-    low_bound += increment;
-    high_bound += increment;
-
-    if (high_bound <= 0 || low_bound >= RGBLIGHT_EFFECT_KNIGHT_LED_NUM - 1) {
-        increment = -increment;
-#    if defined(RGBLIGHT_SPLIT) && !defined(RGBLIGHT_SPLIT_NO_ANIMATION_SYNC)
-        if (increment == 1) {
-            anim->pos = 0;
-        }
-#    endif
-    }
 }
 #endif
 
@@ -1020,9 +1002,8 @@ void rgblight_effect_christmas(animation_status_t *anim) {
     uint8_t hue;
     uint8_t i;
 
-    anim->current_offset = (anim->current_offset + 1) % 2;
     for (i = 0; i < effect_num_leds; i++) {
-        hue = 0 + ((i / RGBLIGHT_EFFECT_CHRISTMAS_STEP + anim->current_offset) % 2) * 85;
+        hue = 0 + ((i / RGBLIGHT_EFFECT_CHRISTMAS_STEP + anim->step + 1) % 2) * 85;
         sethsv(hue, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i + effect_start_pos]);
     }
     rgblight_set();
@@ -1044,7 +1025,7 @@ void rgblight_effect_rgbtest(animation_status_t *anim) {
         maxval = tmp_led.r;
     }
     g = r = b = 0;
-    switch (anim->pos) {
+    switch (anim->step % 3) {
         case 0:
             r = maxval;
             break;
@@ -1056,23 +1037,23 @@ void rgblight_effect_rgbtest(animation_status_t *anim) {
             break;
     }
     rgblight_setrgb(r, g, b);
-    anim->pos = (anim->pos + 1) % 3;
 }
 #endif
 
 #ifdef RGBLIGHT_EFFECT_ALTERNATING
 void rgblight_effect_alternating(animation_status_t *anim) {
+    bool first_half = anim->step % 2 == 0;
+
     for (int i = 0; i < effect_num_leds; i++) {
         LED_TYPE *ledp = led + i + effect_start_pos;
-        if (i < effect_num_leds / 2 && anim->pos) {
+        if (i < effect_num_leds / 2 && first_half) {
             sethsv(rgblight_config.hue, rgblight_config.sat, rgblight_config.val, ledp);
-        } else if (i >= effect_num_leds / 2 && !anim->pos) {
+        } else if (i >= effect_num_leds / 2 && !first_half) {
             sethsv(rgblight_config.hue, rgblight_config.sat, rgblight_config.val, ledp);
         } else {
             sethsv(rgblight_config.hue, rgblight_config.sat, 0, ledp);
         }
     }
     rgblight_set();
-    anim->pos = (anim->pos + 1) % 2;
 }
 #endif
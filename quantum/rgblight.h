@@ -268,11 +268,17 @@ void rgblight_timer_toggle(void);
 #        define RGBLIGHT_STATUS_CHANGE_MODE (1 << 0)
 #        define RGBLIGHT_STATUS_CHANGE_HSVS (1 << 1)
 #        define RGBLIGHT_STATUS_CHANGE_TIMER (1 << 2)
-#        define RGBLIGHT_STATUS_ANIMATION_TICK (1 << 3)
+#        define RGBLIGHT_STATUS_ANIMATION_SYNC (1 << 3)
+
+// How often the master sends its animation clock to the slave
+#        ifndef RGBLIGHT_SPLIT_ANIMATION_SYNC_INTERVAL
+#            define RGBLIGHT_SPLIT_ANIMATION_SYNC_INTERVAL 30000
+#        endif
 
 typedef struct _rgblight_syncinfo_t {
     rgblight_config_t config;
     rgblight_status_t status;
+    uint32_t          time; /* master's animation clock */
 } rgblight_syncinfo_t;
 
 /* for split keyboard master side */
@@ -286,15 +292,13 @@ void rgblight_update_sync(rgblight_syncinfo_t *syncinfo, bool write_to_eeprom);
 #    ifdef RGBLIGHT_USE_TIMER
 
 typedef struct _animation_status_t {
-    uint16_t last_timer;
+    uint32_t step;      /* frame to render, counted in intervals of the animation clock */
+    uint32_t base_step; /* frame shown at base_time */
+    uint32_t base_time;
+    uint32_t next_time;
+    uint16_t interval;
     uint8_t  delta; /* mode - base_mode */
     bool     restart;
-    union {
-        uint16_t pos16;
-        uint8_t  pos;
-        int8_t   current_hue;
-        uint16_t current_offset;
-    };
 } animation_status_t;
 
 extern animation_status_t animation_status;
@@ -0,0 +1,171 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "trace_replay.hpp"
+
+extern "C" {
+#include "action_tapping.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+using testing::Mock;
+
+// Flavors are set per key: SFT_T(KC_P) keeps the defaults, CTL_T(KC_X) is a
+// permissive hold that ignores interrupts, ALT_T(KC_Y) only ignores
+// interrupts and LT(1, KC_Z) holds as soon as another key is pressed.
+extern "C" {
+bool get_permissive_hold(uint16_t keycode, keyrecord_t *record) { return keycode == CTL_T(KC_X); }
+
+bool get_ignore_mod_tap_interrupt(uint16_t keycode, keyrecord_t *record) { return keycode == CTL_T(KC_X) || keycode == ALT_T(KC_Y); }
+
+bool get_hold_on_other_key_press(uint16_t keycode, keyrecord_t *record) { return keycode == LT(1, KC_Z); }
+}
+
+/* Each test replays a "delta row col pressed" trace with its timing and
+ * checks the reports sent and how long each event took to reach the host. */
+class HoldTap : public TestFixture {
+   protected:
+    void replay(TestDriver &driver, const char *trace) {
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber()).WillRepeatedly(Invoke([this](report_keyboard_t &report) { reports.push_back(report); }));
+        TraceReplay replay;
+        replay.play(TraceReplay::parse(trace));
+        replay.idle_for(TAPPING_TERM + 10);
+        latencies = replay.latencies();
+        Mock::VerifyAndClearExpectations(&driver);
+    }
+
+    // Builds the reports to expect from the keys each one holds.
+    static std::vector<report_keyboard_t> keys(std::vector<std::vector<uint8_t>> held) {
+        std::vector<report_keyboard_t> expected;
+
+        for (const std::vector<uint8_t> &report_keys : held) {
+            report_keyboard_t report = {};
+            uint8_t           slot   = 0;
+            for (uint8_t key : report_keys) {
+                if (IS_MOD(key)) {
+                    report.mods |= MOD_BIT(key);
+                } else {
+                    report.keys[slot++] = key;
+                }
+            }
+            expected.push_back(report);
+        }
+        return expected;
+    }
+
+    std::vector<report_keyboard_t> reports;
+    std::vector<int32_t>           latencies;
+};
+
+TEST_F(HoldTap, InterruptedModTapHoldsOnThePress) {
+    TestDriver driver;
+    // SFT_T(KC_P) down, A down 30ms later, A up, SFT_T(KC_P) up
+    replay(driver,
+           "0 0 7 1\n"
+           "30 0 0 1\n"
+           "20 0 0 0\n"
+           "20 0 7 0\n");
+    EXPECT_EQ(reports, keys({{KC_LSFT}, {KC_LSFT, KC_A}, {KC_LSFT}, {}}));
+    // A is sent in the scan it was pressed, not when SFT_T(KC_P) is let go
+    EXPECT_EQ(latencies, std::vector<int32_t>({30, 0, 0, 0}));
+}
+
+TEST_F(HoldTap, RollingOffAnInterruptedModTapStillHolds) {
+    TestDriver driver;
+    replay(driver,
+           "0 0 7 1\n"
+           "30 0 0 1\n"
+           "20 0 7 0\n"
+           "20 0 0 0\n");
+    EXPECT_EQ(reports, keys({{KC_LSFT}, {KC_LSFT, KC_A}, {KC_A}, {}}));
+    EXPECT_EQ(latencies, std::vector<int32_t>({30, 0, 0, 0}));
+}
+
+TEST_F(HoldTap, IgnoredInterruptWaitsForTheRelease) {
+    TestDriver driver;
+    replay(driver,
+           "0 2 1 1\n"
+           "30 0 0 1\n"
+           "20 2 1 0\n"
+           "20 0 0 0\n");
+    // the tap of Y reaches the host before A, its release goes out with A still down
+    EXPECT_EQ(reports, keys({{KC_Y}, {KC_A}, {}}));
+    EXPECT_EQ(latencies, std::vector<int32_t>({50, 20, 0, 0}));
+}
+
+TEST_F(HoldTap, IgnoredInterruptHoldsAfterTheTerm) {
+    TestDriver driver;
+    replay(driver,
+           "0 2 1 1\n"
+           "30 0 0 1\n"
+           "200 0 0 0\n"
+           "20 2 1 0\n");
+    EXPECT_EQ(reports, keys({{KC_LALT}, {KC_LALT, KC_A}, {KC_LALT}, {}}));
+    EXPECT_EQ(latencies, std::vector<int32_t>({TAPPING_TERM, TAPPING_TERM - 30, 0, 0}));
+}
+
+TEST_F(HoldTap, PermissiveHoldSettlesOnTheNestedRelease) {
+    TestDriver driver;
+    replay(driver,
+           "0 2 0 1\n"
+           "30 0 0 1\n"
+           "20 0 0 0\n"
+           "20 2 0 0\n");
+    EXPECT_EQ(reports, keys({{KC_LCTL}, {KC_LCTL, KC_A}, {KC_LCTL}, {}}));
+    EXPECT_EQ(latencies, std::vector<int32_t>({50, 20, 0, 0}));
+}
+
+TEST_F(HoldTap, HoldOnOtherKeyPressSwitchesLayerOnThePress) {
+    TestDriver driver;
+    replay(driver,
+           "0 2 2 1\n"
+           "30 3 1 1\n"
+           "20 3 1 0\n"
+           "20 2 2 0\n");
+    EXPECT_EQ(reports, keys({{KC_E}, {}}));
+    EXPECT_EQ(latencies, std::vector<int32_t>({30, 0, 0, -1}));
+}
+
+TEST_F(HoldTap, LayerTapWithoutAnotherKeyIsATap) {
+    TestDriver driver;
+    replay(driver,
+           "0 2 2 1\n"
+           "40 2 2 0\n");
+    EXPECT_EQ(reports, keys({{KC_Z}, {}}));
+    EXPECT_EQ(latencies, std::vector<int32_t>({40, 0}));
+}
+
+TEST_F(HoldTap, FullBufferSettlesAHold) {
+    TestDriver driver;
+    // WAITING_BUFFER_SIZE events under ALT_T(KC_Y), alternating taps of A and B,
+    // overflow the buffer within the term
+    std::string                       trace    = "0 2 1 1\n";
+    std::vector<std::vector<uint8_t>> expected = {{KC_LALT}};
+    for (uint8_t i = 0; i < WAITING_BUFFER_SIZE / 2; i++) {
+        std::string col = std::to_string(i % 2);
+        trace += "5 0 " + col + " 1\n5 0 " + col + " 0\n";
+        expected.push_back({KC_LALT, (uint8_t)(i % 2 ? KC_B : KC_A)});
+        expected.push_back({KC_LALT});
+    }
+    trace += "5 2 1 0\n";
+    expected.push_back({});
+    ASSERT_LT(5 * (WAITING_BUFFER_SIZE + 1), TAPPING_TERM);
+    replay(driver, trace.c_str());
+    EXPECT_EQ(reports, keys(expected));
+}
@@ -17,6 +17,7 @@
 #include "test_common.hpp"
 
 using testing::_;
+using testing::AnyNumber;
 using testing::Return;
 
 class KeyPress : public TestFixture {};
@@ -37,6 +38,24 @@ TEST_F(KeyPress, CorrectKeyIsReportedWhenPressed) {
     keyboard_task();
 }
 
+TEST_F(KeyPress, AReportIdenticalToTheLastOneIsNotSent) {
+    TestDriver driver;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    uint32_t sent       = host_keyboard_reports_sent();
+    uint32_t suppressed = host_keyboard_reports_suppressed();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    send_keyboard_report();
+    EXPECT_EQ(host_keyboard_reports_sent(), sent);
+    EXPECT_EQ(host_keyboard_reports_suppressed(), suppressed + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+}
+
 TEST_F(KeyPress, CorrectKeysAreReportedWhenTwoKeysArePressed) {
     TestDriver driver;
     press_key(1, 0);
@@ -118,7 +137,68 @@ TEST_F(KeyPress, RightShiftLeftControlAndCharWithTheSameKey) {
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT, KC_RCTRL, KC_O)));
     keyboard_task();
     release_key(6, 0);
-    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RSFT, KC_RCTRL)));
+    // the releases are coalesced
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+}
+
+TEST_F(KeyPress, MagicKeycodesFromBothRangesReachTheMagicHandler) {
+    TestDriver driver;
+    // Magic keys clear the keyboard and release as plain keys, which only sends empty reports
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    press_key(0, 1);
+    keyboard_task();
+    release_key(0, 1);
+    keyboard_task();
+    press_key(2, 1);
+    keyboard_task();
+    release_key(2, 1);
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(4, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LGUI)));
+    keyboard_task();
+    release_key(4, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+    press_key(5, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LGUI)));
+    keyboard_task();
+    release_key(5, 1);
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
     keyboard_task();
-}
\ No newline at end of file
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    press_key(1, 1);
+    keyboard_task();
+    release_key(1, 1);
+    keyboard_task();
+    press_key(3, 1);
+    keyboard_task();
+    release_key(3, 1);
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(4, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    keyboard_task();
+    release_key(4, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+}
+
+TEST_F(KeyPress, AKeyRegisteredAroundAWaitIsHeldForTheWait) {
+    TestDriver driver;
+    testing::InSequence s;
+    uint32_t start = timer_read32();
+    // Like process_record_user() inside a scan, which holds back its reports
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).WillOnce(testing::InvokeWithoutArgs([start]() { EXPECT_EQ(timer_elapsed32(start), 0u); }));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).WillOnce(testing::InvokeWithoutArgs([start]() { EXPECT_EQ(timer_elapsed32(start), 50u); }));
+    host_keyboard_batch_begin();
+    register_code(KC_A);
+    wait_ms(50);
+    unregister_code(KC_A);
+    host_keyboard_batch_end();
+}
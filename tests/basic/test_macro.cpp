@@ -31,7 +31,7 @@ TEST_F(Macro, PlayASimpleMacro) {
     uint32_t current_time = timer_read32();
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT))).AT_TIME(0);
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_H))).AT_TIME(0);
-    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT))).AT_TIME(0);
+    // Releases within one scan are coalesced, presses each get a report
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(0);
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_E))).AT_TIME(0);
     // The macro system could actually skip these empty keyboard reports
@@ -47,7 +47,6 @@ TEST_F(Macro, PlayASimpleMacro) {
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(0);
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT))).AT_TIME(100);
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_W))).AT_TIME(100);
-    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT))).AT_TIME(100);
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(100);
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_O)))
         // BUG: The timer should not really have advanced 10 ms here
@@ -0,0 +1,102 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdio>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "color.h"
+}
+
+static void expect_same(const RGB& expected, const LED_TYPE& actual, const HSV& hsv) {
+    ASSERT_TRUE(expected.r == actual.r && expected.g == actual.g && expected.b == actual.b) << "hsv " << +hsv.h << "," << +hsv.s << "," << +hsv.v;
+}
+
+class BatchLimit : public testing::TestWithParam<uint8_t> {};
+
+TEST_P(BatchLimit, MatchesScalarForEveryColor) {
+    const uint8_t max_val = GetParam();
+    HSV           hsv[256];
+    LED_TYPE      led[256];
+
+    for (unsigned s = 0; s < 256; s++) {
+        for (unsigned v = 0; v < 256; v++) {
+            for (unsigned h = 0; h < 256; h++) {
+                hsv[h] = {(uint8_t)h, (uint8_t)s, (uint8_t)v};
+            }
+            hsv_to_rgb_batch(hsv, led, 256, max_val);
+            for (unsigned h = 0; h < 256; h++) {
+                HSV limited = {(uint8_t)h, (uint8_t)s, (uint8_t)(v < max_val ? v : max_val)};
+                expect_same(hsv_to_rgb(limited), led[h], hsv[h]);
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Color, BatchLimit, testing::Values(255, 254, 200, 128, 1, 0));
+
+TEST(Color, BatchLeavesTheRestOfTheBufferAlone) {
+    HSV      hsv[2] = {{0, 255, 255}, {85, 255, 255}};
+    LED_TYPE led[3] = {};
+
+    led[2].r = led[2].g = led[2].b = 42;
+    hsv_to_rgb_batch(hsv, led, 2, 255);
+    EXPECT_EQ(led[2].r, 42);
+    EXPECT_EQ(led[2].g, 42);
+    EXPECT_EQ(led[2].b, 42);
+}
+
+// Not a pass/fail check, prints the cost of one rainbow frame both ways.
+TEST(Color, BatchFrameBenchmark) {
+    const int  leds   = 128;
+    const int  frames = 20000;
+    HSV        hsv[leds];
+    LED_TYPE   batch[leds];
+    RGB        scalar[leds];
+    unsigned   sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < leds; i++) {
+            hsv[i] = {(uint8_t)(i * 2 + f), (uint8_t)(255 - f), (uint8_t)f};
+        }
+        for (int i = 0; i < leds; i++) {
+            HSV limited = hsv[i];
+            if (limited.v > 200) limited.v = 200;
+            scalar[i] = hsv_to_rgb(limited);
+        }
+        sink += scalar[f % leds].r;
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < leds; i++) {
+            hsv[i] = {(uint8_t)(i * 2 + f), (uint8_t)(255 - f), (uint8_t)f};
+        }
+        hsv_to_rgb_batch(hsv, batch, leds, 200);
+        sink += batch[f % leds].r;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < leds; i++) {
+        expect_same(scalar[i], batch[i], hsv[i]);
+    }
+
+    double scalar_ns = std::chrono::duration<double, std::nano>(middle - start).count() / frames;
+    double batch_ns  = std::chrono::duration<double, std::nano>(end - middle).count() / frames;
+    printf("%d LED frame: hsv_to_rgb %.0f ns, hsv_to_rgb_batch %.0f ns (%u)\n", leds, scalar_ns, batch_ns, sink & 1);
+}
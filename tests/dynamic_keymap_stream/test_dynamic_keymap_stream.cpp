@@ -0,0 +1,274 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <vector>
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "dynamic_keymap_stream.h"
+}
+
+#define KEYMAP_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+
+typedef std::vector<uint8_t> bytes;
+
+/* The host side of the protocol, talking to the keyboard in the same process. */
+class StreamHost {
+   public:
+    int  packets     = 0;
+    int  round_trips = 0;
+    int  drop_seq    = -1;  // lose this data packet the first time it is sent
+    bool rejected    = false;
+
+    bytes read(uint8_t region, uint16_t offset, uint16_t length, bool rle, uint8_t window) {
+        uint8_t request[] = {DYNAMIC_KEYMAP_STREAM_READ, region, rle ? DYNAMIC_KEYMAP_STREAM_RLE : 0, window, (uint8_t)(offset >> 8), (uint8_t)offset, (uint8_t)(length >> 8), (uint8_t)length};
+        send(request, sizeof(request));
+
+        bytes   data;
+        uint8_t expected = 0;
+        while (data.size() < length && !rejected) {
+            bool    gap = false;
+            uint8_t packet[DYNAMIC_KEYMAP_STREAM_PACKET_SIZE];
+            round_trips++;
+            while (dynamic_keymap_stream_next(packet, sizeof(packet))) {
+                packets++;
+                if (packet[1] == DYNAMIC_KEYMAP_STREAM_NAK) {
+                    rejected = true;
+                    break;
+                }
+                if (packet[2] == drop_seq) {
+                    drop_seq = -1;
+                    gap      = true;
+                    continue;
+                }
+                if (gap || packet[2] != expected) {
+                    continue;
+                }
+                decode(&packet[DYNAMIC_KEYMAP_STREAM_HEADER_SIZE], packet[3], rle, data);
+                expected++;
+            }
+            if (rejected) {
+                break;
+            }
+            uint8_t reply[] = {gap ? (uint8_t)DYNAMIC_KEYMAP_STREAM_RESEND : (uint8_t)DYNAMIC_KEYMAP_STREAM_ACK, (uint8_t)(gap ? expected : expected - 1)};
+            send(reply, sizeof(reply));
+        }
+        return data;
+    }
+
+    bool write(uint8_t region, uint16_t offset, const bytes &data, bool rle, uint8_t window) {
+        uint8_t request[] = {DYNAMIC_KEYMAP_STREAM_WRITE, region, rle ? DYNAMIC_KEYMAP_STREAM_RLE : 0, (uint8_t)(offset >> 8), (uint8_t)offset, (uint8_t)(data.size() >> 8), (uint8_t)data.size()};
+        send(request, sizeof(request));
+        if (reply_op() == DYNAMIC_KEYMAP_STREAM_NAK) {
+            return false;
+        }
+
+        std::vector<bytes> payloads = encode(data, rle);
+        size_t             acked    = 0;
+        while (acked < payloads.size()) {
+            // Send a window of packets back to back, collecting the replies
+            size_t limit = acked + window;
+            round_trips++;
+            for (size_t seq = acked; seq < payloads.size() && seq < limit; seq++) {
+                if ((int)seq == drop_seq) {
+                    drop_seq = -1;
+                    continue;
+                }
+                uint8_t packet[DYNAMIC_KEYMAP_STREAM_PACKET_SIZE - 1] = {DYNAMIC_KEYMAP_STREAM_DATA, (uint8_t)seq, (uint8_t)payloads[seq].size()};
+                std::copy(payloads[seq].begin(), payloads[seq].end(), &packet[3]);
+                send(packet, sizeof(packet));
+
+                uint8_t reply[DYNAMIC_KEYMAP_STREAM_PACKET_SIZE];
+                if (!dynamic_keymap_stream_next(reply, sizeof(reply))) {
+                    return false;
+                }
+                packets++;
+                if (reply[1] == DYNAMIC_KEYMAP_STREAM_ACK) {
+                    acked = reply[2] + 1;
+                } else if (reply[3] != DYNAMIC_KEYMAP_STREAM_OUT_OF_ORDER) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void send(const uint8_t *data, uint8_t length) {
+        uint8_t packet[DYNAMIC_KEYMAP_STREAM_PACKET_SIZE] = {DYNAMIC_KEYMAP_STREAM_ID};
+        std::copy(data, data + length, &packet[1]);
+        EXPECT_TRUE(dynamic_keymap_stream_receive(packet, sizeof(packet)));
+    }
+
+    uint8_t reply_op(void) {
+        uint8_t reply[DYNAMIC_KEYMAP_STREAM_PACKET_SIZE];
+        return dynamic_keymap_stream_next(reply, sizeof(reply)) ? reply[1] : 0;
+    }
+
+    static void decode(const uint8_t *payload, uint8_t size, bool rle, bytes &out) {
+        if (!rle) {
+            out.insert(out.end(), payload, payload + size);
+            return;
+        }
+        for (uint8_t i = 0; i < size;) {
+            uint8_t token = payload[i++];
+            if (token & 0x80) {
+                for (int n = 0; n < (token & 0x7F) + 2; n++) {
+                    out.insert(out.end(), &payload[i], &payload[i + 2]);
+                }
+                i += 2;
+            } else {
+                out.insert(out.end(), &payload[i], &payload[i + (token + 1) * 2]);
+                i += (token + 1) * 2;
+            }
+        }
+    }
+
+    static std::vector<bytes> encode(const bytes &data, bool rle) {
+        std::vector<bytes> payloads(1);
+        if (!rle) {
+            for (size_t i = 0; i < data.size(); i++) {
+                if (payloads.back().size() == DYNAMIC_KEYMAP_STREAM_PAYLOAD_SIZE) {
+                    payloads.emplace_back();
+                }
+                payloads.back().push_back(data[i]);
+            }
+            return payloads;
+        }
+        // Runs only, a literal token per keycode that does not repeat
+        for (size_t i = 0; i < data.size();) {
+            size_t run = 1;
+            while (i + run * 2 < data.size() && run < 129 && data[i + run * 2] == data[i] && data[i + run * 2 + 1] == data[i + 1]) {
+                run++;
+            }
+            if (payloads.back().size() + 3 > DYNAMIC_KEYMAP_STREAM_PAYLOAD_SIZE) {
+                payloads.emplace_back();
+            }
+            payloads.back().push_back(run >= 2 ? 0x80 | (run - 2) : 0);
+            payloads.back().push_back(data[i]);
+            payloads.back().push_back(data[i + 1]);
+            i += (run >= 2 ? run : 1) * 2;
+        }
+        return payloads;
+    }
+};
+
+class DynamicKeymapStream : public TestFixture {
+   protected:
+    void SetUp() override {
+        dynamic_keymap_reset();
+        dynamic_keymap_macro_reset();
+        uint8_t abort[DYNAMIC_KEYMAP_STREAM_PACKET_SIZE] = {DYNAMIC_KEYMAP_STREAM_ID, DYNAMIC_KEYMAP_STREAM_ABORT};
+        dynamic_keymap_stream_receive(abort, sizeof(abort));
+    }
+
+    bytes keymap(void) {
+        bytes data(KEYMAP_SIZE);
+        dynamic_keymap_get_buffer(0, KEYMAP_SIZE, data.data());
+        return data;
+    }
+};
+
+TEST_F(DynamicKeymapStream, ReadsWholeKeymap) {
+    StreamHost host;
+    EXPECT_EQ(host.read(DYNAMIC_KEYMAP_STREAM_KEYMAP, 0, KEYMAP_SIZE, false, 8), keymap());
+    // 160 bytes in 6 packets, acknowledged once
+    EXPECT_EQ(host.packets, 6);
+    EXPECT_EQ(host.round_trips, 1);
+}
+
+TEST_F(DynamicKeymapStream, WindowLimitsPacketsInFlight) {
+    StreamHost host;
+    EXPECT_EQ(host.read(DYNAMIC_KEYMAP_STREAM_KEYMAP, 0, KEYMAP_SIZE, false, 2), keymap());
+    EXPECT_EQ(host.packets, 6);
+    EXPECT_EQ(host.round_trips, 3);
+}
+
+TEST_F(DynamicKeymapStream, RleCompressesTransparentLayers) {
+    StreamHost raw;
+    StreamHost rle;
+    bytes      expected = keymap();
+
+    EXPECT_EQ(raw.read(DYNAMIC_KEYMAP_STREAM_KEYMAP, 0, KEYMAP_SIZE, false, 8), expected);
+    EXPECT_EQ(rle.read(DYNAMIC_KEYMAP_STREAM_KEYMAP, 0, KEYMAP_SIZE, true, 8), expected);
+    // Layer 0 and the top row of layer 1 are literals, the 55 KC_TRNS after them one run
+    EXPECT_EQ(rle.packets, 2);
+    EXPECT_LT(rle.packets, raw.packets);
+}
+
+TEST_F(DynamicKeymapStream, ResendsFromLostPacket) {
+    StreamHost host;
+    host.drop_seq = 2;
+    EXPECT_EQ(host.read(DYNAMIC_KEYMAP_STREAM_KEYMAP, 0, KEYMAP_SIZE, false, 4), keymap());
+    EXPECT_EQ(host.round_trips, 2);
+}
+
+TEST_F(DynamicKeymapStream, ReadsPartOfMacroBuffer) {
+    uint8_t macros[] = "hello\0world";
+    dynamic_keymap_macro_set_buffer(10, sizeof(macros), macros);
+
+    StreamHost host;
+    EXPECT_EQ(host.read(DYNAMIC_KEYMAP_STREAM_MACRO, 10, sizeof(macros), false, 8), bytes(macros, macros + sizeof(macros)));
+}
+
+TEST_F(DynamicKeymapStream, WritesKeymapWithRle) {
+    bytes data = keymap();
+    // Fill layer 3 with KC_B and put KC_C in its last key
+    for (int i = 3 * MATRIX_ROWS * MATRIX_COLS * 2; i < KEYMAP_SIZE; i += 2) {
+        data[i]     = 0;
+        data[i + 1] = KC_B;
+    }
+    data[KEYMAP_SIZE - 1] = KC_C;
+
+    StreamHost host;
+    EXPECT_TRUE(host.write(DYNAMIC_KEYMAP_STREAM_KEYMAP, 0, data, true, 4));
+    EXPECT_EQ(keymap(), data);
+    EXPECT_EQ(dynamic_keymap_get_keycode(3, 0, 0), KC_B);
+    EXPECT_EQ(dynamic_keymap_get_keycode(3, MATRIX_ROWS - 1, MATRIX_COLS - 1), KC_C);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_ESC);
+}
+
+TEST_F(DynamicKeymapStream, WriteRecoversFromLostPacket) {
+    bytes data(KEYMAP_SIZE);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = i;
+    }
+
+    StreamHost host;
+    host.drop_seq = 1;
+    EXPECT_TRUE(host.write(DYNAMIC_KEYMAP_STREAM_KEYMAP, 0, data, false, 4));
+    EXPECT_EQ(keymap(), data);
+    EXPECT_EQ(host.round_trips, 3);
+}
+
+TEST_F(DynamicKeymapStream, RejectsBadRequests) {
+    StreamHost host;
+    // Past the end of the region
+    EXPECT_FALSE(host.write(DYNAMIC_KEYMAP_STREAM_MACRO, 90, bytes(20), false, 4));
+    // RLE is only for keycodes
+    EXPECT_FALSE(host.write(DYNAMIC_KEYMAP_STREAM_MACRO, 0, bytes(20), true, 4));
+    host.read(DYNAMIC_KEYMAP_STREAM_KEYMAP, 1, 4, true, 4);
+    EXPECT_TRUE(host.rejected);
+
+    // Data without a stream
+    uint8_t data[] = {DYNAMIC_KEYMAP_STREAM_DATA, 0, 2, 1, 2};
+    host.send(data, sizeof(data));
+    EXPECT_EQ(host.reply_op(), DYNAMIC_KEYMAP_STREAM_NAK);
+
+    // Other commands are left to the keyboard
+    uint8_t other[DYNAMIC_KEYMAP_STREAM_PACKET_SIZE] = {0x01};
+    EXPECT_FALSE(dynamic_keymap_stream_receive(other, sizeof(other)));
+}
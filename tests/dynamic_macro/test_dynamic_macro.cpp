@@ -0,0 +1,123 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+using testing::Mock;
+
+class DynamicMacro : public TestFixture {
+   protected:
+    void tap(uint8_t col) {
+        press_key(col, 0);
+        run_one_scan_loop();
+        release_key(col, 0);
+        run_one_scan_loop();
+    }
+
+    void record(TestDriver& driver, std::initializer_list<uint8_t> cols) {
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        tap(0);
+        for (uint8_t col : cols) {
+            tap(col);
+        }
+        tap(1);
+        Mock::VerifyAndClearExpectations(&driver);
+    }
+};
+
+TEST_F(DynamicMacro, PlaybackSendsOneEventPerScan) {
+    TestDriver driver;
+    record(driver, {3, 4});
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    tap(2);
+    Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+    Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(10);
+}
+
+TEST_F(DynamicMacro, TapKeyIsReplayedAsTap) {
+    TestDriver driver;
+    record(driver, {5});
+
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    tap(2);
+    idle_for(10);
+}
+
+TEST_F(DynamicMacro, TrailingKeyDownsAreNotRecorded) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    tap(0);
+    tap(3);
+    press_key(4, 0);
+    run_one_scan_loop();
+    tap(1);
+    release_key(4, 0);
+    run_one_scan_loop();
+    Mock::VerifyAndClearExpectations(&driver);
+
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    tap(2);
+    idle_for(10);
+}
+
+TEST_F(DynamicMacro, EveryKeyEventTakesOneByte) {
+    TestDriver driver;
+    // 40 taps are 80 events, only the first 64 fit in the buffer
+    record(driver, {3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3});
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).Times(32);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(32);
+    tap(2);
+    idle_for(100);
+}
+
+TEST_F(DynamicMacro, MacroIsKeptInEeprom) {
+    TestDriver driver;
+    record(driver, {4});
+    EXPECT_TRUE(dynamic_macro_load());
+
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    tap(2);
+    idle_for(10);
+}
@@ -0,0 +1,92 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "eeprom.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+class Eeconfig : public TestFixture {
+   protected:
+    void SetUp() override {
+        eeconfig_update_user(0);
+        eeconfig_update_kb(0);
+        eeconfig_flush();
+    }
+};
+
+TEST_F(Eeconfig, ChangesAreWrittenAfterDelay) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    eeconfig_update_user(0x12345678);
+    EXPECT_EQ(eeconfig_read_user(), 0x12345678u);
+    EXPECT_EQ(eeprom_read_dword(EECONFIG_USER), 0u);
+
+    // The scan loop runs the check before the time advances
+    idle_for(EECONFIG_WRITE_DELAY);
+    EXPECT_EQ(eeprom_read_dword(EECONFIG_USER), 0u);
+    run_one_scan_loop();
+    EXPECT_EQ(eeprom_read_dword(EECONFIG_USER), 0x12345678u);
+}
+
+TEST_F(Eeconfig, RapidChangesAreCoalesced) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    // The delay runs from the first change, later ones ride along
+    for (uint32_t val = 1; val <= 5; val++) {
+        eeconfig_update_kb(val);
+        idle_for(EECONFIG_WRITE_DELAY / 5 - 1);
+        EXPECT_EQ(eeprom_read_dword(EECONFIG_KEYBOARD), 0u);
+    }
+    idle_for(EECONFIG_WRITE_DELAY - 5 * (EECONFIG_WRITE_DELAY / 5 - 1) + 1);
+    EXPECT_EQ(eeprom_read_dword(EECONFIG_KEYBOARD), 5u);
+    EXPECT_EQ(eeconfig_read_kb(), 5u);
+}
+
+TEST_F(Eeconfig, FlushOnlyWritesChangedBytes) {
+    // A byte written behind the cache's back is not overwritten by a flush
+    eeconfig_update_user(0x11);
+    eeprom_update_byte((uint8_t *)EECONFIG_USER + 3, 0x44);
+    eeconfig_flush();
+    EXPECT_EQ(eeprom_read_dword(EECONFIG_USER), 0x44000011u);
+    eeprom_update_byte((uint8_t *)EECONFIG_USER + 3, 0);
+}
+
+TEST_F(Eeconfig, BlocksCrossingTheEndOfTheImageAreSplit) {
+    uint8_t saved[2];
+    eeconfig_read_block(saved, (const void *)(EECONFIG_SIZE - 1), sizeof(saved));
+
+    // The first byte waits in the image, the one past it goes straight to EEPROM
+    uint8_t data[2] = {0xAB, 0xCD};
+    eeconfig_update_block(data, (void *)(EECONFIG_SIZE - 1), sizeof(data));
+    EXPECT_EQ(eeprom_read_byte((uint8_t *)EECONFIG_SIZE - 1), saved[0]);
+    EXPECT_EQ(eeprom_read_byte((uint8_t *)EECONFIG_SIZE), 0xCD);
+
+    uint8_t read[2] = {0, 0};
+    eeconfig_read_block(read, (const void *)(EECONFIG_SIZE - 1), sizeof(read));
+    EXPECT_EQ(read[0], 0xAB);
+    EXPECT_EQ(read[1], 0xCD);
+
+    eeconfig_update_block(saved, (void *)(EECONFIG_SIZE - 1), sizeof(saved));
+    eeconfig_flush();
+}
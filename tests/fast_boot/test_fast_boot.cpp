@@ -0,0 +1,79 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "boot_trace.h"
+
+extern bool    host_ready;
+extern uint8_t post_init_calls;
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+class FastBoot : public TestFixture {};
+
+TEST_F(FastBoot, PeripheralsWaitForHost) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    // keyboard_init() has run, but the host has not configured the device yet
+    EXPECT_TRUE(boot_trace_marked(BOOT_STAGE_KEYBOARD));
+    EXPECT_FALSE(keyboard_peripherals_ready());
+    EXPECT_EQ(post_init_calls, 0);
+
+    // Keys work before the peripherals are up
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    idle_for(10);
+    EXPECT_FALSE(keyboard_peripherals_ready());
+    EXPECT_FALSE(boot_trace_marked(BOOT_STAGE_HOST));
+    EXPECT_TRUE(boot_trace_marked(BOOT_STAGE_FIRST_KEY));
+
+    host_ready = true;
+    run_one_scan_loop();
+    EXPECT_TRUE(keyboard_peripherals_ready());
+    EXPECT_EQ(post_init_calls, 1);
+
+    idle_for(10);
+    EXPECT_EQ(post_init_calls, 1);
+}
+
+TEST_F(FastBoot, TraceMarksStagesInOrder) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    host_ready = true;
+    press_key(1, 1);
+    run_one_scan_loop();
+    release_key(1, 1);
+    run_one_scan_loop();
+
+    for (uint8_t stage = 0; stage < BOOT_STAGE_COUNT; stage++) {
+        EXPECT_TRUE(boot_trace_marked((boot_stage_t)stage));
+    }
+    EXPECT_LE(boot_trace_read(BOOT_STAGE_MATRIX), boot_trace_read(BOOT_STAGE_BOOTMAGIC));
+    EXPECT_LE(boot_trace_read(BOOT_STAGE_BOOTMAGIC), boot_trace_read(BOOT_STAGE_KEYBOARD));
+    EXPECT_LE(boot_trace_read(BOOT_STAGE_KEYBOARD), boot_trace_read(BOOT_STAGE_FIRST_KEY));
+    EXPECT_LE(boot_trace_read(BOOT_STAGE_HOST), boot_trace_read(BOOT_STAGE_PERIPHERALS));
+}
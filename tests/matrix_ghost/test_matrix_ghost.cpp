@@ -0,0 +1,106 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+
+class MatrixGhost : public TestFixture {};
+
+TEST_F(MatrixGhost, TheFourthCornerOfARectangleIsHeldBack) {
+    TestDriver driver;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    keyboard_task();
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    keyboard_task();
+    press_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_D)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // Could be a ghost of A, B and D
+    press_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    keyboard_task();
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // Once D is up, E can only be real
+    release_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    keyboard_task();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_E)));
+    keyboard_task();
+}
+
+TEST_F(MatrixGhost, OtherKeysOnTheRowOfAGhostStillRegister) {
+    TestDriver driver;
+    press_key(0, 0);
+    press_key(1, 0);
+    press_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_D)));
+    keyboard_task();
+    keyboard_task();
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(1, 1);
+    press_key(2, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_D, KC_F)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    keyboard_task();
+}
+
+TEST_F(MatrixGhost, BlankPositionsDoNotMakeAGhost) {
+    TestDriver driver;
+    // A KC_NO position reads as down, but no one can press it
+    press_key(3, 0);
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    keyboard_task();
+    keyboard_task();
+    press_key(0, 2);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_G)));
+    keyboard_task();
+    press_key(3, 2);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_G, KC_I)));
+    keyboard_task();
+}
+
+TEST_F(MatrixGhost, KeysPressedTogetherOnARectangleWaitForOneToBeReleased) {
+    TestDriver driver;
+    press_key(0, 0);
+    press_key(1, 0);
+    press_key(0, 1);
+    press_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_D)));
+    keyboard_task();
+    keyboard_task();
+    keyboard_task();
+}
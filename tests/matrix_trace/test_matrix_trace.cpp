@@ -0,0 +1,190 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "trace_replay.hpp"
+#include "action_tapping.h"
+
+extern "C" {
+#include "matrix_trace.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+using testing::Mock;
+
+class MatrixTrace : public TestFixture {
+   protected:
+    void SetUp() override { matrix_trace_clear(); }
+
+    void capture(TestDriver& driver) {
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber()).WillRepeatedly(Invoke([this](report_keyboard_t& report) { reports.push_back(report); }));
+    }
+
+    void key(uint8_t col, uint8_t row, bool pressed, unsigned then) {
+        if (pressed) {
+            press_key(col, row);
+        } else {
+            release_key(col, row);
+        }
+        run_one_scan_loop();
+        idle_for(then);
+    }
+
+    std::vector<report_keyboard_t> reports;
+};
+
+TEST_F(MatrixTrace, ReplayReproducesRecordedReports) {
+    TestDriver driver;
+    capture(driver);
+
+    // Shift held over a tap of B, then a layer tap held for E and tapped for C.
+    key(0, 0, true, 20);
+    key(1, 0, true, 30);
+    key(1, 0, false, 10);
+    key(0, 0, false, 50);
+    key(0, 1, true, TAPPING_TERM + 20);
+    key(1, 0, true, 15);
+    key(1, 0, false, 5);
+    key(0, 1, false, 40);
+    key(0, 1, true, 30);
+    key(0, 1, false, TAPPING_TERM + 10);
+
+    std::vector<report_keyboard_t> recorded = reports;
+    reports.clear();
+    EXPECT_EQ(matrix_trace_count(), 10);
+
+    uint8_t data[MATRIX_TRACE_SIZE * MATRIX_TRACE_EVENT_SIZE];
+    uint8_t length = matrix_trace_read(data, sizeof(data));
+    EXPECT_EQ(length, 10 * MATRIX_TRACE_EVENT_SIZE);
+    EXPECT_EQ(matrix_trace_count(), 0);
+
+    std::vector<TraceEvent> events = TraceReplay::decode(data, length);
+    ASSERT_EQ(events.size(), 10u);
+    EXPECT_EQ(events[0].delta, 0);
+    EXPECT_EQ(events[1].delta, 21);
+    EXPECT_TRUE(events[1].pressed);
+    EXPECT_EQ(events[1].row, 0);
+    EXPECT_EQ(events[1].col, 1);
+
+    idle_for(100);
+    TraceReplay replay;
+    replay.play(events);
+    replay.idle_for(TAPPING_TERM + 10);
+
+    EXPECT_FALSE(recorded.empty());
+    EXPECT_EQ(reports, recorded);
+    Mock::VerifyAndClearExpectations(&driver);
+
+    // B pressed under the mod tap settles it as a hold, so it is sent in the
+    // scan it happens, like keys on the held layer and releases of resolved
+    // taps. The final tap of C is only sent once it resolves on its release.
+    const std::vector<int32_t>& latencies = replay.latencies();
+    ASSERT_EQ(latencies.size(), 10u);
+    EXPECT_EQ(latencies[1], 0);
+    EXPECT_EQ(latencies[3], 0);
+    EXPECT_EQ(latencies[5], 0);
+    EXPECT_EQ(latencies[8], 31);
+    EXPECT_EQ(latencies[9], 0);
+}
+
+TEST_F(MatrixTrace, ReplaysConsoleText) {
+    TestDriver driver;
+    capture(driver);
+
+    std::vector<TraceEvent> events = TraceReplay::parse(
+        "matrix trace: 4 events, 0 dropped\n"
+        "0 0 1 1\n"
+        "12 1 1 1\n"
+        "5 0 1 0\n"
+        "30 1 1 0\n");
+    ASSERT_EQ(events.size(), 4u);
+
+    TraceReplay replay;
+    replay.play(events);
+    replay.idle_for(10);
+    Mock::VerifyAndClearExpectations(&driver);
+
+    std::vector<report_keyboard_t> expected(4);
+    expected[0].keys[0] = KC_B;
+    expected[1].keys[0] = KC_B;
+    expected[1].keys[1] = KC_D;
+    expected[2].keys[0] = KC_D;
+    EXPECT_EQ(reports, expected);
+    EXPECT_EQ(replay.latencies(), std::vector<int32_t>({0, 0, 0, 0}));
+}
+
+TEST_F(MatrixTrace, FullBufferDropsOldestEvents) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    for (int i = 0; i < MATRIX_TRACE_SIZE / 2 + 2; i++) {
+        key(1, 0, true, i);
+        key(1, 0, false, 1);
+    }
+    EXPECT_EQ(matrix_trace_count(), MATRIX_TRACE_SIZE);
+    EXPECT_EQ(matrix_trace_dropped(), 4);
+
+    // The oldest remaining event is the press of the third tap.
+    matrix_trace_event_t event;
+    ASSERT_TRUE(matrix_trace_pop(&event));
+    EXPECT_EQ(event.row, MATRIX_TRACE_PRESSED);
+    EXPECT_EQ(event.col, 1);
+    EXPECT_EQ(event.delta, 2);
+    ASSERT_TRUE(matrix_trace_pop(&event));
+    EXPECT_EQ(event.row, 0);
+    EXPECT_EQ(event.delta, 3);
+    EXPECT_EQ(matrix_trace_count(), MATRIX_TRACE_SIZE - 2);
+}
+
+TEST_F(MatrixTrace, ReadResetsDropCount) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    for (int i = 0; i < MATRIX_TRACE_SIZE / 2 + 1; i++) {
+        key(1, 0, true, 1);
+        key(1, 0, false, 1);
+    }
+    EXPECT_EQ(matrix_trace_dropped(), 2);
+
+    uint8_t data[8 * MATRIX_TRACE_EVENT_SIZE];
+    EXPECT_EQ(matrix_trace_read(data, sizeof(data)), sizeof(data));
+    EXPECT_EQ(matrix_trace_dropped(), 0);
+    EXPECT_EQ(matrix_trace_count(), MATRIX_TRACE_SIZE - 8);
+}
+
+TEST_F(MatrixTrace, PrintExportsFromKeyboardTask) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    for (int i = 0; i < MATRIX_TRACE_SIZE / 2 + 1; i++) {
+        key(1, 0, true, 1);
+        key(1, 0, false, 1);
+    }
+    matrix_trace_print();
+    EXPECT_EQ(matrix_trace_dropped(), 0);
+    EXPECT_EQ(matrix_trace_count(), MATRIX_TRACE_SIZE);
+
+    run_one_scan_loop();
+    EXPECT_EQ(matrix_trace_count(), 0);
+
+    // Events recorded after the export are kept for the next one.
+    key(1, 0, true, 1);
+    key(1, 0, false, 1);
+    EXPECT_EQ(matrix_trace_count(), 2);
+    EXPECT_EQ(matrix_trace_dropped(), 0);
+}
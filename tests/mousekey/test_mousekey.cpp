@@ -0,0 +1,159 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "mousekey.h"
+}
+
+extern "C" {
+void advance_time(uint32_t ms);
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+struct Travel {
+    int x = 0;
+    int y = 0;
+    int v = 0;
+};
+
+class Mousekey : public TestFixture {
+public:
+    // Hold the keys for `hold` ms while running the mousekey task every
+    // `period` ms, and sum up everything reported to the host at each checkpoint
+    std::vector<Travel> hold(std::vector<uint8_t> codes, unsigned period, unsigned hold, unsigned checkpoint) {
+        TestDriver          driver;
+        Travel              travel;
+        std::vector<Travel> result;
+        EXPECT_CALL(driver, send_mouse_mock(_)).Times(AnyNumber()).WillRepeatedly(Invoke([&travel](report_mouse_t& report) {
+            travel.x += report.x;
+            travel.y += report.y;
+            travel.v += report.v;
+        }));
+        for (uint8_t code : codes) {
+            mousekey_on(code);
+            mousekey_send();
+        }
+        for (unsigned t = 0; t < hold; t += period) {
+            mousekey_task();
+            if (t % checkpoint == 0) {
+                result.push_back(travel);
+            }
+            advance_time(period);
+        }
+        for (uint8_t code : codes) {
+            mousekey_off(code);
+            mousekey_send();
+        }
+        result.push_back(travel);
+        testing::Mock::VerifyAndClearExpectations(&driver);
+        return result;
+    }
+
+    void expect_same_travel(std::vector<uint8_t> codes, unsigned period = 5, unsigned checkpoint = 40) {
+        // both runs have to stop at the same time
+        unsigned time = 3000 / checkpoint * checkpoint;
+        auto     fast = hold(codes, 1, time, checkpoint);
+        auto     slow = hold(codes, period, time, checkpoint);
+        ASSERT_EQ(fast.size(), slow.size());
+        for (size_t i = 0; i < fast.size(); i++) {
+            EXPECT_EQ(fast[i].x, slow[i].x) << "at checkpoint " << i;
+            EXPECT_EQ(fast[i].y, slow[i].y) << "at checkpoint " << i;
+            EXPECT_EQ(fast[i].v, slow[i].v) << "at checkpoint " << i;
+        }
+    }
+};
+
+TEST_F(Mousekey, TravelIsIndependentOfScanRate) { expect_same_travel({KC_MS_RIGHT}); }
+
+TEST_F(Mousekey, DiagonalTravelIsIndependentOfScanRate) { expect_same_travel({KC_MS_RIGHT, KC_MS_DOWN}); }
+
+TEST_F(Mousekey, WheelTravelIsIndependentOfScanRate) { expect_same_travel({KC_MS_WH_DOWN}); }
+
+TEST_F(Mousekey, ConstantSpeedTravelIsIndependentOfScanRate) { expect_same_travel({KC_MS_ACCEL0, KC_MS_RIGHT}); }
+
+TEST_F(Mousekey, CurvedTravelIsIndependentOfScanRate) {
+    mk_curve = 100;
+    expect_same_travel({KC_MS_RIGHT});
+    mk_curve = -100;
+    expect_same_travel({KC_MS_RIGHT});
+    mk_curve = MOUSEKEY_CURVE;
+}
+
+TEST_F(Mousekey, TravelReachesSteadySpeed) {
+    auto travel = hold({KC_MS_RIGHT}, 1, 3000, 1000);
+    ASSERT_EQ(travel.size(), 4);
+    // single step on press, nothing until MOUSEKEY_DELAY has passed
+    EXPECT_EQ(travel[0].x, MOUSEKEY_MOVE_DELTA);
+    // steady speed is MOUSEKEY_MOVE_DELTA * MOUSEKEY_MAX_SPEED every MOUSEKEY_INTERVAL
+    EXPECT_EQ(travel[3].x - travel[2].x, MOUSEKEY_MOVE_DELTA * MOUSEKEY_MAX_SPEED * 1000 / MOUSEKEY_INTERVAL);
+    EXPECT_EQ(travel[3].y, 0);
+}
+
+TEST_F(Mousekey, SlowMovementIsNotTruncated) {
+    mk_max_speed = 1;
+    auto travel  = hold({KC_MS_RIGHT}, 1, 3000, 1000);
+    mk_max_speed = MOUSEKEY_MAX_SPEED;
+    EXPECT_EQ(travel[3].x - travel[2].x, MOUSEKEY_MOVE_DELTA * 1000 / MOUSEKEY_INTERVAL);
+}
+
+TEST_F(Mousekey, TravelIsIndependentOfOddScanPeriods) { expect_same_travel({KC_MS_RIGHT}, 37, 37 * 8); }
+
+TEST_F(Mousekey, StallDuringTheRampIsCaughtUpInOneReport) {
+    // slow enough that everything travelled fits in a single report
+    mk_max_speed = 1;
+    auto steps   = hold({KC_MS_RIGHT}, 1, 1237, 1237);
+    auto stall   = hold({KC_MS_RIGHT}, 1237, 1237, 1237);
+    mk_max_speed = MOUSEKEY_MAX_SPEED;
+    ASSERT_LT(steps.back().x, MOUSEKEY_MOVE_DELTA + MOUSEKEY_MOVE_MAX);
+    EXPECT_EQ(stall.back().x, steps.back().x);
+}
+
+TEST_F(Mousekey, LongStallIsCappedToOneReport) {
+    TestDriver          driver;
+    std::vector<int8_t> reports;
+    EXPECT_CALL(driver, send_mouse_mock(_)).Times(AnyNumber()).WillRepeatedly(Invoke([&reports](report_mouse_t& report) { reports.push_back(report.x); }));
+
+    mousekey_on(KC_MS_RIGHT);
+    mousekey_send();
+    advance_time(3000);
+    mousekey_task();
+    advance_time(60001);
+    mousekey_task();
+    // steady speed carries on from where the stall ended
+    size_t stalled = reports.size();
+    for (unsigned t = 0; t < 1000; t++) {
+        advance_time(1);
+        mousekey_task();
+    }
+    int travel = 0;
+    for (size_t i = stalled; i < reports.size(); i++) {
+        travel += reports[i];
+    }
+    mousekey_off(KC_MS_RIGHT);
+    mousekey_send();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    ASSERT_GE(reports.size(), 3u);
+    EXPECT_EQ(reports[1], MOUSEKEY_MOVE_MAX);
+    EXPECT_EQ(reports[2], MOUSEKEY_MOVE_MAX);
+    // plus the pixel kept over from the stall
+    EXPECT_EQ(travel, MOUSEKEY_MOVE_DELTA * MOUSEKEY_MAX_SPEED * 1000 / MOUSEKEY_INTERVAL + 1);
+}
@@ -0,0 +1,65 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class Nkro : public TestFixture {
+   public:
+    void SetUp() override { keymap_config.nkro = true; }
+    void TearDown() override { keymap_config.nkro = false; }
+};
+
+TEST_F(Nkro, PressesInOneScanKeepTheirOrder) {
+    TestDriver driver;
+    InSequence s;
+    // Y is scanned before A, but the bitmap would list A first
+    press_key(0, 0);
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y, KC_A)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(0, 0);
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
+
+TEST_F(Nkro, ATapInOneScanIsNotLost) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // A is pressed while Y goes up
+    release_key(0, 0);
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+}
@@ -0,0 +1,52 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+#define TD_ROW(n)                                                                                                                                                                                                                                    \
+    {                                                                                                                                                                                                                                                \
+        TD(n + 0), TD(n + 1), TD(n + 2), TD(n + 3), TD(n + 4), TD(n + 5), TD(n + 6), TD(n + 7), TD(n + 8), TD(n + 9), TD(n + 10), TD(n + 11), TD(n + 12), TD(n + 13), TD(n + 14), TD(n + 15), TD(n + 16), TD(n + 17), TD(n + 18), TD(n + 19), TD(n + 20), TD(n + 21), TD(n + 22), TD(n + 23), TD(n + 24) \
+    }
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {TD_ROW(0), TD_ROW(25), TD_ROW(50), TD_ROW(75), TD_ROW(100), TD_ROW(125), TD_ROW(150), TD_ROW(175), {KC_A}},
+};
+
+uint8_t  td_finished_count[TAP_DANCE_COUNT];
+uint8_t  td_finished_taps[TAP_DANCE_COUNT];
+uint8_t  td_reset_count[TAP_DANCE_COUNT];
+uint16_t td_finished_order[TAP_DANCE_COUNT * 2];
+uint16_t td_finished_total;
+
+static void td_finished(qk_tap_dance_state_t *state, void *user_data) {
+    uint8_t index = state->keycode - QK_TAP_DANCE;
+
+    td_finished_count[index]++;
+    td_finished_taps[index] = state->count;
+    if (td_finished_total < TAP_DANCE_COUNT * 2) {
+        td_finished_order[td_finished_total] = index;
+    }
+    td_finished_total++;
+}
+
+static void td_reset(qk_tap_dance_state_t *state, void *user_data) { td_reset_count[state->keycode - QK_TAP_DANCE]++; }
+
+#define TD_ACTION ACTION_TAP_DANCE_FN_ADVANCED(NULL, td_finished, td_reset)
+#define TD_ACTIONS_5 TD_ACTION, TD_ACTION, TD_ACTION, TD_ACTION, TD_ACTION
+#define TD_ACTIONS_25 TD_ACTIONS_5, TD_ACTIONS_5, TD_ACTIONS_5, TD_ACTIONS_5, TD_ACTIONS_5
+#define TD_ACTIONS_100 TD_ACTIONS_25, TD_ACTIONS_25, TD_ACTIONS_25, TD_ACTIONS_25
+
+qk_tap_dance_action_t tap_dance_actions[TAP_DANCE_COUNT] = {TD_ACTIONS_100, TD_ACTIONS_100};
@@ -0,0 +1,132 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "action_tapping.h"
+
+extern "C" {
+extern uint8_t  td_finished_count[TAP_DANCE_COUNT];
+extern uint8_t  td_finished_taps[TAP_DANCE_COUNT];
+extern uint8_t  td_reset_count[TAP_DANCE_COUNT];
+extern uint16_t td_finished_order[TAP_DANCE_COUNT * 2];
+extern uint16_t td_finished_total;
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+class TapDance : public TestFixture {
+   protected:
+    TapDance() {
+        memset(td_finished_count, 0, sizeof(td_finished_count));
+        memset(td_finished_taps, 0, sizeof(td_finished_taps));
+        memset(td_reset_count, 0, sizeof(td_reset_count));
+        td_finished_total = 0;
+    }
+
+    void press_td(uint8_t index) {
+        press_key(index % MATRIX_COLS, index / MATRIX_COLS);
+        run_one_scan_loop();
+    }
+
+    void release_td(uint8_t index) {
+        release_key(index % MATRIX_COLS, index / MATRIX_COLS);
+        run_one_scan_loop();
+    }
+
+    void tap_td(uint8_t index) {
+        press_td(index);
+        release_td(index);
+    }
+};
+
+TEST_F(TapDance, HighestDanceTimesOut) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    tap_td(199);
+    tap_td(199);
+    idle_for(TAPPING_TERM - 2);
+    EXPECT_EQ(td_finished_count[199], 0);
+    idle_for(2);
+    EXPECT_EQ(td_finished_count[199], 1);
+    EXPECT_EQ(td_finished_taps[199], 2);
+    EXPECT_EQ(td_reset_count[199], 1);
+}
+
+TEST_F(TapDance, HeldDanceResetsOnRelease) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    press_td(150);
+    idle_for(TAPPING_TERM + 50);
+    EXPECT_EQ(td_finished_count[150], 1);
+    EXPECT_EQ(td_reset_count[150], 0);
+    release_td(150);
+    EXPECT_EQ(td_reset_count[150], 1);
+}
+
+TEST_F(TapDance, OtherKeyInterruptsDance) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    tap_td(3);
+    press_key(0, 8);
+    run_one_scan_loop();
+    release_key(0, 8);
+    run_one_scan_loop();
+    EXPECT_EQ(td_finished_count[3], 1);
+    EXPECT_EQ(td_reset_count[3], 1);
+}
+
+TEST_F(TapDance, EveryDanceInTurnFinishesOnce) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    for (int round = 0; round < 5; round++) {
+        td_finished_total = 0;
+        for (int i = 0; i < TAP_DANCE_COUNT; i++) {
+            // Each dance is interrupted by the next one
+            tap_td((i * 7 + round) % TAP_DANCE_COUNT);
+        }
+        idle_for(TAPPING_TERM + 1);
+        ASSERT_EQ(td_finished_total, TAP_DANCE_COUNT);
+        for (int i = 0; i < TAP_DANCE_COUNT; i++) {
+            EXPECT_EQ(td_finished_order[i], (i * 7 + round) % TAP_DANCE_COUNT);
+        }
+    }
+    for (int i = 0; i < TAP_DANCE_COUNT; i++) {
+        EXPECT_EQ(td_finished_count[i], 5);
+        EXPECT_EQ(td_finished_taps[i], 1);
+        EXPECT_EQ(td_reset_count[i], 5);
+    }
+}
+
+TEST_F(TapDance, ManyHeldDances) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    // More dances held at once than are tracked as active
+    for (int i = 0; i < 12; i++) {
+        press_td(i * 16);
+    }
+    idle_for(TAPPING_TERM + 1);
+    for (int i = 0; i < 12; i++) {
+        EXPECT_EQ(td_finished_count[i * 16], 1);
+        EXPECT_EQ(td_reset_count[i * 16], 0);
+        release_td(i * 16);
+        EXPECT_EQ(td_reset_count[i * 16], 1);
+    }
+    tap_td(5);
+    idle_for(TAPPING_TERM + 1);
+    EXPECT_EQ(td_finished_count[5], 1);
+    EXPECT_EQ(td_reset_count[5], 1);
+}
@@ -17,16 +17,45 @@
 #include "keyboard_report_util.hpp"
 #include <vector>
 #include <algorithm>
+extern "C" {
+#include "host.h"
+#include "keycode_config.h"
+}
 using namespace testing;
 
 namespace {
+bool is_nkro() {
+#if defined(NKRO_ENABLE)
+    return keyboard_protocol && keymap_config.nkro;
+#else
+    return false;
+#endif
+}
+
+uint8_t get_mods(const report_keyboard_t& report) {
+#if defined(NKRO_ENABLE)
+    if (is_nkro()) {
+        return report.nkro.mods;
+    }
+#endif
+    return report.mods;
+}
+
 std::vector<uint8_t> get_keys(const report_keyboard_t& report) {
     std::vector<uint8_t> result;
-#if defined(NKRO_ENABLE)
-#    error NKRO support not implemented yet
-#elif defined(USB_6KRO_ENABLE)
+#if defined(USB_6KRO_ENABLE)
 #    error 6KRO support not implemented yet
 #else
+#    if defined(NKRO_ENABLE)
+    if (is_nkro()) {
+        for (size_t i = 0; i < KEYBOARD_REPORT_BITS * 8; i++) {
+            if (report.nkro.bits[i / 8] & (1 << (i % 8))) {
+                result.emplace_back(i);
+            }
+        }
+        return result;
+    }
+#    endif
     for (size_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
         if (report.keys[i]) {
             result.emplace_back(report.keys[i]);
@@ -41,12 +70,12 @@ std::vector<uint8_t> get_keys(const report_keyboard_t& report) {
 bool operator==(const report_keyboard_t& lhs, const report_keyboard_t& rhs) {
     auto lhskeys = get_keys(lhs);
     auto rhskeys = get_keys(rhs);
-    return lhs.mods == rhs.mods && lhskeys == rhskeys;
+    return get_mods(lhs) == get_mods(rhs) && lhskeys == rhskeys;
 }
 
 std::ostream& operator<<(std::ostream& stream, const report_keyboard_t& value) {
     stream << "Keyboard report:" << std::endl;
-    stream << "Mods: " << (uint32_t)value.mods << std::endl;
+    stream << "Mods: " << (uint32_t)get_mods(value) << std::endl;
     stream << "Keys: ";
     // TODO: This should probably print friendly names for the keys
     for (uint32_t k : get_keys(value)) {
@@ -57,7 +86,7 @@ std::ostream& operator<<(std::ostream& stream, const report_keyboard_t& value) {
 }
 
 KeyboardReportMatcher::KeyboardReportMatcher(const std::vector<uint8_t>& keys) {
-    memset(m_report.raw, 0, sizeof(m_report.raw));
+    memset(&m_report, 0, sizeof(m_report));
     for (auto k : keys) {
         if (IS_MOD(k)) {
             m_report.mods |= MOD_BIT(k);
@@ -65,6 +94,12 @@ KeyboardReportMatcher::KeyboardReportMatcher(const std::vector<uint8_t>& keys) {
             add_key_to_report(&m_report, k);
         }
     }
+#if defined(NKRO_ENABLE)
+    // the host moves the mods next to the bitmap before sending
+    if (is_nkro()) {
+        m_report.nkro.mods = m_report.mods;
+    }
+#endif
 }
 
 bool KeyboardReportMatcher::MatchAndExplain(report_keyboard_t& report, MatchResultListener* listener) const { return m_report == report; }
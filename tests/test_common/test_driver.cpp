@@ -18,6 +18,11 @@
 
 TestDriver* TestDriver::m_this = nullptr;
 
+#ifdef NKRO_ENABLE
+// Set by the USB stack on real hardware, the test host always speaks the report protocol
+extern "C" uint8_t keyboard_protocol = 1;
+#endif
+
 TestDriver::TestDriver() : m_driver{&TestDriver::keyboard_leds, &TestDriver::send_keyboard, &TestDriver::send_mouse, &TestDriver::send_system, &TestDriver::send_consumer} {
     host_set_driver(&m_driver);
     m_this = this;
@@ -0,0 +1,96 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace_replay.hpp"
+#include <cctype>
+#include <sstream>
+#include "test_matrix.h"
+
+extern "C" {
+#include "keyboard.h"
+#include "host.h"
+#include "timer.h"
+void advance_time(uint32_t ms);
+}
+
+std::vector<TraceEvent> TraceReplay::parse(const std::string& text) {
+    std::vector<TraceEvent> events;
+    std::istringstream      lines(text);
+    std::string             line;
+
+    while (std::getline(lines, line)) {
+        if (line.empty() || !std::isdigit(static_cast<unsigned char>(line[0]))) {
+            continue;
+        }
+        std::istringstream fields(line);
+        unsigned           delta, row, col, pressed;
+        if (fields >> delta >> row >> col >> pressed) {
+            events.push_back({static_cast<uint16_t>(delta), static_cast<uint8_t>(row), static_cast<uint8_t>(col), pressed != 0});
+        }
+    }
+    return events;
+}
+
+std::vector<TraceEvent> TraceReplay::decode(const uint8_t* data, size_t length) {
+    std::vector<TraceEvent> events;
+
+    for (size_t i = 0; i + 4 <= length; i += 4) {
+        uint16_t delta = data[i] | (data[i + 1] << 8);
+        events.push_back({delta, static_cast<uint8_t>(data[i + 2] & 0x7F), data[i + 3], (data[i + 2] & 0x80) != 0});
+    }
+    return events;
+}
+
+void TraceReplay::play(const std::vector<TraceEvent>& events) {
+    m_reports = host_keyboard_reports_sent();
+
+    for (const TraceEvent& event : events) {
+        if (event.delta > 0) {
+            idle_for(event.delta - 1);
+            advance_time(1);
+        }
+        if (event.pressed) {
+            press_key(event.col, event.row);
+        } else {
+            release_key(event.col, event.row);
+        }
+        m_waiting.push_back(m_latencies.size());
+        m_latencies.push_back(-1);
+        m_times.push_back(timer_read32());
+        scan();
+    }
+}
+
+void TraceReplay::idle_for(unsigned ms) {
+    for (unsigned i = 0; i < ms; i++) {
+        advance_time(1);
+        scan();
+    }
+}
+
+void TraceReplay::scan() {
+    keyboard_task();
+
+    uint32_t reports = host_keyboard_reports_sent();
+    if (reports == m_reports) {
+        return;
+    }
+    m_reports = reports;
+    for (size_t i : m_waiting) {
+        m_latencies[i] = timer_read32() - m_times[i];
+    }
+    m_waiting.clear();
+}
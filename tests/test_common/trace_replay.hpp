@@ -0,0 +1,58 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+    uint16_t delta;
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+};
+
+/* Replays a matrix trace captured with MATRIX_TRACE_ENABLE through the test
+ * matrix, one keyboard_task() per millisecond like the firmware runs it.
+ *
+ * For every event the replay also records how many milliseconds passed until
+ * the next keyboard report was sent, or -1 if none was sent before the replay
+ * ended. Tapping keys show up there as the time they took to resolve.
+ */
+class TraceReplay {
+   public:
+    // Parse the "delta row col pressed" lines printed by matrix_trace_print().
+    // Lines that don't start with a number are skipped.
+    static std::vector<TraceEvent> parse(const std::string& text);
+    // Decode events in the binary format returned by matrix_trace_read().
+    static std::vector<TraceEvent> decode(const uint8_t* data, size_t length);
+
+    void play(const std::vector<TraceEvent>& events);
+    void idle_for(unsigned ms);
+
+    const std::vector<int32_t>& latencies() const { return m_latencies; }
+
+   private:
+    void scan();
+
+    std::vector<int32_t>  m_latencies;
+    std::vector<size_t>   m_waiting;
+    std::vector<uint32_t> m_times;
+    uint32_t              m_reports = 0;
+};
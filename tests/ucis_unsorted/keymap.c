@@ -0,0 +1,35 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {{KC_K, KC_I, KC_S, KC_N, KC_G, KC_P, KC_SPC, KC_BSPC}},
+};
+
+// Out of order, so process_ucis falls back to the linear lookup
+const qk_ucis_symbol_t ucis_symbol_table[] = UCIS_TABLE(
+    UCIS_SYM("skin", 0x1F3FB),
+    UCIS_SYM("kissing", 0x1F617),
+    UCIS_SYM("pig", 0x1F416),
+    UCIS_SYM("kiss", 0x1F619)
+);
+
+uint8_t ucis_last_success = 0xFF;
+
+void qk_ucis_start_user(void) {}
+
+void qk_ucis_success(uint8_t symbol_index) { ucis_last_success = symbol_index; }
@@ -0,0 +1,88 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+extern uint8_t ucis_last_success;
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+class UcisUnsorted : public TestFixture {
+   protected:
+    void type(const char* keys) {
+        for (; *keys; keys++) {
+            uint8_t col = strchr(layout, *keys) - layout;
+            press_key(col, 0);
+            run_one_scan_loop();
+            release_key(col, 0);
+            run_one_scan_loop();
+        }
+    }
+
+    void start() {
+        ucis_last_success = 0xFF;
+        qk_ucis_start();
+    }
+
+    // One character per column of the keymap, space for KC_SPC and < for KC_BSPC
+    const char* layout = "kisngp <";
+};
+
+TEST_F(UcisUnsorted, ExactMatchNeedsSpace) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    start();
+    type("kiss ");
+    EXPECT_FALSE(qk_ucis_state.in_progress);
+    EXPECT_EQ(ucis_last_success, 3);
+
+    start();
+    type("kissing ");
+    EXPECT_FALSE(qk_ucis_state.in_progress);
+    EXPECT_EQ(ucis_last_success, 1);
+}
+
+TEST_F(UcisUnsorted, UniquePrefixWaitsForSpace) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    start();
+    type("p");
+    EXPECT_TRUE(qk_ucis_state.in_progress);
+    type("ig ");
+    EXPECT_FALSE(qk_ucis_state.in_progress);
+    EXPECT_EQ(ucis_last_success, 2);
+}
+
+TEST_F(UcisUnsorted, BackspaceWidensTheMatch) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    start();
+    type("skig<n ");
+    EXPECT_FALSE(qk_ucis_state.in_progress);
+    EXPECT_EQ(ucis_last_success, 0);
+}
+
+TEST_F(UcisUnsorted, UnknownMnemonicFallsBack) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    start();
+    type("kis ");
+    EXPECT_FALSE(qk_ucis_state.in_progress);
+    EXPECT_EQ(ucis_last_success, 0xFF);
+}
@@ -19,8 +19,10 @@ TMK_COMMON_SRC +=	$(COMMON_DIR)/host.c \
 	$(COMMON_DIR)/print.c \
 	$(COMMON_DIR)/debug.c \
 	$(COMMON_DIR)/util.c \
+	$(COMMON_DIR)/matrix_ghost.c \
 	$(COMMON_DIR)/eeconfig.c \
 	$(COMMON_DIR)/report.c \
+	$(COMMON_DIR)/tx_buffer.c \
 	$(PLATFORM_COMMON_DIR)/suspend.c \
 	$(PLATFORM_COMMON_DIR)/timer.c \
 	$(PLATFORM_COMMON_DIR)/bootloader.c \
@@ -63,6 +65,7 @@ endif
 
 ifeq ($(PLATFORM),TEST)
 	TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/eeprom.c
+	TMK_COMMON_DEFS += -DPROTOCOL_TEST
 endif
 
 
@@ -125,6 +128,20 @@ else
     TMK_COMMON_DEFS += -DNO_DEBUG
 endif
 
+ifeq ($(strip $(MATRIX_TRACE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/matrix_trace.c
+    TMK_COMMON_DEFS += -DMATRIX_TRACE_ENABLE
+endif
+
+ifeq ($(strip $(FAST_BOOT_ENABLE)), yes)
+    TMK_COMMON_DEFS += -DFAST_BOOT_ENABLE
+endif
+
+ifeq ($(strip $(BOOT_TRACE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/boot_trace.c
+    TMK_COMMON_DEFS += -DBOOT_TRACE_ENABLE
+endif
+
 ifeq ($(strip $(COMMAND_ENABLE)), yes)
     TMK_COMMON_SRC += $(COMMON_DIR)/command.c
     TMK_COMMON_DEFS += -DCOMMAND_ENABLE
@@ -308,15 +308,12 @@ void process_action(keyrecord_t *record, action_t action) {
                 default:
                     if (event.pressed) {
                         if (tap_count > 0) {
-#    ifndef IGNORE_MOD_TAP_INTERRUPT
-                            if (record->tap.interrupted) {
+                            if (record->tap.interrupted && !get_ignore_mod_tap_interrupt(get_event_keycode(record->event), record)) {
                                 dprint("mods_tap: tap: cancel: add_mods\n");
                                 // ad hoc: set 0 to cancel tap
                                 record->tap.count = 0;
                                 register_mods(mods);
-                            } else
-#    endif
-                            {
+                            } else {
                                 dprint("MODS_TAP: Tap: register_code\n");
                                 register_code(action.key.code);
                             }
@@ -328,6 +325,7 @@ void process_action(keyrecord_t *record, action_t action) {
                         if (tap_count > 0) {
                             dprint("MODS_TAP: Tap: unregister_code\n");
                             if (action.layer_tap.code == KC_CAPS) {
+                                host_keyboard_flush();
                                 wait_ms(TAP_HOLD_CAPS_DELAY);
                             }
                             unregister_code(action.key.code);
@@ -530,6 +528,7 @@ void process_action(keyrecord_t *record, action_t action) {
                     } else {
                         if (tap_count > 0) {
                             dprint("KEYMAP_TAP_KEY: Tap: unregister_code\n");
+                            host_keyboard_flush();
                             if (action.layer_tap.code == KC_CAPS) {
                                 wait_ms(TAP_HOLD_CAPS_DELAY);
                             } else {
@@ -630,6 +629,7 @@ void process_action(keyrecord_t *record, action_t action) {
                         if (event.pressed) {
                             register_code(action.swap.code);
                         } else {
+                            host_keyboard_flush();
                             wait_ms(TAP_CODE_DELAY);
                             unregister_code(action.swap.code);
                             *record = (keyrecord_t){};  // hack: reset tap mode
@@ -721,6 +721,7 @@ void register_code(uint8_t code) {
 #    endif
         add_key(KC_CAPSLOCK);
         send_keyboard_report();
+        host_keyboard_flush();
         wait_ms(100);
         del_key(KC_CAPSLOCK);
         send_keyboard_report();
@@ -732,6 +733,7 @@ void register_code(uint8_t code) {
 #    endif
         add_key(KC_NUMLOCK);
         send_keyboard_report();
+        host_keyboard_flush();
         wait_ms(100);
         del_key(KC_NUMLOCK);
         send_keyboard_report();
@@ -743,6 +745,7 @@ void register_code(uint8_t code) {
 #    endif
         add_key(KC_SCROLLLOCK);
         send_keyboard_report();
+        host_keyboard_flush();
         wait_ms(100);
         del_key(KC_SCROLLLOCK);
         send_keyboard_report();
@@ -863,6 +866,7 @@ void unregister_code(uint8_t code) {
  */
 void tap_code(uint8_t code) {
     register_code(code);
+    host_keyboard_flush();
     if (code == KC_CAPS) {
         wait_ms(TAP_HOLD_CAPS_DELAY);
     } else {
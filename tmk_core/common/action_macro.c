@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action.h"
 #include "action_util.h"
 #include "action_macro.h"
+#include "host.h"
 #include "wait.h"
 
 #ifdef DEBUG_ACTION
@@ -64,6 +65,7 @@ void action_macro_play(const macro_t *macro_p) {
                 dprintf("WAIT(%u)\n", macro);
                 {
                     uint8_t ms = macro;
+                    host_keyboard_flush();
                     while (ms--) wait_ms(1);
                 }
                 break;
@@ -86,6 +88,7 @@ void action_macro_play(const macro_t *macro_p) {
         // interval
         {
             uint8_t ms = interval;
+            if (ms) host_keyboard_flush();
             while (ms--) wait_ms(1);
         }
     }
@@ -23,17 +23,47 @@ __attribute__((weak)) uint16_t get_tapping_term(uint16_t keycode) { return TAPPI
 
 #    ifdef TAPPING_TERM_PER_KEY
 #        define WITHIN_TAPPING_TERM(e) (TIMER_DIFF_16(e.time, tapping_key.event.time) < get_tapping_term(get_event_keycode(tapping_key.event)))
+#        define KEY_TAPPING_TERM(keycode) get_tapping_term(keycode)
 #    else
 #        define WITHIN_TAPPING_TERM(e) (TIMER_DIFF_16(e.time, tapping_key.event.time) < TAPPING_TERM)
+#        define KEY_TAPPING_TERM(keycode) TAPPING_TERM
 #    endif
 
+/* Long tapping terms are permissive even without PERMISSIVE_HOLD, otherwise
+ * typing under them would be too slow. */
+__attribute__((weak)) bool get_permissive_hold(uint16_t keycode, keyrecord_t *record) {
+#    ifdef PERMISSIVE_HOLD
+    return true;
+#    else
+    return KEY_TAPPING_TERM(keycode) >= 500;
+#    endif
+}
+
+__attribute__((weak)) bool get_ignore_mod_tap_interrupt(uint16_t keycode, keyrecord_t *record) {
+#    ifdef IGNORE_MOD_TAP_INTERRUPT
+    return true;
+#    else
+    return false;
+#    endif
+}
+
+__attribute__((weak)) bool get_hold_on_other_key_press(uint16_t keycode, keyrecord_t *record) {
+#    ifdef HOLD_ON_OTHER_KEY_PRESS
+    return true;
+#    else
+    return false;
+#    endif
+}
+
 static keyrecord_t tapping_key                         = {};
 static keyrecord_t waiting_buffer[WAITING_BUFFER_SIZE] = {};
 static uint8_t     waiting_buffer_head                 = 0;
 static uint8_t     waiting_buffer_tail                 = 0;
 
 static bool process_tapping(keyrecord_t *record);
+static bool hold_on_interrupt(void);
 static bool waiting_buffer_enq(keyrecord_t record);
+static void waiting_buffer_process(void);
 static void waiting_buffer_clear(void);
 static bool waiting_buffer_typed(keyevent_t event);
 static bool waiting_buffer_has_anykey_pressed(void);
@@ -52,7 +82,15 @@ void action_tapping_process(keyrecord_t record) {
             debug_record(record);
             debug("\n");
         }
-    } else {
+    } else if (!waiting_buffer_enq(record)) {
+        if (IS_TAPPING_PRESSED() && tapping_key.tap.count == 0) {
+            // a tap key held down through a full buffer is taken as a hold, which makes room
+            debug("OVERFLOW: SETTLE TAPPING KEY AS HOLD\n");
+            process_record(&tapping_key);
+            tapping_key = (keyrecord_t){};
+            debug_tapping_key();
+            waiting_buffer_process();
+        }
         if (!waiting_buffer_enq(record)) {
             // clear all in case of overflow.
             debug("OVERFLOW: CLEAR ALL STATES\n");
@@ -66,6 +104,17 @@ void action_tapping_process(keyrecord_t record) {
     if (!IS_NOEVENT(record.event) && waiting_buffer_head != waiting_buffer_tail) {
         debug("---- action_exec: process waiting_buffer -----\n");
     }
+    waiting_buffer_process();
+    if (!IS_NOEVENT(record.event)) {
+        debug("\n");
+    }
+}
+
+/** \brief Waiting buffer process
+ *
+ * Processes buffered events in order until one has to wait for the tapping key again.
+ */
+static void waiting_buffer_process(void) {
     for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail = (waiting_buffer_tail + 1) % WAITING_BUFFER_SIZE) {
         if (process_tapping(&waiting_buffer[waiting_buffer_tail])) {
             debug("processed: waiting_buffer[");
@@ -77,9 +126,6 @@ void action_tapping_process(keyrecord_t record) {
             break;
         }
     }
-    if (!IS_NOEVENT(record.event)) {
-        debug("\n");
-    }
 }
 
 /** \brief Tapping
@@ -111,13 +157,7 @@ bool process_tapping(keyrecord_t *keyp) {
                  * This can register the key before settlement of tapping,
                  * useful for long TAPPING_TERM but may prevent fast typing.
                  */
-#    if defined(TAPPING_TERM_PER_KEY) || (!defined(PER_KEY_TAPPING_TERM) && TAPPING_TERM >= 500) || defined(PERMISSIVE_HOLD)
-#        ifdef TAPPING_TERM_PER_KEY
-                else if ((get_tapping_term(get_event_keycode(tapping_key.event)) >= 500) && IS_RELEASED(event) && waiting_buffer_typed(event))
-#        else
-                else if (IS_RELEASED(event) && waiting_buffer_typed(event))
-#        endif
-                {
+                else if (IS_RELEASED(event) && waiting_buffer_typed(event) && get_permissive_hold(get_event_keycode(tapping_key.event), &tapping_key)) {
                     debug("Tapping: End. No tap. Interfered by typing key\n");
                     process_record(&tapping_key);
                     tapping_key = (keyrecord_t){};
@@ -125,7 +165,6 @@ bool process_tapping(keyrecord_t *keyp) {
                     // enqueue
                     return false;
                 }
-#    endif
                 /* Process release event of a key pressed before tapping starts
                  * Without this unexpected repeating will occur with having fast repeating setting
                  * https://github.com/tmk/tmk_keyboard/issues/60
@@ -153,6 +192,12 @@ bool process_tapping(keyrecord_t *keyp) {
                     // set interrupted flag when other key preesed during tapping
                     if (event.pressed) {
                         tapping_key.tap.interrupted = true;
+                        if (hold_on_interrupt()) {
+                            debug("Tapping: End. No tap. Hold settled by interrupting key\n");
+                            process_record(&tapping_key);
+                            tapping_key = (keyrecord_t){};
+                            debug_tapping_key();
+                        }
                     }
                     // enqueue
                     return false;
@@ -295,6 +340,28 @@ bool process_tapping(keyrecord_t *keyp) {
     }
 }
 
+/** \brief Hold on interrupt
+ *
+ * Whether the undecided tapping key is certain to be a hold now that another key was pressed
+ * during its tapping term, so it can be settled without waiting for its release or the term.
+ */
+static bool hold_on_interrupt(void) {
+    uint16_t keycode = get_event_keycode(tapping_key.event);
+
+    if (get_hold_on_other_key_press(keycode, &tapping_key)) {
+        return true;
+    }
+
+    // An interrupted mod tap turns into its mods even when released within the term, see process_action()
+    action_t action = layer_switch_get_action(tapping_key.event.key);
+    switch (action.kind.id) {
+        case ACT_LMODS_TAP:
+        case ACT_RMODS_TAP:
+            return action.key.code > MODS_TAP_TOGGLE && !get_ignore_mod_tap_interrupt(keycode, &tapping_key);
+    }
+    return false;
+}
+
 /** \brief Waiting buffer enq
  *
  * FIXME: Needs docs
@@ -29,12 +29,28 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    define TAPPING_TOGGLE 5
 #endif
 
-#define WAITING_BUFFER_SIZE 8
+/* events held back while a tap key is undecided, one slot stays free */
+#ifndef WAITING_BUFFER_SIZE
+#    ifdef __AVR__
+#        define WAITING_BUFFER_SIZE 8
+#    else
+#        define WAITING_BUFFER_SIZE 16
+#    endif
+#endif
+#if WAITING_BUFFER_SIZE < 2 || WAITING_BUFFER_SIZE > 255
+#    error "WAITING_BUFFER_SIZE must be between 2 and 255, the buffer is indexed with uint8_t"
+#endif
 
 #ifndef NO_ACTION_TAPPING
 uint16_t get_event_keycode(keyevent_t event);
 uint16_t get_tapping_term(uint16_t keycode);
 void     action_tapping_process(keyrecord_t record);
+
+/* Per key tap-hold flavors, the defaults follow PERMISSIVE_HOLD,
+ * IGNORE_MOD_TAP_INTERRUPT and HOLD_ON_OTHER_KEY_PRESS. */
+bool get_permissive_hold(uint16_t keycode, keyrecord_t *record);
+bool get_ignore_mod_tap_interrupt(uint16_t keycode, keyrecord_t *record);
+bool get_hold_on_other_key_press(uint16_t keycode, keyrecord_t *record);
 #endif
 
 #endif
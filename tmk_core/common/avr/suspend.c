@@ -9,6 +9,7 @@
 #include "timer.h"
 #include "led.h"
 #include "host.h"
+#include "eeconfig.h"
 #include "rgblight_reconfig.h"
 
 #ifdef PROTOCOL_LUFA
@@ -155,6 +156,8 @@ static void power_down(uint8_t wdto) {
  * FIXME: needs doc
  */
 void suspend_power_down(void) {
+    // Save pending settings, the host may cut power while we sleep
+    eeconfig_flush();
     suspend_power_down_kb();
 
 #ifndef NO_SUSPEND_POWER_DOWN
@@ -117,6 +117,31 @@ inline uint32_t timer_elapsed32(uint32_t last) {
     return TIMER_DIFF_32(t, last);
 }
 
+/** \brief timer read in microseconds
+ *
+ * Adds the raw count of timer0 to the millisecond count. A compare match
+ * that is pending but not yet serviced counts as the next millisecond.
+ */
+uint16_t timer_read_us(void) {
+    uint16_t t;
+    uint8_t  raw;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        t   = timer_count;
+        raw = TIMER_RAW;
+#ifndef __AVR_ATmega32A__
+        if (TIFR0 & _BV(OCF0A)) {
+#else
+        if (TIFR & _BV(OCF0)) {
+#endif
+            t++;
+            raw = TIMER_RAW;
+        }
+    }
+
+    return t * 1000U + (uint16_t)((uint32_t)raw * 1000 / (TIMER_RAW_TOP + 1));
+}
+
 // excecuted once per 1ms.(excess for just timer count?)
 #ifndef __AVR_ATmega32A__
 #    define TIMER_INTERRUPT_VECTOR TIMER0_COMPA_vect
@@ -0,0 +1,95 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "boot_trace.h"
+#include "timer.h"
+#include "print.h"
+#if defined(CONSOLE_ENABLE) && (defined(PROTOCOL_LUFA) || defined(PROTOCOL_CHIBIOS))
+#    include "sendchar.h"
+#endif
+
+/* longest line, "boot: peripherals 65535 ms\n" */
+#define BOOT_TRACE_LINE_MAX 28
+
+static uint16_t boot_trace_time[BOOT_STAGE_COUNT];
+static uint8_t  boot_trace_mask    = 0;
+static uint8_t  boot_trace_printed = 0;
+
+/* The console queue drops what does not fit, so only print a line it can take whole. */
+static bool boot_trace_console_ready(void) {
+#if defined(CONSOLE_ENABLE) && (defined(PROTOCOL_LUFA) || defined(PROTOCOL_CHIBIOS))
+    return tx_buffer_free(&console_tx_buffer) >= BOOT_TRACE_LINE_MAX;
+#else
+    return true;
+#endif
+}
+
+static void boot_trace_print_stage(boot_stage_t stage) {
+    uint16_t time = boot_trace_time[stage];
+
+    switch (stage) {
+        case BOOT_STAGE_MATRIX:
+            xprintf("boot: matrix %u ms\n", time);
+            break;
+        case BOOT_STAGE_BOOTMAGIC:
+            xprintf("boot: bootmagic %u ms\n", time);
+            break;
+        case BOOT_STAGE_KEYBOARD:
+            xprintf("boot: keyboard %u ms\n", time);
+            break;
+        case BOOT_STAGE_HOST:
+            xprintf("boot: host %u ms\n", time);
+            break;
+        case BOOT_STAGE_PERIPHERALS:
+            xprintf("boot: peripherals %u ms\n", time);
+            break;
+        case BOOT_STAGE_FIRST_KEY:
+            xprintf("boot: first key %u ms\n", time);
+            break;
+        default:
+            break;
+    }
+    (void)time;
+}
+
+void boot_trace_mark(boot_stage_t stage) {
+    if (boot_trace_marked(stage)) {
+        return;
+    }
+
+    boot_trace_time[stage] = timer_read();
+    boot_trace_mask |= (1 << stage);
+}
+
+bool boot_trace_marked(boot_stage_t stage) { return boot_trace_mask & (1 << stage); }
+
+uint16_t boot_trace_read(boot_stage_t stage) { return boot_trace_marked(stage) ? boot_trace_time[stage] : 0; }
+
+void boot_trace_task(void) {
+    uint8_t pending = boot_trace_mask & ~boot_trace_printed;
+
+    if (!pending || !boot_trace_console_ready()) {
+        return;
+    }
+    for (uint8_t stage = 0; stage < BOOT_STAGE_COUNT; stage++) {
+        if (pending & (1 << stage)) {
+            boot_trace_print_stage(stage);
+            boot_trace_printed |= (1 << stage);
+            return;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Boot timeline trace
+ *
+ * keyboard_init() and keyboard_task() mark each startup stage with the timer
+ * value when it completed, counted from timer_init(). The console is not up
+ * during keyboard_init(), so the marks are kept in RAM. Once the peripherals
+ * are initialized, boot_trace_task() prints one stage per call, and only when
+ * the console queue has room for the whole line.
+ */
+
+typedef enum {
+    BOOT_STAGE_MATRIX,       // matrix_init() returned
+    BOOT_STAGE_BOOTMAGIC,    // bootmagic or magic decided
+    BOOT_STAGE_KEYBOARD,     // keyboard_init() returned, the matrix is being scanned
+    BOOT_STAGE_HOST,         // the host has configured the device
+    BOOT_STAGE_PERIPHERALS,  // OLED, lighting, audio and pointing devices are up
+    BOOT_STAGE_FIRST_KEY,    // the first key event reached action_exec()
+    BOOT_STAGE_COUNT,
+} boot_stage_t;
+
+void boot_trace_mark(boot_stage_t stage);
+bool boot_trace_marked(boot_stage_t stage);
+/* Milliseconds from timer_init() to the stage, 0 if it has not been reached. */
+uint16_t boot_trace_read(boot_stage_t stage);
+/* Print the next marked stage that has not been printed yet, if the console has room. */
+void boot_trace_task(void);
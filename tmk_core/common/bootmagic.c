@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "wait.h"
+#include "timer.h"
 #include "matrix.h"
 #include "bootloader.h"
 #include "debug.h"
@@ -12,6 +13,37 @@
 
 keymap_config_t keymap_config;
 
+#ifdef FAST_BOOT_ENABLE
+/** \brief Bootmagic Settle
+ *
+ * Scans until the matrix has not changed for BOOTMAGIC_SETTLE_TIME, instead
+ * of always scanning for a second. Gives up after BOOTMAGIC_SCAN_TIMEOUT so a
+ * chattering switch cannot hold up the boot for longer than before.
+ */
+static void bootmagic_settle(void) {
+    matrix_row_t last[MATRIX_ROWS];
+    uint16_t     start  = timer_read();
+    uint16_t     stable = start;
+
+    matrix_scan();
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        last[r] = matrix_get_row(r);
+    }
+
+    while (timer_elapsed(stable) < BOOTMAGIC_SETTLE_TIME && timer_elapsed(start) < BOOTMAGIC_SCAN_TIMEOUT) {
+        wait_ms(1);
+        matrix_scan();
+        for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+            matrix_row_t row = matrix_get_row(r);
+            if (row != last[r]) {
+                last[r] = row;
+                stable  = timer_read();
+            }
+        }
+    }
+}
+#endif
+
 /** \brief Bootmagic
  *
  * FIXME: needs doc
@@ -24,11 +56,15 @@ void bootmagic(void) {
 
     /* do scans in case of bounce */
     print("bootmagic scan: ... ");
+#ifdef FAST_BOOT_ENABLE
+    bootmagic_settle();
+#else
     uint8_t scan = 100;
     while (scan--) {
         matrix_scan();
         wait_ms(10);
     }
+#endif
     print("done.\n");
 
     /* bootmagic skip */
@@ -3,6 +3,20 @@
 
 /* FIXME: Add special doxygen comments for defines here. */
 
+/* with FAST_BOOT_ENABLE, how long the matrix must be unchanged before bootmagic reads it */
+#ifndef BOOTMAGIC_SETTLE_TIME
+#    if defined(DEBOUNCE) && DEBOUNCE * 2 > 10
+#        define BOOTMAGIC_SETTLE_TIME (DEBOUNCE * 2)
+#    else
+#        define BOOTMAGIC_SETTLE_TIME 10
+#    endif
+#endif
+
+/* with FAST_BOOT_ENABLE, the longest bootmagic waits for the matrix to settle */
+#ifndef BOOTMAGIC_SCAN_TIMEOUT
+#    define BOOTMAGIC_SCAN_TIMEOUT 1000
+#endif
+
 /* bootmagic salt key */
 #ifndef BOOTMAGIC_KEY_SALT
 #    define BOOTMAGIC_KEY_SALT KC_SPACE
@@ -10,6 +10,7 @@
 #include "host.h"
 #include "suspend.h"
 #include "wait.h"
+#include "eeconfig.h"
 
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
@@ -47,6 +48,9 @@ __attribute__((weak)) void suspend_power_down_kb(void) { suspend_power_down_user
  * FIXME: needs doc
  */
 void suspend_power_down(void) {
+    // Save pending settings, the host may cut power while we sleep
+    eeconfig_flush();
+
     // TODO: figure out what to power down and how
     // shouldn't power down TPM/FTM if we want a breathing LED
     // also shouldn't power down USB
@@ -31,3 +31,6 @@ uint32_t timer_read32(void) {
 uint16_t timer_elapsed(uint16_t last) { return timer_read() - last; }
 
 uint32_t timer_elapsed32(uint32_t last) { return timer_read32() - last; }
+
+// Only as fine as the system tick, which is commonly 100us or 10us
+uint16_t timer_read_us(void) { return (uint16_t)chVTGetSystemTimeX() * (uint16_t)(1000000 / CH_CFG_ST_FREQUENCY); }
@@ -35,6 +35,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "quantum.h"
 #include "version.h"
 
+#ifdef MATRIX_TRACE_ENABLE
+#    include "matrix_trace.h"
+#endif
+
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
 #endif
@@ -146,6 +150,10 @@ static void command_common_help(void) {
 #ifdef SLEEP_LED_ENABLE
           STR(MAGIC_KEY_SLEEP_LED) ":	Sleep LED Test\n"
 #endif
+
+#ifdef MATRIX_TRACE_ENABLE
+          STR(MAGIC_KEY_MATRIX_TRACE) ":	Print Matrix Trace\n"
+#endif
     );
 }
 
@@ -332,6 +340,12 @@ static bool command_common(uint8_t code) {
             break;
 #endif
 
+#ifdef MATRIX_TRACE_ENABLE
+        case MAGIC_KC(MAGIC_KEY_MATRIX_TRACE):
+            matrix_trace_print();
+            break;
+#endif
+
         // print stored eeprom config
         case MAGIC_KC(MAGIC_KEY_EEPROM):
             print("eeconfig:\n");
@@ -388,6 +402,7 @@ static bool command_common(uint8_t code) {
 #else
             wait_ms(1000);
 #endif
+            eeconfig_flush();   // settings changed within EECONFIG_WRITE_DELAY are still in RAM
             bootloader_jump();  // not return
             break;
 
@@ -156,6 +156,10 @@ bool    command_proc(uint8_t code);
 
 #ifndef MAGIC_KEY_SLEEP_LED
 #    define MAGIC_KEY_SLEEP_LED Z
+#endif
+
+#ifndef MAGIC_KEY_MATRIX_TRACE
+#    define MAGIC_KEY_MATRIX_TRACE T
 
 #endif
 
@@ -1,14 +1,140 @@
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "eeprom.h"
 #include "eeconfig.h"
 #include "action_layer.h"
+#include "timer.h"
 
 #ifdef STM32_EEPROM_ENABLE
 #    include "hal.h"
 #    include "eeprom_stm32.h"
 #endif
 
+static uint8_t  eeconfig_image[EECONFIG_SIZE];
+static uint8_t  eeconfig_dirty[(EECONFIG_SIZE + 7) / 8];
+static bool     eeconfig_loaded  = false;
+static bool     eeconfig_pending = false;
+static uint16_t eeconfig_pending_time;
+
+static void eeconfig_load(void) {
+    if (!eeconfig_loaded) {
+        eeprom_read_block(eeconfig_image, (const void *)0, EECONFIG_SIZE);
+        eeconfig_loaded = true;
+    }
+}
+
+/* The number of bytes at addr that are inside the RAM copy. */
+static inline size_t eeconfig_cached(const void *addr, size_t len) {
+    if ((uintptr_t)addr >= EECONFIG_SIZE) {
+        return 0;
+    }
+    return (uintptr_t)addr + len <= EECONFIG_SIZE ? len : EECONFIG_SIZE - (uintptr_t)addr;
+}
+
+/** \brief eeconfig read block
+ *
+ * Copies len bytes at addr from the RAM copy, loading it on first use. Bytes
+ * past the end of the copy are read from EEPROM.
+ */
+void eeconfig_read_block(void *buf, const void *addr, size_t len) {
+    size_t cached = eeconfig_cached(addr, len);
+
+    if (cached < len) {
+        eeprom_read_block((uint8_t *)buf + cached, (const uint8_t *)addr + cached, len - cached);
+    }
+    if (!cached) {
+        return;
+    }
+
+    eeconfig_load();
+    memcpy(buf, &eeconfig_image[(uintptr_t)addr], cached);
+}
+
+/** \brief eeconfig update block
+ *
+ * Changes the RAM copy and marks the bytes that differ for eeconfig_task().
+ * Bytes past the end of the copy are written to EEPROM right away.
+ */
+void eeconfig_update_block(const void *buf, void *addr, size_t len) {
+    size_t cached = eeconfig_cached(addr, len);
+
+    if (cached < len) {
+        eeprom_update_block((const uint8_t *)buf + cached, (uint8_t *)addr + cached, len - cached);
+    }
+    if (!cached) {
+        return;
+    }
+
+    eeconfig_load();
+    const uint8_t *src    = buf;
+    uint8_t        offset = (uintptr_t)addr;
+    for (uint8_t i = 0; i < cached; i++, offset++) {
+        if (eeconfig_image[offset] != src[i]) {
+            eeconfig_image[offset] = src[i];
+            eeconfig_dirty[offset / 8] |= 1 << (offset % 8);
+            if (!eeconfig_pending) {
+                eeconfig_pending      = true;
+                eeconfig_pending_time = timer_read();
+            }
+        }
+    }
+}
+
+/** \brief eeconfig flush
+ *
+ * Writes the changed bytes only, so bytes written to EEPROM directly in the
+ * meantime are left alone.
+ */
+void eeconfig_flush(void) {
+    if (!eeconfig_pending) {
+        return;
+    }
+
+    for (uint8_t offset = 0; offset < EECONFIG_SIZE; offset++) {
+        if (eeconfig_dirty[offset / 8] & (1 << (offset % 8))) {
+            eeprom_update_byte((uint8_t *)(uintptr_t)offset, eeconfig_image[offset]);
+        }
+    }
+    memset(eeconfig_dirty, 0, sizeof(eeconfig_dirty));
+    eeconfig_pending = false;
+}
+
+/** \brief eeconfig task
+ *
+ * The delay runs from the first pending change rather than the last, so a
+ * setting held on repeat is still saved every EECONFIG_WRITE_DELAY ms.
+ */
+void eeconfig_task(void) {
+    if (eeconfig_pending && timer_elapsed(eeconfig_pending_time) >= EECONFIG_WRITE_DELAY) {
+        eeconfig_flush();
+    }
+}
+
+static uint8_t eeconfig_read_u8(const void *addr) {
+    uint8_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+static uint16_t eeconfig_read_u16(const void *addr) {
+    uint16_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+static uint32_t eeconfig_read_u32(const void *addr) {
+    uint32_t val;
+    eeconfig_read_block(&val, addr, sizeof(val));
+    return val;
+}
+
+static void eeconfig_update_u8(void *addr, uint8_t val) { eeconfig_update_block(&val, addr, sizeof(val)); }
+
+static void eeconfig_update_u16(void *addr, uint16_t val) { eeconfig_update_block(&val, addr, sizeof(val)); }
+
+static void eeconfig_update_u32(void *addr, uint32_t val) { eeconfig_update_block(&val, addr, sizeof(val)); }
+
 /** \brief eeconfig enable
  *
  * FIXME: needs doc
@@ -31,34 +157,36 @@ __attribute__((weak)) void eeconfig_init_kb(void) {
 void eeconfig_init_quantum(void) {
 #ifdef STM32_EEPROM_ENABLE
     EEPROM_Erase();
+    eeconfig_loaded = false;
 #endif
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
-    eeprom_update_byte(EECONFIG_DEBUG, 0);
-    eeprom_update_byte(EECONFIG_DEFAULT_LAYER, 0);
+    eeconfig_update_u16(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_update_u8(EECONFIG_DEBUG, 0);
+    eeconfig_update_u8(EECONFIG_DEFAULT_LAYER, 0);
     default_layer_state = 0;
-    eeprom_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, 0);
-    eeprom_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, 0);
-    eeprom_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
-    eeprom_update_byte(EECONFIG_BACKLIGHT, 0);
-    eeprom_update_byte(EECONFIG_AUDIO, 0xFF);  // On by default
-    eeprom_update_dword(EECONFIG_RGBLIGHT, 0);
-    eeprom_update_byte(EECONFIG_STENOMODE, 0);
-    eeprom_update_dword(EECONFIG_HAPTIC, 0);
-    eeprom_update_byte(EECONFIG_VELOCIKEY, 0);
-    eeprom_update_dword(EECONFIG_RGB_MATRIX, 0);
-    eeprom_update_byte(EECONFIG_RGB_MATRIX_SPEED, 0);
+    eeconfig_update_u8(EECONFIG_KEYMAP_LOWER_BYTE, 0);
+    eeconfig_update_u8(EECONFIG_KEYMAP_UPPER_BYTE, 0);
+    eeconfig_update_u8(EECONFIG_MOUSEKEY_ACCEL, 0);
+    eeconfig_update_u8(EECONFIG_BACKLIGHT, 0);
+    eeconfig_update_u8(EECONFIG_AUDIO, 0xFF);  // On by default
+    eeconfig_update_u32(EECONFIG_RGBLIGHT, 0);
+    eeconfig_update_u8(EECONFIG_STENOMODE, 0);
+    eeconfig_update_u32(EECONFIG_HAPTIC, 0);
+    eeconfig_update_u8(EECONFIG_VELOCIKEY, 0);
+    eeconfig_update_u32(EECONFIG_RGB_MATRIX, 0);
+    eeconfig_update_u8(EECONFIG_RGB_MATRIX_SPEED, 0);
 
     // TODO: Remove once ARM has a way to configure EECONFIG_HANDEDNESS
     //        within the emulated eeprom via dfu-util or another tool
 #if defined INIT_EE_HANDS_LEFT
 #    pragma message "Faking EE_HANDS for left hand"
-    eeprom_update_byte(EECONFIG_HANDEDNESS, 1);
+    eeconfig_update_u8(EECONFIG_HANDEDNESS, 1);
 #elif defined INIT_EE_HANDS_RIGHT
 #    pragma message "Faking EE_HANDS for right hand"
-    eeprom_update_byte(EECONFIG_HANDEDNESS, 0);
+    eeconfig_update_u8(EECONFIG_HANDEDNESS, 0);
 #endif
 
     eeconfig_init_kb();
+    eeconfig_flush();
 }
 
 /** \brief eeconfig initialization
@@ -71,7 +199,10 @@ void eeconfig_init(void) { eeconfig_init_quantum(); }
  *
  * FIXME: needs doc
  */
-void eeconfig_enable(void) { eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER); }
+void eeconfig_enable(void) {
+    eeconfig_update_u16(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_flush();
+}
 
 /** \brief eeconfig disable
  *
@@ -80,120 +211,122 @@ void eeconfig_enable(void) { eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_N
 void eeconfig_disable(void) {
 #ifdef STM32_EEPROM_ENABLE
     EEPROM_Erase();
+    eeconfig_loaded = false;
 #endif
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
+    eeconfig_update_u16(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
+    eeconfig_flush();
 }
 
 /** \brief eeconfig is enabled
  *
  * FIXME: needs doc
  */
-bool eeconfig_is_enabled(void) { return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER); }
+bool eeconfig_is_enabled(void) { return (eeconfig_read_u16(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER); }
 
 /** \brief eeconfig is disabled
  *
  * FIXME: needs doc
  */
-bool eeconfig_is_disabled(void) { return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER_OFF); }
+bool eeconfig_is_disabled(void) { return (eeconfig_read_u16(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER_OFF); }
 
 /** \brief eeconfig read debug
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_debug(void) { return eeprom_read_byte(EECONFIG_DEBUG); }
+uint8_t eeconfig_read_debug(void) { return eeconfig_read_u8(EECONFIG_DEBUG); }
 /** \brief eeconfig update debug
  *
  * FIXME: needs doc
  */
-void eeconfig_update_debug(uint8_t val) { eeprom_update_byte(EECONFIG_DEBUG, val); }
+void eeconfig_update_debug(uint8_t val) { eeconfig_update_u8(EECONFIG_DEBUG, val); }
 
 /** \brief eeconfig read default layer
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_default_layer(void) { return eeprom_read_byte(EECONFIG_DEFAULT_LAYER); }
+uint8_t eeconfig_read_default_layer(void) { return eeconfig_read_u8(EECONFIG_DEFAULT_LAYER); }
 /** \brief eeconfig update default layer
  *
  * FIXME: needs doc
  */
-void eeconfig_update_default_layer(uint8_t val) { eeprom_update_byte(EECONFIG_DEFAULT_LAYER, val); }
+void eeconfig_update_default_layer(uint8_t val) { eeconfig_update_u8(EECONFIG_DEFAULT_LAYER, val); }
 
 /** \brief eeconfig read keymap
  *
  * FIXME: needs doc
  */
-uint16_t eeconfig_read_keymap(void) { return (eeprom_read_byte(EECONFIG_KEYMAP_LOWER_BYTE) | (eeprom_read_byte(EECONFIG_KEYMAP_UPPER_BYTE) << 8)); }
+uint16_t eeconfig_read_keymap(void) { return (eeconfig_read_u8(EECONFIG_KEYMAP_LOWER_BYTE) | (eeconfig_read_u8(EECONFIG_KEYMAP_UPPER_BYTE) << 8)); }
 /** \brief eeconfig update keymap
  *
  * FIXME: needs doc
  */
 void eeconfig_update_keymap(uint16_t val) {
-    eeprom_update_byte(EECONFIG_KEYMAP_LOWER_BYTE, val & 0xFF);
-    eeprom_update_byte(EECONFIG_KEYMAP_UPPER_BYTE, (val >> 8) & 0xFF);
+    eeconfig_update_u8(EECONFIG_KEYMAP_LOWER_BYTE, val & 0xFF);
+    eeconfig_update_u8(EECONFIG_KEYMAP_UPPER_BYTE, (val >> 8) & 0xFF);
 }
 
 /** \brief eeconfig read backlight
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_backlight(void) { return eeprom_read_byte(EECONFIG_BACKLIGHT); }
+uint8_t eeconfig_read_backlight(void) { return eeconfig_read_u8(EECONFIG_BACKLIGHT); }
 /** \brief eeconfig update backlight
  *
  * FIXME: needs doc
  */
-void eeconfig_update_backlight(uint8_t val) { eeprom_update_byte(EECONFIG_BACKLIGHT, val); }
+void eeconfig_update_backlight(uint8_t val) { eeconfig_update_u8(EECONFIG_BACKLIGHT, val); }
 
 /** \brief eeconfig read audio
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_audio(void) { return eeprom_read_byte(EECONFIG_AUDIO); }
+uint8_t eeconfig_read_audio(void) { return eeconfig_read_u8(EECONFIG_AUDIO); }
 /** \brief eeconfig update audio
  *
  * FIXME: needs doc
  */
-void eeconfig_update_audio(uint8_t val) { eeprom_update_byte(EECONFIG_AUDIO, val); }
+void eeconfig_update_audio(uint8_t val) { eeconfig_update_u8(EECONFIG_AUDIO, val); }
 
 /** \brief eeconfig read kb
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_kb(void) { return eeprom_read_dword(EECONFIG_KEYBOARD); }
+uint32_t eeconfig_read_kb(void) { return eeconfig_read_u32(EECONFIG_KEYBOARD); }
 /** \brief eeconfig update kb
  *
  * FIXME: needs doc
  */
-void eeconfig_update_kb(uint32_t val) { eeprom_update_dword(EECONFIG_KEYBOARD, val); }
+void eeconfig_update_kb(uint32_t val) { eeconfig_update_u32(EECONFIG_KEYBOARD, val); }
 
 /** \brief eeconfig read user
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_user(void) { return eeprom_read_dword(EECONFIG_USER); }
+uint32_t eeconfig_read_user(void) { return eeconfig_read_u32(EECONFIG_USER); }
 /** \brief eeconfig update user
  *
  * FIXME: needs doc
  */
-void eeconfig_update_user(uint32_t val) { eeprom_update_dword(EECONFIG_USER, val); }
+void eeconfig_update_user(uint32_t val) { eeconfig_update_u32(EECONFIG_USER, val); }
 
 /** \brief eeconfig read haptic
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_haptic(void) { return eeprom_read_dword(EECONFIG_HAPTIC); }
+uint32_t eeconfig_read_haptic(void) { return eeconfig_read_u32(EECONFIG_HAPTIC); }
 /** \brief eeconfig update haptic
  *
  * FIXME: needs doc
  */
-void eeconfig_update_haptic(uint32_t val) { eeprom_update_dword(EECONFIG_HAPTIC, val); }
+void eeconfig_update_haptic(uint32_t val) { eeconfig_update_u32(EECONFIG_HAPTIC, val); }
 
 /** \brief eeconfig read split handedness
  *
  * FIXME: needs doc
  */
-bool eeconfig_read_handedness(void) { return !!eeprom_read_byte(EECONFIG_HANDEDNESS); }
+bool eeconfig_read_handedness(void) { return !!eeconfig_read_u8(EECONFIG_HANDEDNESS); }
 /** \brief eeconfig update split handedness
  *
  * FIXME: needs doc
  */
-void eeconfig_update_handedness(bool val) { eeprom_update_byte(EECONFIG_HANDEDNESS, !!val); }
+void eeconfig_update_handedness(bool val) { eeconfig_update_u8(EECONFIG_HANDEDNESS, !!val); }
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifndef EECONFIG_MAGIC_NUMBER
 #    define EECONFIG_MAGIC_NUMBER (uint16_t)0xFEEC
@@ -48,6 +49,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EECONFIG_RGB_MATRIX_SPEED (uint8_t *)32
 // TODO: Combine these into a single word and single block of EEPROM
 #define EECONFIG_KEYMAP_UPPER_BYTE (uint8_t *)33
+
+/* Addresses below EECONFIG_SIZE are kept in RAM. Reads are served from the
+ * copy, changes are written back EECONFIG_WRITE_DELAY ms after the first one,
+ * so a run of setting changes costs one write per byte.
+ */
+#define EECONFIG_SIZE 34
+#ifndef EECONFIG_WRITE_DELAY
+#    define EECONFIG_WRITE_DELAY 500
+#endif
+
 /* debug bit */
 #define EECONFIG_DEBUG_ENABLE (1 << 0)
 #define EECONFIG_DEBUG_MATRIX (1 << 1)
@@ -78,6 +89,16 @@ void eeconfig_enable(void);
 
 void eeconfig_disable(void);
 
+/* Cached access to the config addresses above. Anything outside the
+ * EECONFIG_SIZE bytes goes straight to EEPROM.
+ */
+void eeconfig_read_block(void *buf, const void *addr, size_t len);
+void eeconfig_update_block(const void *buf, void *addr, size_t len);
+/* Write pending changes now, e.g. before jumping to the bootloader. */
+void eeconfig_flush(void);
+/* Write pending changes once EECONFIG_WRITE_DELAY has passed. */
+void eeconfig_task(void);
+
 uint8_t eeconfig_read_debug(void);
 void    eeconfig_update_debug(uint8_t val);
 
@@ -16,6 +16,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdint.h>
+#include <string.h>
 //#include <avr/interrupt.h>
 #include "keycode.h"
 #include "host.h"
@@ -31,7 +32,22 @@ static host_driver_t *driver;
 static uint16_t       last_system_report   = 0;
 static uint16_t       last_consumer_report = 0;
 
-void host_set_driver(host_driver_t *d) { driver = d; }
+/* Keyboard reports are committed rather than sent straight away: inside a batch
+ * releases of keys that were already down are merged into the pending report,
+ * and a report identical to the last one sent never reaches the driver.
+ */
+static report_keyboard_t last_keyboard_report;
+static bool              last_keyboard_report_valid  = false;
+static report_keyboard_t pending_keyboard_report;
+static bool              keyboard_report_pending     = false;
+static uint8_t           keyboard_batch_depth        = 0;
+static uint32_t          keyboard_reports_sent       = 0;
+static uint32_t          keyboard_reports_suppressed = 0;
+
+void host_set_driver(host_driver_t *d) {
+    driver                     = d;
+    last_keyboard_report_valid = false;
+}
 
 host_driver_t *host_get_driver(void) { return driver; }
 
@@ -45,9 +61,56 @@ led_t host_keyboard_led_state(void) {
     return (led_t)((*driver->keyboard_leds)());
 }
 
-/* send report */
-void host_keyboard_send(report_keyboard_t *report) {
+static bool report_has_key(const report_keyboard_t *report, uint8_t key) {
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report->keys[i] == key) return true;
+    }
+    return false;
+}
+
+/* Whether pending has to reach the host before next replaces it. Next may only
+ * be merged into pending when it releases keys that were already down before
+ * pending. A key or modifier next adds would arrive together with pending's
+ * changes, and the host could see the presses in the wrong order, e.g. a roll
+ * read in usage order from the NKRO bitmap. A key pending pressed that next
+ * releases again would never be seen at all.
+ */
+static bool keyboard_report_keeps_order(const report_keyboard_t *pending, const report_keyboard_t *next) {
+    const report_keyboard_t *last = &last_keyboard_report;
+
+    // nothing pending to lose
+    if (memcmp(pending, last, sizeof(report_keyboard_t)) == 0) return false;
+    if (next->mods & ~pending->mods) return true;
+    if (pending->mods & ~last->mods & ~next->mods) return true;
+#ifdef NKRO_ENABLE
+    if (keyboard_protocol && keymap_config.nkro) {
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i++) {
+            if (next->nkro.bits[i] & ~pending->nkro.bits[i]) return true;
+            if (pending->nkro.bits[i] & ~last->nkro.bits[i] & ~next->nkro.bits[i]) return true;
+        }
+        return false;
+    }
+#endif
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        uint8_t key = next->keys[i];
+        if (key && !report_has_key(pending, key)) return true;
+        key = pending->keys[i];
+        if (key && !report_has_key(last, key) && !report_has_key(next, key)) return true;
+    }
+    return false;
+}
+
+static void keyboard_report_commit(report_keyboard_t *report) {
     if (!driver) return;
+
+    if (last_keyboard_report_valid && memcmp(report, &last_keyboard_report, sizeof(report_keyboard_t)) == 0) {
+        keyboard_reports_suppressed++;
+        return;
+    }
+    last_keyboard_report       = *report;
+    last_keyboard_report_valid = true;
+    keyboard_reports_sent++;
+
 #if defined(NKRO_ENABLE) && defined(NKRO_SHARED_EP)
     if (keyboard_protocol && keymap_config.nkro) {
         /* The callers of this function assume that report->mods is where mods go in.
@@ -73,7 +136,47 @@ void host_keyboard_send(report_keyboard_t *report) {
     }
 }
 
+/* send report */
+void host_keyboard_send(report_keyboard_t *report) {
+    if (!keyboard_batch_depth) {
+        keyboard_report_commit(report);
+        return;
+    }
+
+    if (keyboard_report_pending) {
+        if (keyboard_report_keeps_order(&pending_keyboard_report, report)) {
+            keyboard_report_commit(&pending_keyboard_report);
+        } else {
+            // superseded before it was ever sent
+            keyboard_reports_suppressed++;
+        }
+    }
+    pending_keyboard_report = *report;
+    keyboard_report_pending = true;
+}
+
+void host_keyboard_batch_begin(void) { keyboard_batch_depth++; }
+
+void host_keyboard_batch_end(void) {
+    if (keyboard_batch_depth && !--keyboard_batch_depth) {
+        host_keyboard_flush();
+    }
+}
+
+void host_keyboard_flush(void) {
+    if (keyboard_report_pending) {
+        keyboard_report_pending = false;
+        keyboard_report_commit(&pending_keyboard_report);
+    }
+}
+
+uint32_t host_keyboard_reports_sent(void) { return keyboard_reports_sent; }
+
+uint32_t host_keyboard_reports_suppressed(void) { return keyboard_reports_suppressed; }
+
 void host_mouse_send(report_mouse_t *report) {
+    // other reports must not overtake a keyboard report that is still pending
+    host_keyboard_flush();
     if (!driver) return;
 #ifdef MOUSE_SHARED_EP
     report->report_id = REPORT_ID_MOUSE;
@@ -82,6 +185,7 @@ void host_mouse_send(report_mouse_t *report) {
 }
 
 void host_system_send(uint16_t report) {
+    host_keyboard_flush();
     if (report == last_system_report) return;
     last_system_report = report;
 
@@ -90,6 +194,7 @@ void host_system_send(uint16_t report) {
 }
 
 void host_consumer_send(uint16_t report) {
+    host_keyboard_flush();
     if (report == last_consumer_report) return;
     last_consumer_report = report;
 
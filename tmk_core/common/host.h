@@ -51,6 +51,19 @@ void    host_consumer_send(uint16_t data);
 uint16_t host_last_system_report(void);
 uint16_t host_last_consumer_report(void);
 
+/* Keyboard reports sent between begin and end are coalesced and committed at
+ * end, or earlier when needed to keep every press and release visible to the
+ * host in the order it happened. Only releases of keys already down are merged
+ * with earlier changes. wait_ms() and wait_us() call host_keyboard_flush(), code
+ * that blocks any other way should call it first so a pending report goes out
+ * ahead of the delay. Reports identical to the last one sent are dropped.
+ */
+void     host_keyboard_batch_begin(void);
+void     host_keyboard_batch_end(void);
+void     host_keyboard_flush(void);
+uint32_t host_keyboard_reports_sent(void);
+uint32_t host_keyboard_reports_suppressed(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,6 +41,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef MOUSEKEY_ENABLE
 #    include "mousekey.h"
 #endif
+#ifdef MATRIX_TRACE_ENABLE
+#    include "matrix_trace.h"
+#endif
+#ifdef MATRIX_HAS_GHOST
+#    include "matrix_ghost.h"
+#endif
+#ifdef BOOT_TRACE_ENABLE
+#    include "boot_trace.h"
+#endif
 #ifdef PS2_MOUSE_ENABLE
 #    include "ps2_mouse.h"
 #endif
@@ -84,6 +93,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    include "velocikey.h"
 #endif
 
+#ifdef BOOT_TRACE_ENABLE
+#    define BOOT_TRACE(stage) boot_trace_mark(stage)
+#else
+#    define BOOT_TRACE(stage)
+#endif
+
+#ifdef FAST_BOOT_ENABLE
+// How long the peripherals wait for the host before they are initialized anyway,
+// e.g. on the slave half of a split keyboard or when only powered from a charger.
+#    ifndef FAST_BOOT_DEFER_TIMEOUT
+#        define FAST_BOOT_DEFER_TIMEOUT 2000
+#    endif
+static uint16_t boot_time = 0;
+#endif
+static bool peripherals_ready = false;
+
 // Only enable this if console is enabled to print to
 #if defined(DEBUG_MATRIX_SCAN_RATE) && defined(CONSOLE_ENABLE)
 static uint32_t matrix_timer      = 0;
@@ -104,51 +129,6 @@ void matrix_scan_perf_task(void) {
 #    define matrix_scan_perf_task()
 #endif
 
-#ifdef MATRIX_HAS_GHOST
-extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
-static matrix_row_t   get_real_keys(uint8_t row, matrix_row_t rowdata) {
-    matrix_row_t out = 0;
-    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-        // read each key in the row data and check if the keymap defines it as a real key
-        if (pgm_read_byte(&keymaps[0][row][col]) && (rowdata & (1 << col))) {
-            // this creates new row data, if a key is defined in the keymap, it will be set here
-            out |= 1 << col;
-        }
-    }
-    return out;
-}
-
-static inline bool popcount_more_than_one(matrix_row_t rowdata) {
-    rowdata &= rowdata - 1;  // if there are less than two bits (keys) set, rowdata will become zero
-    return rowdata;
-}
-
-static inline bool has_ghost_in_row(uint8_t row, matrix_row_t rowdata) {
-    /* No ghost exists when less than 2 keys are down on the row.
-    If there are "active" blanks in the matrix, the key can't be pressed by the user,
-    there is no doubt as to which keys are really being pressed.
-    The ghosts will be ignored, they are KC_NO.   */
-    rowdata = get_real_keys(row, rowdata);
-    if ((popcount_more_than_one(rowdata)) == 0) {
-        return false;
-    }
-    /* Ghost occurs when the row shares a column line with other row,
-    and two columns are read on each row. Blanks in the matrix don't matter,
-    so they are filtered out.
-    If there are two or more real keys pressed and they match columns with
-    at least two of another row's real keys, the row will be ignored. Keep in mind,
-    we are checking one row at a time, not all of them at once.
-    */
-    for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
-        if (i != row && popcount_more_than_one(get_real_keys(i, matrix_get_row(i)) & rowdata)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-#endif
-
 void disable_jtag(void) {
 // To use PF4-7 (PC2-5 on ATmega32A), disable JTAG by writing JTD bit twice within four cycles.
 #if (defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB647__) || defined(__AVR_AT90USB1286__) || defined(__AVR_AT90USB1287__) || defined(__AVR_ATmega16U4__) || defined(__AVR_ATmega32U4__))
@@ -192,6 +172,48 @@ __attribute__((weak)) void keyboard_post_init_user() {}
 
 __attribute__((weak)) void keyboard_post_init_kb(void) { keyboard_post_init_user(); }
 
+/** \brief keyboard_deferred_init_quantum
+ *
+ * Initializes the quantum features that FAST_BOOT_ENABLE keeps out of matrix_init_quantum().
+ */
+__attribute__((weak)) void keyboard_deferred_init_quantum(void) {}
+
+/** \brief keyboard_host_ready
+ *
+ * Returns true once the host has configured the device. Protocols that can tell override this.
+ */
+__attribute__((weak)) bool keyboard_host_ready(void) { return true; }
+
+/** \brief keyboard_peripherals_ready
+ *
+ * Returns true once the display, lighting, audio and pointing devices are initialized.
+ * Without FAST_BOOT_ENABLE that is the case when keyboard_init() returns.
+ */
+bool keyboard_peripherals_ready(void) { return peripherals_ready; }
+
+/** \brief keyboard_peripherals_init
+ *
+ * With FAST_BOOT_ENABLE, initializes everything the matrix scan does not depend on.
+ * Otherwise keyboard_init() already did so in the usual order. Then runs keyboard_post_init_kb().
+ */
+static void keyboard_peripherals_init(void) {
+#ifdef FAST_BOOT_ENABLE
+#    ifdef OLED_DRIVER_ENABLE
+    oled_init(OLED_ROTATION_0);
+#    endif
+#    ifdef RGBLIGHT_ENABLE
+    rgblight_init();
+#    endif
+#    ifdef POINTING_DEVICE_ENABLE
+    pointing_device_init();
+#    endif
+    keyboard_deferred_init_quantum();
+#endif
+    peripherals_ready = true;
+    BOOT_TRACE(BOOT_STAGE_PERIPHERALS);
+    keyboard_post_init_kb(); /* Always keep this last */
+}
+
 /** \brief keyboard_setup
  *
  * FIXME: needs doc
@@ -217,10 +239,11 @@ __attribute__((weak)) bool is_keyboard_master(void) { return true; }
 void keyboard_init(void) {
     timer_init();
     matrix_init();
+    BOOT_TRACE(BOOT_STAGE_MATRIX);
 #ifdef QWIIC_ENABLE
     qwiic_init();
 #endif
-#ifdef OLED_DRIVER_ENABLE
+#if defined(OLED_DRIVER_ENABLE) && !defined(FAST_BOOT_ENABLE)
     oled_init(OLED_ROTATION_0);
 #endif
 #ifdef PS2_MOUSE_ENABLE
@@ -236,11 +259,15 @@ void keyboard_init(void) {
     bootmagic();
 #else
     magic();
+#endif
+    BOOT_TRACE(BOOT_STAGE_BOOTMAGIC);
+#ifdef MATRIX_HAS_GHOST
+    matrix_ghost_init();
 #endif
 #ifdef BACKLIGHT_ENABLE
     backlight_init();
 #endif
-#ifdef RGBLIGHT_ENABLE
+#if defined(RGBLIGHT_ENABLE) && !defined(FAST_BOOT_ENABLE)
     rgblight_init();
 #endif
 #ifdef STENO_ENABLE
@@ -249,15 +276,56 @@ void keyboard_init(void) {
 #ifdef FAUXCLICKY_ENABLE
     fauxclicky_init();
 #endif
-#ifdef POINTING_DEVICE_ENABLE
+#if defined(POINTING_DEVICE_ENABLE) && !defined(FAST_BOOT_ENABLE)
     pointing_device_init();
 #endif
 #if defined(NKRO_ENABLE) && defined(FORCE_NKRO)
     keymap_config.nkro = 1;
 #endif
-    keyboard_post_init_kb(); /* Always keep this last */
+    BOOT_TRACE(BOOT_STAGE_KEYBOARD);
+#ifdef FAST_BOOT_ENABLE
+    // The rest waits until keyboard_task() sees the host ready, so the first
+    // keystroke does not have to wait for displays and LED drivers.
+    boot_time = timer_read();
+#else
+    keyboard_peripherals_init();
+#endif
 }
 
+/** \brief keyboard_boot_task
+ *
+ * Finishes startup once the host is ready: marks the host stage and initializes
+ * deferred peripherals. Afterwards it prints the boot trace a line at a time.
+ */
+#if defined(FAST_BOOT_ENABLE) || defined(BOOT_TRACE_ENABLE)
+static void keyboard_boot_task(void) {
+    static bool boot_done = false;
+
+    if (boot_done) {
+#    ifdef BOOT_TRACE_ENABLE
+        boot_trace_task();
+#    endif
+        return;
+    }
+
+    bool host_ready = keyboard_host_ready();
+    if (host_ready) {
+        BOOT_TRACE(BOOT_STAGE_HOST);
+    }
+#    ifdef FAST_BOOT_ENABLE
+    if (!host_ready && is_keyboard_master() && timer_elapsed(boot_time) < FAST_BOOT_DEFER_TIMEOUT) {
+        return;
+    }
+    keyboard_peripherals_init();
+#    else
+    if (!host_ready) {
+        return;
+    }
+#    endif
+    boot_done = true;
+}
+#endif
+
 /** \brief Keyboard task: Do keyboard routine jobs
  *
  * Do routine keyboard jobs:
@@ -279,25 +347,36 @@ void keyboard_task(void) {
     uint8_t keys_processed = 0;
 #endif
 
+    // keyboard reports produced during this scan are committed together at the end
+    host_keyboard_batch_begin();
+
 #if defined(OLED_DRIVER_ENABLE) && !defined(OLED_DISABLE_TIMEOUT)
     uint8_t ret = matrix_scan();
 #else
     matrix_scan();
 #endif
+#ifdef MATRIX_HAS_GHOST
+    matrix_ghost_scan();
+#endif
 
     if (is_keyboard_master()) {
         for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
             matrix_row    = matrix_get_row(r);
             matrix_change = matrix_row ^ matrix_prev[r];
             if (matrix_change) {
-#ifdef MATRIX_HAS_GHOST
-                if (has_ghost_in_row(r, matrix_row)) {
-                    continue;
-                }
-#endif
                 if (debug_matrix) matrix_print();
                 for (uint8_t c = 0; c < MATRIX_COLS; c++) {
                     if (matrix_change & ((matrix_row_t)1 << c)) {
+#ifdef MATRIX_HAS_GHOST
+                        // hold back a press that may be a ghost until it no longer completes a rectangle
+                        if ((matrix_row & ((matrix_row_t)1 << c)) && matrix_ghost_is_ambiguous(r, c)) {
+                            continue;
+                        }
+#endif
+#ifdef MATRIX_TRACE_ENABLE
+                        matrix_trace_record(r, c, matrix_row & ((matrix_row_t)1 << c), timer_read());
+#endif
+                        BOOT_TRACE(BOOT_STAGE_FIRST_KEY);
                         action_exec((keyevent_t){
                             .key = (keypos_t){.row = r, .col = c}, .pressed = (matrix_row & ((matrix_row_t)1 << c)), .time = (timer_read() | 1) /* time should not be 0 */
                         });
@@ -327,6 +406,14 @@ MATRIX_LOOP_END:
     matrix_scan_perf_task();
 #endif
 
+#if defined(FAST_BOOT_ENABLE) || defined(BOOT_TRACE_ENABLE)
+    keyboard_boot_task();
+#endif
+
+#ifdef MATRIX_TRACE_ENABLE
+    matrix_trace_task();
+#endif
+
 #ifdef QWIIC_ENABLE
     qwiic_task();
 #endif
@@ -335,7 +422,7 @@ MATRIX_LOOP_END:
     oled_task();
 #    ifndef OLED_DISABLE_TIMEOUT
     // Wake up oled if user is using those fabulous keys!
-    if (ret) oled_on();
+    if (ret && peripherals_ready) oled_on();
 #    endif
 #endif
 
@@ -365,7 +452,9 @@ MATRIX_LOOP_END:
 #endif
 
 #ifdef POINTING_DEVICE_ENABLE
-    pointing_device_task();
+    if (peripherals_ready) {
+        pointing_device_task();
+    }
 #endif
 
 #ifdef MIDI_ENABLE
@@ -378,6 +467,10 @@ MATRIX_LOOP_END:
     }
 #endif
 
+    host_keyboard_batch_end();
+
+    eeconfig_task();
+
     // update LED
     if (led_status != host_keyboard_leds()) {
         led_status = host_keyboard_leds();
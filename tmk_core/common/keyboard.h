@@ -69,6 +69,13 @@ void keyboard_pre_init_user(void);
 void keyboard_post_init_kb(void);
 void keyboard_post_init_user(void);
 
+/* it runs once the host is ready when FAST_BOOT_ENABLE defers peripherals */
+void keyboard_deferred_init_quantum(void);
+/* it tells whether the host has configured the device */
+bool keyboard_host_ready(void);
+/* it tells whether displays, lighting, audio and pointing devices are initialized */
+bool keyboard_peripherals_ready(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,79 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "matrix_ghost.h"
+#include "keymap.h"
+#include "keycode.h"
+#include "util.h"
+
+#ifdef MATRIX_HAS_GHOST
+
+static matrix_row_t real_keys[MATRIX_ROWS];     // positions the keymap defines
+static matrix_row_t rows_down[MATRIX_ROWS];     // real keys read down, per row
+static matrix_col_t columns_down[MATRIX_COLS];  // rows with a real key read down, per column
+
+void matrix_ghost_init(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        real_keys[row] = 0;
+        rows_down[row] = 0;
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (keymap_key_to_keycode(0, (keypos_t){.row = row, .col = col}) != KC_NO) {
+                real_keys[row] |= (matrix_row_t)1 << col;
+            }
+        }
+    }
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        columns_down[col] = 0;
+    }
+}
+
+void matrix_ghost_scan(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix_row_t down    = matrix_get_row(row) & real_keys[row];
+        matrix_row_t changed = down ^ rows_down[row];
+
+        while (changed) {
+            matrix_row_t bit = changed & -changed;
+
+            columns_down[biton32(bit)] ^= (matrix_col_t)1 << row;
+            changed ^= bit;
+        }
+        rows_down[row] = down;
+    }
+}
+
+bool matrix_ghost_is_ambiguous(uint8_t row, uint8_t col) {
+    matrix_row_t others = rows_down[row] & ~((matrix_row_t)1 << col);
+    matrix_col_t rows   = columns_down[col] & ~((matrix_col_t)1 << row);
+
+    if (!(rows_down[row] & ((matrix_row_t)1 << col)) || !others) {
+        return false;
+    }
+
+    // A rectangle needs another row with a key in this column that shares one of this row's other columns
+    while (rows) {
+        matrix_col_t bit = rows & -rows;
+
+        if (rows_down[biton32(bit)] & others) {
+            return true;
+        }
+        rows ^= bit;
+    }
+
+    return false;
+}
+
+#endif
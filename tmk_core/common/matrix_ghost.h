@@ -0,0 +1,45 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+/* Ghost analysis for matrices without diodes (MATRIX_HAS_GHOST)
+ *
+ * Without diodes, three keys down on the corners of a rectangle make the
+ * fourth corner read as down too, and nothing tells the real key from the
+ * ghost. keyboard_task() holds back only presses that complete such a
+ * rectangle, until one of its other corners is let go, instead of ignoring
+ * the whole row.
+ *
+ * Only keys defined on layer 0 count, KC_NO positions can not be pressed.
+ * The keys read down are kept per row and per column, updated from the
+ * changed bits of each scan, so checking a press only looks at the other
+ * keys down in its column.
+ */
+
+/* Read the real key positions from the keymap and forget the matrix state. */
+void matrix_ghost_init(void);
+
+/* Take in the rows of a new scan. Call once after each matrix_scan(). */
+void matrix_ghost_scan(void);
+
+/* Whether the key at row, col is down on a rectangle with three other keys
+ * that are down, so it may be a ghost. */
+bool matrix_ghost_is_ambiguous(uint8_t row, uint8_t col);
@@ -0,0 +1,116 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "matrix_trace.h"
+#include "print.h"
+#if defined(CONSOLE_ENABLE) && (defined(PROTOCOL_LUFA) || defined(PROTOCOL_CHIBIOS))
+#    include "sendchar.h"
+#endif
+
+/* longest line, "65535 127 255 1\n" */
+#define MATRIX_TRACE_LINE_MAX 17
+
+static matrix_trace_event_t trace[MATRIX_TRACE_SIZE];
+static uint16_t             trace_head    = 0;  // oldest event
+static uint16_t             trace_count   = 0;
+static uint16_t             trace_dropped = 0;
+static uint16_t             trace_last_time;
+static bool                 trace_started = false;
+static uint16_t             trace_export  = 0;  // oldest events still to print
+
+void matrix_trace_record(uint8_t row, uint8_t col, bool pressed, uint16_t time) {
+    uint16_t delta = 0;
+
+    if (trace_started) {
+        // Saturate rather than wrap for gaps over a minute
+        uint16_t elapsed = time - trace_last_time;
+        delta            = elapsed < 0x8000 ? elapsed : UINT16_MAX;
+    }
+    trace_started   = true;
+    trace_last_time = time;
+
+    if (trace_count == MATRIX_TRACE_SIZE) {
+        trace_head = (trace_head + 1) % MATRIX_TRACE_SIZE;
+        trace_count--;
+        trace_dropped++;
+        if (trace_export) trace_export--;
+    }
+
+    matrix_trace_event_t *event = &trace[(trace_head + trace_count) % MATRIX_TRACE_SIZE];
+    event->delta                = delta;
+    event->row                  = row | (pressed ? MATRIX_TRACE_PRESSED : 0);
+    event->col                  = col;
+    trace_count++;
+}
+
+void matrix_trace_clear(void) {
+    trace_head    = 0;
+    trace_count   = 0;
+    trace_dropped = 0;
+    trace_started = false;
+    trace_export  = 0;
+}
+
+uint16_t matrix_trace_count(void) { return trace_count; }
+
+uint16_t matrix_trace_dropped(void) { return trace_dropped; }
+
+bool matrix_trace_pop(matrix_trace_event_t *event) {
+    if (trace_count == 0) return false;
+
+    *event     = trace[trace_head];
+    trace_head = (trace_head + 1) % MATRIX_TRACE_SIZE;
+    trace_count--;
+    if (trace_export) trace_export--;
+    return true;
+}
+
+uint8_t matrix_trace_read(uint8_t *data, uint8_t length) {
+    uint8_t              written = 0;
+    matrix_trace_event_t event;
+
+    while (length - written >= MATRIX_TRACE_EVENT_SIZE && matrix_trace_pop(&event)) {
+        data[written++] = event.delta & 0xFF;
+        data[written++] = event.delta >> 8;
+        data[written++] = event.row;
+        data[written++] = event.col;
+    }
+    trace_dropped = 0;
+    return written;
+}
+
+/* The console queue drops what does not fit, so only print a line it can take whole. */
+static bool matrix_trace_console_ready(void) {
+#if defined(CONSOLE_ENABLE) && (defined(PROTOCOL_LUFA) || defined(PROTOCOL_CHIBIOS))
+    return tx_buffer_free(&console_tx_buffer) >= MATRIX_TRACE_LINE_MAX;
+#else
+    return true;
+#endif
+}
+
+void matrix_trace_print(void) {
+    xprintf("matrix trace: %u events, %u dropped\n", trace_count, trace_dropped);
+    trace_export  = trace_count;
+    trace_dropped = 0;
+}
+
+void matrix_trace_task(void) {
+    matrix_trace_event_t event;
+
+    while (trace_export && matrix_trace_console_ready() && matrix_trace_pop(&event)) {
+        xprintf("%u %u %u %u\n", event.delta, event.row & ~MATRIX_TRACE_PRESSED, event.col, (event.row & MATRIX_TRACE_PRESSED) ? 1 : 0);
+    }
+}
@@ -0,0 +1,69 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Matrix event trace
+ *
+ * keyboard_task() records every matrix change it hands to action_exec() in a
+ * ring buffer, so what a board really saw can be pulled over the console with
+ * the matrix trace command, or over raw HID with matrix_trace_read(), and
+ * replayed by the unit tests, see tests/test_common/trace_replay.hpp.
+ *
+ * An event is four bytes: the milliseconds since the previous event as a
+ * little endian word, the row with MATRIX_TRACE_PRESSED set for a press, and
+ * the column. When the buffer is full the oldest event is dropped.
+ */
+
+#ifndef MATRIX_TRACE_SIZE
+#    define MATRIX_TRACE_SIZE 64
+#endif
+
+#define MATRIX_TRACE_PRESSED 0x80
+#define MATRIX_TRACE_EVENT_SIZE 4
+
+typedef struct {
+    uint16_t delta;
+    uint8_t  row;
+    uint8_t  col;
+} matrix_trace_event_t;
+
+void matrix_trace_record(uint8_t row, uint8_t col, bool pressed, uint16_t time);
+void matrix_trace_clear(void);
+
+/* Number of events waiting, and how many were lost to a full buffer. */
+uint16_t matrix_trace_count(void);
+uint16_t matrix_trace_dropped(void);
+
+/* Take the oldest event. Returns false when the trace is empty. */
+bool matrix_trace_pop(matrix_trace_event_t *event);
+
+/* Move as many whole events as fit in length bytes to data, for example to
+ * fill a raw HID report, and reset the drop count, so read it first. Returns
+ * the number of bytes written. */
+uint8_t matrix_trace_read(uint8_t *data, uint8_t length);
+
+/* Print a header with the event and drop counts, reset the drop count and
+ * start printing the waiting events. */
+void matrix_trace_print(void);
+
+/* Called from keyboard_task(). Prints and removes the events a print started
+ * on, one "delta row col pressed" line per event, as fast as the console
+ * takes them. */
+void matrix_trace_task(void);
@@ -21,3 +21,5 @@ uint32_t timer_read32(void) { return timer_count; }
 uint16_t timer_elapsed(uint16_t last) { return TIMER_DIFF_16(timer_read(), last); }
 
 uint32_t timer_elapsed32(uint32_t last) { return TIMER_DIFF_32(timer_read32(), last); }
+
+uint16_t timer_read_us(void) { return (uint16_t)timer_count * 1000; }
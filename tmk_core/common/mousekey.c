@@ -53,12 +53,12 @@ uint8_t mk_interval = MOUSEKEY_INTERVAL;
 uint8_t mk_max_speed = MOUSEKEY_MAX_SPEED;
 /* number of events (count) accelerating to steady speed (0-255) */
 uint8_t mk_time_to_max = MOUSEKEY_TIME_TO_MAX;
-/* ramp used to reach maximum pointer speed (NOT SUPPORTED) */
-// int8_t mk_curve = 0;
 /* wheel params */
 uint8_t mk_wheel_max_speed   = MOUSEKEY_WHEEL_MAX_SPEED;
 uint8_t mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
 
+#    ifndef MK_TIME_BASED
+
 static uint8_t move_unit(void) {
     uint16_t unit;
     if (mousekey_accel & (1 << 0)) {
@@ -196,6 +196,241 @@ void mousekey_off(uint8_t code) {
     if (mouse_report.x == 0 && mouse_report.y == 0 && mouse_report.v == 0 && mouse_report.h == 0) mousekey_repeat = 0;
 }
 
+#    else /* #ifndef MK_TIME_BASED */
+
+/*
+ * Time based acceleration
+ *
+ * Motion is integrated in 1ms steps from the time the first movement key was
+ * pressed, so the distance travelled only depends on how long the keys were
+ * held and not on how often mousekey_task() happens to run. Speeds are kept as
+ * 1/256 pixel per mk_interval and the remainder of each axis is carried over
+ * between reports, so slow movement stays smooth instead of stalling on
+ * truncated units.
+ *
+ * The parameters keep their classic meaning: the steady speed is
+ * MOUSEKEY_MOVE_DELTA * mk_max_speed pixels every mk_interval ms, and it is
+ * reached mk_time_to_max intervals after mk_delay has passed.
+ */
+/* ramp used to reach maximum pointer speed: 0 linear, >0 slow start, <0 fast start */
+int8_t mk_curve = MOUSEKEY_CURVE;
+
+enum { mk_x, mk_y, mk_v, mk_h };
+
+static int8_t   mk_dir[4];    /* x, y, v, h: -1, 0 or 1 */
+static int32_t  mk_acc[4];    /* remainder per axis, interval << 16 units per pixel */
+static uint16_t mk_time  = 0; /* ms of motion integrated so far */
+static uint16_t mk_timer = 0; /* timer value mk_time was last advanced to */
+
+#        define MK_SUM_MAX (INT32_MAX / 2 / 256)
+
+static bool moving(void) { return mk_dir[mk_x] || mk_dir[mk_y] || mk_dir[mk_v] || mk_dir[mk_h]; }
+
+/* fraction of max speed for x/256 of the ramp, shaped by mk_curve */
+static uint16_t curve(uint16_t x) {
+    int16_t quad = (int16_t)((x * x) >> 8);
+    return x + (((int32_t)(quad - (int16_t)x) * mk_curve) >> 7);
+}
+
+/* speed in 1/256 pixel per interval, t ms into the motion */
+static uint32_t speed_at(uint16_t t, uint32_t max, uint8_t time_to_max) {
+    if (mousekey_accel & (1 << 0)) return max / 4;
+    if (mousekey_accel & (1 << 1)) return max / 2;
+    if (mousekey_accel & (1 << 2)) return max;
+    uint16_t delay = mk_delay * 10;
+    if (t < delay) return 0;
+    uint32_t ramp = (uint32_t)time_to_max * mk_interval;
+    t -= delay;
+    if (t >= ramp) return max;
+    uint32_t speed = (max * curve(((uint32_t)t << 8) / ramp)) >> 8;
+    /* never stall, at least one pixel per interval */
+    return speed < 256 ? 256 : speed;
+}
+
+/* sum of speed_at() over the n ms from t, stopping at cap
+ *
+ * Only the ramp is summed ms by ms, without dividing, the delay and the steady
+ * speed after it are added up in one go. Anything past cap would be dropped by
+ * emit() anyway, which keeps the work bounded when mousekey_task() was held up
+ * for long. */
+static uint32_t speed_sum(uint16_t t, uint16_t n, uint32_t max, uint8_t time_to_max, uint32_t cap) {
+    uint16_t delay = mk_delay * 10;
+    uint32_t ramp  = (uint32_t)time_to_max * mk_interval;
+    uint32_t sum   = 0;
+
+    if (!(mousekey_accel & ((1 << 0) | (1 << 1) | (1 << 2)))) {
+        uint16_t idle = (t < delay) ? delay - t : 0;
+        if (idle > n) idle = n;
+        t += idle;
+        n -= idle;
+        if (n && t - delay < ramp) {
+            /* x/256 of the ramp done, as speed_at() works it out */
+            uint32_t done = (uint32_t)(t - delay) << 8;
+            uint16_t x    = done / ramp;
+            uint32_t rest = done % ramp;
+            for (; n && t - delay < ramp && t != UINT16_MAX && sum < cap; n--, t++) {
+                uint32_t speed = (max * curve(x)) >> 8;
+                sum += speed < 256 ? 256 : speed;
+                for (rest += 256; rest >= ramp; rest -= ramp) x++;
+            }
+        }
+    }
+    if (sum >= cap) return cap;
+    if (n) {
+        uint32_t speed = speed_at(t, max, time_to_max);
+        if (speed && n > (cap - sum) / speed) return cap;
+        sum += speed * n;
+    }
+    return sum;
+}
+
+static int8_t emit(uint8_t axis, int8_t limit, int32_t pixel) {
+    int32_t units = mk_acc[axis] / pixel;
+    if (units > limit) units = limit;
+    if (units < -limit) units = -limit;
+    mk_acc[axis] -= units * pixel;
+    /* drop motion the report can't carry instead of piling it up */
+    if (mk_acc[axis] > pixel) mk_acc[axis] = pixel;
+    if (mk_acc[axis] < -pixel) mk_acc[axis] = -pixel;
+    return units;
+}
+
+static void integrate(uint16_t elapsed) {
+    uint32_t move_max   = (uint32_t)MOUSEKEY_MOVE_DELTA * mk_max_speed << 8;
+    uint32_t wheel_max  = (uint32_t)MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed << 8;
+    int32_t  pixel      = (int32_t)(mk_interval ? mk_interval : 1) << 16;
+    uint16_t move_scale = (mk_dir[mk_x] && mk_dir[mk_y]) ? 181 : 256; /* diagonal move [1/sqrt(2)] */
+    /* more than a full report and the pixel emit() keeps over */
+    uint32_t move_cap  = (uint32_t)(MOUSEKEY_MOVE_MAX + 2) * pixel / move_scale;
+    uint32_t wheel_cap = (uint32_t)(MOUSEKEY_WHEEL_MAX + 2) * pixel / 256;
+    if (move_cap > MK_SUM_MAX) move_cap = MK_SUM_MAX;
+    if (wheel_cap > MK_SUM_MAX) wheel_cap = MK_SUM_MAX;
+
+    uint32_t move_sum  = speed_sum(mk_time, elapsed, move_max, mk_time_to_max, move_cap);
+    uint32_t wheel_sum = speed_sum(mk_time, elapsed, wheel_max, mk_wheel_time_to_max, wheel_cap);
+
+    mk_timer += elapsed;
+    mk_time = (elapsed > UINT16_MAX - mk_time) ? UINT16_MAX : mk_time + elapsed;
+    mk_acc[mk_x] += (int32_t)(move_sum * move_scale) * mk_dir[mk_x];
+    mk_acc[mk_y] += (int32_t)(move_sum * move_scale) * mk_dir[mk_y];
+    mk_acc[mk_v] += (int32_t)(wheel_sum << 8) * mk_dir[mk_v];
+    mk_acc[mk_h] += (int32_t)(wheel_sum << 8) * mk_dir[mk_h];
+
+    mouse_report.x = emit(mk_x, MOUSEKEY_MOVE_MAX, pixel);
+    mouse_report.y = emit(mk_y, MOUSEKEY_MOVE_MAX, pixel);
+    mouse_report.v = emit(mk_v, MOUSEKEY_WHEEL_MAX, pixel);
+    mouse_report.h = emit(mk_h, MOUSEKEY_WHEEL_MAX, pixel);
+}
+
+void mousekey_task(void) {
+    if (!moving()) {
+        return;
+    }
+    uint16_t elapsed = timer_elapsed(mk_timer);
+    if (elapsed < MOUSEKEY_FRAME_INTERVAL) {
+        return;
+    }
+    integrate(elapsed);
+    if (mouse_report.x || mouse_report.y || mouse_report.v || mouse_report.h) {
+        if (mousekey_repeat != UINT8_MAX) mousekey_repeat++;
+        mousekey_send();
+    }
+}
+
+static void direction_on(uint8_t axis, int8_t dir, int8_t *field, int8_t unit) {
+    if (!moving()) {
+        mk_time  = 0;
+        mk_timer = timer_read();
+    }
+    mk_dir[axis] = dir;
+    mk_acc[axis] = 0;
+    /* single step on press, continuous motion starts after mk_delay */
+    *field = unit * dir;
+}
+
+static void direction_off(uint8_t axis, int8_t dir) {
+    if (mk_dir[axis] == dir) {
+        mk_dir[axis] = 0;
+        mk_acc[axis] = 0;
+    }
+}
+
+void mousekey_on(uint8_t code) {
+    /* catch up to now so the change only applies from here on */
+    if (moving()) integrate(timer_elapsed(mk_timer));
+    if (code == KC_MS_UP)
+        direction_on(mk_y, -1, &mouse_report.y, MOUSEKEY_MOVE_DELTA);
+    else if (code == KC_MS_DOWN)
+        direction_on(mk_y, 1, &mouse_report.y, MOUSEKEY_MOVE_DELTA);
+    else if (code == KC_MS_LEFT)
+        direction_on(mk_x, -1, &mouse_report.x, MOUSEKEY_MOVE_DELTA);
+    else if (code == KC_MS_RIGHT)
+        direction_on(mk_x, 1, &mouse_report.x, MOUSEKEY_MOVE_DELTA);
+    else if (code == KC_MS_WH_UP)
+        direction_on(mk_v, 1, &mouse_report.v, MOUSEKEY_WHEEL_DELTA);
+    else if (code == KC_MS_WH_DOWN)
+        direction_on(mk_v, -1, &mouse_report.v, MOUSEKEY_WHEEL_DELTA);
+    else if (code == KC_MS_WH_LEFT)
+        direction_on(mk_h, -1, &mouse_report.h, MOUSEKEY_WHEEL_DELTA);
+    else if (code == KC_MS_WH_RIGHT)
+        direction_on(mk_h, 1, &mouse_report.h, MOUSEKEY_WHEEL_DELTA);
+    else if (code == KC_MS_BTN1)
+        mouse_report.buttons |= MOUSE_BTN1;
+    else if (code == KC_MS_BTN2)
+        mouse_report.buttons |= MOUSE_BTN2;
+    else if (code == KC_MS_BTN3)
+        mouse_report.buttons |= MOUSE_BTN3;
+    else if (code == KC_MS_BTN4)
+        mouse_report.buttons |= MOUSE_BTN4;
+    else if (code == KC_MS_BTN5)
+        mouse_report.buttons |= MOUSE_BTN5;
+    else if (code == KC_MS_ACCEL0)
+        mousekey_accel |= (1 << 0);
+    else if (code == KC_MS_ACCEL1)
+        mousekey_accel |= (1 << 1);
+    else if (code == KC_MS_ACCEL2)
+        mousekey_accel |= (1 << 2);
+}
+
+void mousekey_off(uint8_t code) {
+    if (moving()) integrate(timer_elapsed(mk_timer));
+    if (code == KC_MS_UP)
+        direction_off(mk_y, -1);
+    else if (code == KC_MS_DOWN)
+        direction_off(mk_y, 1);
+    else if (code == KC_MS_LEFT)
+        direction_off(mk_x, -1);
+    else if (code == KC_MS_RIGHT)
+        direction_off(mk_x, 1);
+    else if (code == KC_MS_WH_UP)
+        direction_off(mk_v, 1);
+    else if (code == KC_MS_WH_DOWN)
+        direction_off(mk_v, -1);
+    else if (code == KC_MS_WH_LEFT)
+        direction_off(mk_h, -1);
+    else if (code == KC_MS_WH_RIGHT)
+        direction_off(mk_h, 1);
+    else if (code == KC_MS_BTN1)
+        mouse_report.buttons &= ~MOUSE_BTN1;
+    else if (code == KC_MS_BTN2)
+        mouse_report.buttons &= ~MOUSE_BTN2;
+    else if (code == KC_MS_BTN3)
+        mouse_report.buttons &= ~MOUSE_BTN3;
+    else if (code == KC_MS_BTN4)
+        mouse_report.buttons &= ~MOUSE_BTN4;
+    else if (code == KC_MS_BTN5)
+        mouse_report.buttons &= ~MOUSE_BTN5;
+    else if (code == KC_MS_ACCEL0)
+        mousekey_accel &= ~(1 << 0);
+    else if (code == KC_MS_ACCEL1)
+        mousekey_accel &= ~(1 << 1);
+    else if (code == KC_MS_ACCEL2)
+        mousekey_accel &= ~(1 << 2);
+    if (!moving()) mousekey_repeat = 0;
+}
+
+#    endif /* #ifndef MK_TIME_BASED */
+
 #else /* #ifndef MK_3_SPEED */
 
 enum { mkspd_unmod, mkspd_0, mkspd_1, mkspd_2, mkspd_COUNT };
@@ -345,12 +580,22 @@ void mousekey_send(void) {
     mousekey_debug();
     host_mouse_send(&mouse_report);
     last_timer = timer_read();
+#if !defined(MK_3_SPEED) && defined(MK_TIME_BASED)
+    /* motion is relative, only buttons persist between reports */
+    mouse_report.x = mouse_report.y = mouse_report.v = mouse_report.h = 0;
+#endif
 }
 
 void mousekey_clear(void) {
     mouse_report    = (report_mouse_t){};
     mousekey_repeat = 0;
     mousekey_accel  = 0;
+#if !defined(MK_3_SPEED) && defined(MK_TIME_BASED)
+    for (uint8_t i = 0; i < 4; i++) {
+        mk_dir[i] = 0;
+        mk_acc[i] = 0;
+    }
+#endif
 }
 
 static void mousekey_debug(void) {
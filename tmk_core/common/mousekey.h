@@ -62,6 +62,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #        define MOUSEKEY_WHEEL_TIME_TO_MAX 40
 #    endif
 
+#    ifdef MK_TIME_BASED
+#        ifndef MOUSEKEY_FRAME_INTERVAL
+#            define MOUSEKEY_FRAME_INTERVAL 8
+#        endif
+#        ifndef MOUSEKEY_CURVE
+#            define MOUSEKEY_CURVE 0
+#        endif
+#    endif
+
 #else /* #ifndef MK_3_SPEED */
 
 #    ifndef MK_C_OFFSET_UNMOD
@@ -126,6 +135,9 @@ extern uint8_t mk_max_speed;
 extern uint8_t mk_time_to_max;
 extern uint8_t mk_wheel_max_speed;
 extern uint8_t mk_wheel_time_to_max;
+#ifdef MK_TIME_BASED
+extern int8_t mk_curve;
+#endif
 
 void mousekey_task(void);
 void mousekey_on(uint8_t code);
@@ -1,8 +1,22 @@
 #ifndef _RAW_HID_H_
 #define _RAW_HID_H_
 
+#include "tx_buffer.h"
+
+/* bytes of outgoing reports queued between USB tasks, power of two up to 32768 */
+#ifndef RAW_TX_BUFFER_SIZE
+#    ifdef __AVR__
+#        define RAW_TX_BUFFER_SIZE 32
+#    else
+#        define RAW_TX_BUFFER_SIZE 64
+#    endif
+#endif
+
 void raw_hid_receive(uint8_t *data, uint8_t length);
 
+/* Queue a report; it is sent from the USB task. Reports that do not fit are dropped and counted. */
 void raw_hid_send(uint8_t *data, uint8_t length);
 
+extern tx_buffer_t raw_hid_tx_buffer;
+
 #endif
@@ -19,6 +19,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define SENDCHAR_H
 
 #include <stdint.h>
+#include "tx_buffer.h"
+
+/* bytes of console output queued between USB tasks, power of two up to 32768 */
+#ifndef CONSOLE_TX_BUFFER_SIZE
+#    ifdef __AVR__
+#        define CONSOLE_TX_BUFFER_SIZE 64
+#    else
+#        define CONSOLE_TX_BUFFER_SIZE 256
+#    endif
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,6 +37,9 @@ extern "C" {
 /* transmit a character.  return 0 on success, -1 on error. */
 int8_t sendchar(uint8_t c);
 
+/* console output queue; dropped and high_watermark show whether CONSOLE_TX_BUFFER_SIZE is large enough */
+extern tx_buffer_t console_tx_buffer;
+
 #ifdef __cplusplus
 }
 #endif
@@ -44,6 +44,10 @@ uint32_t timer_read32(void);
 uint16_t timer_elapsed(uint16_t last);
 uint32_t timer_elapsed32(uint32_t last);
 
+// Microsecond counter for timing short stretches of code, it wraps every 65ms.
+// The resolution depends on the platform, down to a whole millisecond.
+uint16_t timer_read_us(void);
+
 // Utility functions to check if a future time has expired & autmatically handle time wrapping if checked / reset frequently (half of max value)
 inline bool timer_expired(uint16_t current, uint16_t future) { return (uint16_t)(current - future) < 0x8000; }
 
@@ -0,0 +1,78 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tx_buffer.h"
+
+/* Keep the compiler from moving data accesses across an index update. */
+#define TX_BUFFER_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+bool tx_buffer_write(tx_buffer_t *buffer, const uint8_t *data, uint8_t length) {
+    uint16_t used = tx_buffer_used(buffer);
+    if (length > tx_buffer_free(buffer)) {
+        if (buffer->dropped < UINT16_MAX - length) {
+            buffer->dropped += length;
+        } else {
+            buffer->dropped = UINT16_MAX;
+        }
+        return false;
+    }
+
+    uint16_t head = buffer->head;
+    for (uint8_t i = 0; i < length; i++) {
+        buffer->data[head++ & buffer->mask] = data[i];
+    }
+    TX_BUFFER_BARRIER();
+    buffer->head = head;
+
+    used += length;
+    if (used > buffer->high_watermark) {
+        buffer->high_watermark = used;
+    }
+    return true;
+}
+
+uint8_t tx_buffer_read(tx_buffer_t *buffer, uint8_t *data, uint8_t length) {
+    uint16_t used = tx_buffer_used(buffer);
+    if (length > used) {
+        length = used;
+    }
+
+    uint16_t tail = buffer->tail;
+    TX_BUFFER_BARRIER();
+    for (uint8_t i = 0; i < length; i++) {
+        data[i] = buffer->data[tail++ & buffer->mask];
+    }
+    TX_BUFFER_BARRIER();
+    buffer->tail = tail;
+    return length;
+}
+
+uint16_t tx_buffer_peek(tx_buffer_t *buffer, const uint8_t **data) {
+    uint16_t used   = tx_buffer_used(buffer);
+    uint16_t offset = buffer->tail & buffer->mask;
+    uint16_t run    = buffer->mask + 1 - offset;
+
+    TX_BUFFER_BARRIER();
+    *data = &buffer->data[offset];
+    return used < run ? used : run;
+}
+
+void tx_buffer_consume(tx_buffer_t *buffer, uint16_t length) {
+    TX_BUFFER_BARRIER();
+    buffer->tail += length;
+}
+
+void tx_buffer_clear(tx_buffer_t *buffer) { buffer->tail = buffer->head; }
@@ -0,0 +1,71 @@
+/* Copyright 2020 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Single producer, single consumer transmit buffer.
+ *
+ * The producer (sendchar, virtser_send, raw_hid_send) only ever moves head,
+ * the consumer (the protocol's USB task) only ever moves tail. Both indices
+ * are free running 16-bit counters. They are stored in one go on 32-bit MCUs,
+ * and on AVR both sides run from the main loop, so no interrupt locking is
+ * needed. Interrupt handlers must not print or send through these buffers,
+ * they would be a second producer. The size must be a power of two no larger than 32768, so a full
+ * buffer can be told from an empty one.
+ */
+typedef struct {
+    uint8_t *         data;
+    uint16_t          mask;
+    volatile uint16_t head;
+    volatile uint16_t tail;
+    uint16_t          high_watermark;
+    uint16_t          dropped;
+} tx_buffer_t;
+
+#define TX_BUFFER_DEFINE(name, size)                                                                                      \
+    _Static_assert((size) > 0 && ((size) & ((size)-1)) == 0 && (size) <= 32768, #size " must be a power of two up to 32768"); \
+    static uint8_t name##_data[(size)];                                                                                   \
+    tx_buffer_t    name = {.data = name##_data, .mask = (size)-1}
+
+/* Queue length bytes, all or nothing. Returns false and counts the bytes as dropped when they do not fit. */
+bool tx_buffer_write(tx_buffer_t *buffer, const uint8_t *data, uint8_t length);
+
+/* Copy up to length queued bytes into data and release them. Returns the number of bytes copied. */
+uint8_t tx_buffer_read(tx_buffer_t *buffer, uint8_t *data, uint8_t length);
+
+/* Point data at the oldest queued bytes without releasing them. Returns how many are contiguous. */
+uint16_t tx_buffer_peek(tx_buffer_t *buffer, const uint8_t **data);
+
+/* Release length bytes previously returned by tx_buffer_peek(). */
+void tx_buffer_consume(tx_buffer_t *buffer, uint16_t length);
+
+/* Drop everything queued, e.g. when the host closes the port. Does not count as an overflow. */
+void tx_buffer_clear(tx_buffer_t *buffer);
+
+static inline uint16_t tx_buffer_used(const tx_buffer_t *buffer) { return (uint16_t)(buffer->head - buffer->tail); }
+
+static inline uint16_t tx_buffer_free(const tx_buffer_t *buffer) { return buffer->mask + 1 - tx_buffer_used(buffer); }
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,10 +1,23 @@
 #ifndef _VIRTSER_H_
 #define _VIRTSER_H_
 
+#include "tx_buffer.h"
+
+/* bytes of outgoing serial data queued between USB tasks, power of two up to 32768 */
+#ifndef VIRTSER_TX_BUFFER_SIZE
+#    ifdef __AVR__
+#        define VIRTSER_TX_BUFFER_SIZE 32
+#    else
+#        define VIRTSER_TX_BUFFER_SIZE 64
+#    endif
+#endif
+
 /* Define this function in your code to process incoming bytes */
 void virtser_recv(const uint8_t ch);
 
 /* Call this to send a character over the Virtual Serial Device */
 void virtser_send(const uint8_t byte);
 
+extern tx_buffer_t virtser_tx_buffer;
+
 #endif
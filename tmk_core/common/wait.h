@@ -7,14 +7,20 @@
 extern "C" {
 #endif
 
+/* Keyboard reports held back for the end of the scan are sent before waiting,
+ * so register_code(); wait_ms(n); unregister_code(); holds the key for n ms.
+ */
+void host_keyboard_flush(void);
+
 #if defined(__AVR__)
 #    include <util/delay.h>
-#    define wait_ms(ms) _delay_ms(ms)
-#    define wait_us(us) _delay_us(us)
+#    define wait_ms(ms) (host_keyboard_flush(), _delay_ms(ms))
+#    define wait_us(us) (host_keyboard_flush(), _delay_us(us))
 #elif defined PROTOCOL_CHIBIOS
 #    include "ch.h"
 #    define wait_ms(ms)                     \
         do {                                \
+            host_keyboard_flush();          \
             if (ms != 0) {                  \
                 chThdSleepMilliseconds(ms); \
             } else {                        \
@@ -23,6 +29,7 @@ extern "C" {
         } while (0)
 #    define wait_us(us)                     \
         do {                                \
+            host_keyboard_flush();          \
             if (us != 0) {                  \
                 chThdSleepMicroseconds(us); \
             } else {                        \
@@ -31,8 +38,8 @@ extern "C" {
         } while (0)
 #elif defined PROTOCOL_ARM_ATSAM
 #    include "clks.h"
-#    define wait_ms(ms) CLK_delay_ms(ms)
-#    define wait_us(us) CLK_delay_us(us)
+#    define wait_ms(ms) (host_keyboard_flush(), CLK_delay_ms(ms))
+#    define wait_us(us) (host_keyboard_flush(), CLK_delay_us(us))
 #elif defined(__arm__)
 #    include "wait_api.h"
 #else  // Unit tests
@@ -82,6 +82,16 @@ void raw_hid_task(void);
 void console_task(void);
 #endif
 
+#ifdef FAST_BOOT_ENABLE
+/* Poll the USB state every millisecond while waiting for it */
+#    define USB_WAIT_INTERVAL 1
+#else
+#    define USB_WAIT_INTERVAL 50
+#endif
+
+/* FAST_BOOT_ENABLE initializes the peripherals once the host has configured us */
+bool keyboard_host_ready(void) { return USB_DRIVER.state == USB_ACTIVE; }
+
 /* TESTING
  * Amber LED blinker thread, times are in milliseconds.
  */
@@ -156,15 +166,17 @@ int main(void) {
         }
         serial_link_update();
 #endif
-        wait_ms(50);
+        wait_ms(USB_WAIT_INTERVAL);
     }
 
+#if !defined(FAST_BOOT_ENABLE) || defined(CONSOLE_ENABLE)
     /* Do need to wait here!
      * Otherwise the next print might start a transfer on console EP
      * before the USB is completely ready, which sometimes causes
      * HardFaults.
      */
     wait_ms(50);
+#endif
 
     print("USB configured.\n");
 
@@ -30,6 +30,13 @@
 #include "wait.h"
 #include "usb_descriptor.h"
 #include "usb_driver.h"
+#include "sendchar.h"
+#ifdef RAW_ENABLE
+#    include "raw_hid.h"
+#endif
+#ifdef VIRTSER_ENABLE
+#    include "virtser.h"
+#endif
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
@@ -736,6 +743,21 @@ void send_system(uint16_t data) { (void)data; }
 void send_consumer(uint16_t data) { (void)data; }
 #endif /* EXTRAKEY_ENABLE */
 
+#if defined(CONSOLE_ENABLE) || defined(RAW_ENABLE) || defined(VIRTSER_ENABLE)
+/* Drain as much of a transmit buffer into a stream as its output queue accepts, without blocking. */
+static void tx_buffer_flush(tx_buffer_t *buffer, BaseChannel *channel) {
+    const uint8_t *data;
+    uint16_t       length;
+    while ((length = tx_buffer_peek(buffer, &data)) > 0) {
+        size_t written = chnWriteTimeout(channel, data, length, TIME_IMMEDIATE);
+        tx_buffer_consume(buffer, written);
+        if (written < length) {
+            break;
+        }
+    }
+}
+#endif
+
 /* ---------------------------------------------------------
  *                   Console functions
  * ---------------------------------------------------------
@@ -743,10 +765,12 @@ void send_consumer(uint16_t data) { (void)data; }
 
 #ifdef CONSOLE_ENABLE
 
+TX_BUFFER_DEFINE(console_tx_buffer, CONSOLE_TX_BUFFER_SIZE);
+
 int8_t sendchar(uint8_t c) {
-    // The previous implmentation had timeouts, but I think it's better to just slow down
-    // and make sure that everything is transferred, rather than dropping stuff
-    return chnWrite(&drivers.console_driver.driver, &c, 1);
+    // Queue only; console_task() hands the bytes to the USB driver in bulk,
+    // so printing never stalls the scan loop waiting on the host.
+    return tx_buffer_write(&console_tx_buffer, &c, 1) ? 0 : -1;
 }
 
 // Just a dummy function for now, this could be exposed as a weak function
@@ -757,6 +781,8 @@ static void console_receive(uint8_t *data, uint8_t length) {
 }
 
 void console_task(void) {
+    tx_buffer_flush(&console_tx_buffer, (BaseChannel *)&drivers.console_driver.driver);
+
     uint8_t buffer[CONSOLE_EPSIZE];
     size_t  size = 0;
     do {
@@ -780,12 +806,14 @@ void sendchar_pf(void *p, char c) {
 }
 
 #ifdef RAW_ENABLE
+TX_BUFFER_DEFINE(raw_hid_tx_buffer, RAW_TX_BUFFER_SIZE);
+
 void raw_hid_send(uint8_t *data, uint8_t length) {
     // TODO: implement variable size packet
     if (length != RAW_EPSIZE) {
         return;
     }
-    chnWrite(&drivers.raw_driver.driver, data, length);
+    tx_buffer_write(&raw_hid_tx_buffer, data, length);
 }
 
 __attribute__((weak)) void raw_hid_receive(uint8_t *data, uint8_t length) {
@@ -795,6 +823,9 @@ __attribute__((weak)) void raw_hid_receive(uint8_t *data, uint8_t length) {
 }
 
 void raw_hid_task(void) {
+    // Whole reports are queued, and each one lands in an empty output buffer, so reports are never split.
+    tx_buffer_flush(&raw_hid_tx_buffer, (BaseChannel *)&drivers.raw_driver.driver);
+
     uint8_t buffer[RAW_EPSIZE];
     size_t  size = 0;
     do {
@@ -820,13 +851,17 @@ bool recv_midi_packet(MIDI_EventPacket_t *const event) {
 
 #ifdef VIRTSER_ENABLE
 
-void virtser_send(const uint8_t byte) { chnWrite(&drivers.serial_driver.driver, &byte, 1); }
+TX_BUFFER_DEFINE(virtser_tx_buffer, VIRTSER_TX_BUFFER_SIZE);
+
+void virtser_send(const uint8_t byte) { tx_buffer_write(&virtser_tx_buffer, &byte, 1); }
 
 __attribute__((weak)) void virtser_recv(uint8_t c) {
     // Ignore by default
 }
 
 void virtser_task(void) {
+    tx_buffer_flush(&virtser_tx_buffer, (BaseChannel *)&drivers.serial_driver.driver);
+
     uint8_t numBytesReceived = 0;
     uint8_t buffer[16];
     do {
@@ -136,9 +136,11 @@ USB_ClassInfo_CDC_Device_t cdc_device = {
 
 #ifdef RAW_ENABLE
 
+TX_BUFFER_DEFINE(raw_hid_tx_buffer, RAW_TX_BUFFER_SIZE);
+
 /** \brief Raw HID Send
  *
- * FIXME: Needs doc
+ * Queues a report for raw_hid_task().
  */
 void raw_hid_send(uint8_t *data, uint8_t length) {
     // TODO: implement variable size packet
@@ -146,25 +148,9 @@ void raw_hid_send(uint8_t *data, uint8_t length) {
         return;
     }
 
-    if (USB_DeviceState != DEVICE_STATE_Configured) {
-        return;
-    }
-
-    // TODO: decide if we allow calls to raw_hid_send() in the middle
-    // of other endpoint usage.
-    uint8_t ep = Endpoint_GetCurrentEndpoint();
-
-    Endpoint_SelectEndpoint(RAW_IN_EPNUM);
-
-    // Check to see if the host is ready to accept another packet
-    if (Endpoint_IsINReady()) {
-        // Write data
-        Endpoint_Write_Stream_LE(data, RAW_EPSIZE, NULL);
-        // Finalize the stream transfer to send the last packet
-        Endpoint_ClearIN();
-    }
-
-    Endpoint_SelectEndpoint(ep);
+    // Queued here and sent by raw_hid_task(), so this is safe to call
+    // in the middle of other endpoint usage.
+    tx_buffer_write(&raw_hid_tx_buffer, data, length);
 }
 
 /** \brief Raw HID Receive
@@ -207,6 +193,16 @@ static void raw_hid_task(void) {
             raw_hid_receive(data, sizeof(data));
         }
     }
+
+    // Send one queued report per pass, once the host has collected the previous one
+    if (tx_buffer_used(&raw_hid_tx_buffer) >= RAW_EPSIZE) {
+        Endpoint_SelectEndpoint(RAW_IN_EPNUM);
+        if (Endpoint_IsINReady()) {
+            tx_buffer_read(&raw_hid_tx_buffer, data, RAW_EPSIZE);
+            Endpoint_Write_Stream_LE(data, RAW_EPSIZE, NULL);
+            Endpoint_ClearIN();
+        }
+    }
 }
 #endif
 
@@ -214,9 +210,13 @@ static void raw_hid_task(void) {
  * Console
  ******************************************************************************/
 #ifdef CONSOLE_ENABLE
+TX_BUFFER_DEFINE(console_tx_buffer, CONSOLE_TX_BUFFER_SIZE);
+
 /** \brief Console Task
  *
- * FIXME: Needs doc
+ * Sends queued console output from the main loop. Full reports go out for as long
+ * as the endpoint takes them; a partial report is only padded and sent once nothing
+ * new was printed since the previous pass, so output from one scan shares packets.
  */
 static void Console_Task(void) {
     /* Device must be connected and configured for the task to run */
@@ -256,13 +256,16 @@ static void Console_Task(void) {
         return;
     }
 
-    // fill empty bank
-    while (Endpoint_IsReadWriteAllowed()) Endpoint_Write_8(0);
-
-    // flash senchar packet
-    if (Endpoint_IsINReady()) {
+    static uint16_t last_used = 0;
+    uint16_t        used      = tx_buffer_used(&console_tx_buffer);
+    while ((used >= CONSOLE_EPSIZE || (used && used == last_used)) && Endpoint_IsINReady()) {
+        uint8_t report[CONSOLE_EPSIZE] = {0};
+        tx_buffer_read(&console_tx_buffer, report, sizeof(report));
+        Endpoint_Write_Stream_LE(report, sizeof(report), NULL);
         Endpoint_ClearIN();
+        used = tx_buffer_used(&console_tx_buffer);
     }
+    last_used = used;
 
     Endpoint_SelectEndpoint(ep);
 }
@@ -278,12 +281,39 @@ static void Console_Task(void) {
  * 2) EVENT_USB_Device_Reset
  * 3) EVENT_USB_Device_Wake
  */
+
+/* The handlers run in the USB interrupt, while the console queue only takes
+ * output from the main loop. They note the event here and usb_event_print()
+ * prints it from the main loop.
+ */
+#define USB_EVENT_CONNECT (1 << 0)
+#define USB_EVENT_DISCONNECT (1 << 1)
+#define USB_EVENT_RESET (1 << 2)
+#define USB_EVENT_SUSPEND (1 << 3)
+#define USB_EVENT_WAKEUP (1 << 4)
+
+static volatile uint8_t usb_events = 0;
+
+static void usb_event_print(void) {
+    uint8_t events;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        events     = usb_events;
+        usb_events = 0;
+    }
+    if (events & USB_EVENT_CONNECT) print("[C]");
+    if (events & USB_EVENT_DISCONNECT) print("[D]");
+    if (events & USB_EVENT_RESET) print("[R]");
+    if (events & USB_EVENT_SUSPEND) print("[S]");
+    if (events & USB_EVENT_WAKEUP) print("[W]");
+}
+
 /** \brief Event USB Device Connect
  *
  * FIXME: Needs doc
  */
 void EVENT_USB_Device_Connect(void) {
-    print("[C]");
+    usb_events |= USB_EVENT_CONNECT;
     /* For battery powered device */
     if (!USB_IsInitialized) {
         USB_Disable();
@@ -297,7 +327,7 @@ void EVENT_USB_Device_Connect(void) {
  * FIXME: Needs doc
  */
 void EVENT_USB_Device_Disconnect(void) {
-    print("[D]");
+    usb_events |= USB_EVENT_DISCONNECT;
     /* For battery powered device */
     USB_IsInitialized = false;
     /* TODO: This doesn't work. After several plug in/outs can not be enumerated.
@@ -313,14 +343,14 @@ void EVENT_USB_Device_Disconnect(void) {
  *
  * FIXME: Needs doc
  */
-void EVENT_USB_Device_Reset(void) { print("[R]"); }
+void EVENT_USB_Device_Reset(void) { usb_events |= USB_EVENT_RESET; }
 
 /** \brief Event USB Device Connect
  *
  * FIXME: Needs doc
  */
 void EVENT_USB_Device_Suspend() {
-    print("[S]");
+    usb_events |= USB_EVENT_SUSPEND;
 #ifdef SLEEP_LED_ENABLE
     sleep_led_enable();
 #endif
@@ -331,7 +361,7 @@ void EVENT_USB_Device_Suspend() {
  * FIXME: Needs doc
  */
 void EVENT_USB_Device_WakeUp() {
-    print("[W]");
+    usb_events |= USB_EVENT_WAKEUP;
     suspend_wakeup_init();
 
 #ifdef SLEEP_LED_ENABLE
@@ -341,30 +371,6 @@ void EVENT_USB_Device_WakeUp() {
 #endif
 }
 
-#ifdef CONSOLE_ENABLE
-static bool console_flush = false;
-#    define CONSOLE_FLUSH_SET(b)                                     \
-        do {                                                         \
-            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { console_flush = b; } \
-        } while (0)
-
-/** \brief Event USB Device Start Of Frame
- *
- * FIXME: Needs doc
- * called every 1ms
- */
-void EVENT_USB_Device_StartOfFrame(void) {
-    static uint8_t count;
-    if (++count % 50) return;
-    count = 0;
-
-    if (!console_flush) return;
-    Console_Task();
-    console_flush = false;
-}
-
-#endif
-
 /** \brief Event handler for the USB_ConfigurationChanged event.
  *
  * This is fired when the host sets the current configuration of the USB device after enumeration.
@@ -552,6 +558,12 @@ void EVENT_USB_Device_ControlRequest(void) {
  */
 static uint8_t keyboard_leds(void) { return keyboard_led_stats; }
 
+/** \brief Keyboard Host Ready
+ *
+ * Lets FAST_BOOT_ENABLE initialize the peripherals once enumeration is done.
+ */
+bool keyboard_host_ready(void) { return USB_DeviceState == DEVICE_STATE_Configured; }
+
 /** \brief Send Keyboard
  *
  * FIXME: Needs doc
@@ -745,66 +757,12 @@ static void send_consumer(uint16_t data) {
  * sendchar
  ******************************************************************************/
 #ifdef CONSOLE_ENABLE
-#    define SEND_TIMEOUT 5
 /** \brief Send Char
  *
- * FIXME: Needs doc
+ * Queues the character for Console_Task(), so printing never waits on the host.
+ * Returns -1 when the queue is full and the character was dropped.
  */
-int8_t sendchar(uint8_t c) {
-    // Not wait once timeouted.
-    // Because sendchar() is called so many times, waiting each call causes big lag.
-    static bool timeouted = false;
-
-    // prevents Console_Task() from running during sendchar() runs.
-    // or char will be lost. These two function is mutually exclusive.
-    CONSOLE_FLUSH_SET(false);
-
-    if (USB_DeviceState != DEVICE_STATE_Configured) return -1;
-
-    uint8_t ep = Endpoint_GetCurrentEndpoint();
-    Endpoint_SelectEndpoint(CONSOLE_IN_EPNUM);
-    if (!Endpoint_IsEnabled() || !Endpoint_IsConfigured()) {
-        goto ERROR_EXIT;
-    }
-
-    if (timeouted && !Endpoint_IsReadWriteAllowed()) {
-        goto ERROR_EXIT;
-    }
-
-    timeouted = false;
-
-    uint8_t timeout = SEND_TIMEOUT;
-    while (!Endpoint_IsReadWriteAllowed()) {
-        if (USB_DeviceState != DEVICE_STATE_Configured) {
-            goto ERROR_EXIT;
-        }
-        if (Endpoint_IsStalled()) {
-            goto ERROR_EXIT;
-        }
-        if (!(timeout--)) {
-            timeouted = true;
-            goto ERROR_EXIT;
-        }
-        _delay_ms(1);
-    }
-
-    Endpoint_Write_8(c);
-
-    // send when bank is full
-    if (!Endpoint_IsReadWriteAllowed()) {
-        while (!(Endpoint_IsINReady()))
-            ;
-        Endpoint_ClearIN();
-    } else {
-        CONSOLE_FLUSH_SET(true);
-    }
-
-    Endpoint_SelectEndpoint(ep);
-    return 0;
-ERROR_EXIT:
-    Endpoint_SelectEndpoint(ep);
-    return -1;
-}
+int8_t sendchar(uint8_t c) { return tx_buffer_write(&console_tx_buffer, &c, 1) ? 0 : -1; }
 #else
 int8_t sendchar(uint8_t c) { return 0; }
 #endif
@@ -862,11 +820,46 @@ void virtser_recv(uint8_t c) {
     // Ignore by default
 }
 
+TX_BUFFER_DEFINE(virtser_tx_buffer, VIRTSER_TX_BUFFER_SIZE);
+
+/** \brief Virtual Serial Flush
+ *
+ * Sends up to one packet of queued data. A packet that fills the endpoint is
+ * followed by a zero length packet once the queue runs dry, so the host sees
+ * the end of the transfer.
+ */
+static void virtser_flush(void) {
+    static bool zlp_pending = false;
+
+    if (!(cdc_device.State.ControlLineStates.HostToDevice & CDC_CONTROL_LINE_OUT_DTR)) {
+        // Nobody is listening, drop output as the unbuffered path did
+        tx_buffer_clear(&virtser_tx_buffer);
+        zlp_pending = false;
+        return;
+    }
+
+    uint16_t used = tx_buffer_used(&virtser_tx_buffer);
+    if (!used && !zlp_pending) return;
+
+    uint8_t ep = Endpoint_GetCurrentEndpoint();
+    Endpoint_SelectEndpoint(cdc_device.Config.DataINEndpoint.Address);
+    if (Endpoint_IsEnabled() && Endpoint_IsConfigured() && Endpoint_IsINReady()) {
+        uint8_t packet[CDC_EPSIZE];
+        uint8_t length = tx_buffer_read(&virtser_tx_buffer, packet, sizeof(packet));
+        Endpoint_Write_Stream_LE(packet, length, NULL);
+        Endpoint_ClearIN();
+        zlp_pending = length == sizeof(packet);
+    }
+    Endpoint_SelectEndpoint(ep);
+}
+
 /** \brief Virtual Serial Task
  *
  * FIXME: Needs doc
  */
 void virtser_task(void) {
+    virtser_flush();
+
     uint16_t count = CDC_Device_BytesReceived(&cdc_device);
     uint8_t  ch;
     if (count) {
@@ -876,33 +869,9 @@ void virtser_task(void) {
 }
 /** \brief Virtual Serial Send
  *
- * FIXME: Needs doc
+ * Queues the byte; virtser_task() sends it.
  */
-void virtser_send(const uint8_t byte) {
-    uint8_t timeout = 255;
-    uint8_t ep      = Endpoint_GetCurrentEndpoint();
-
-    if (cdc_device.State.ControlLineStates.HostToDevice & CDC_CONTROL_LINE_OUT_DTR) {
-        /* IN packet */
-        Endpoint_SelectEndpoint(cdc_device.Config.DataINEndpoint.Address);
-
-        if (!Endpoint_IsEnabled() || !Endpoint_IsConfigured()) {
-            Endpoint_SelectEndpoint(ep);
-            return;
-        }
-
-        while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-
-        Endpoint_Write_8(byte);
-        CDC_Device_Flush(&cdc_device);
-
-        if (Endpoint_IsINReady()) {
-            Endpoint_ClearIN();
-        }
-
-        Endpoint_SelectEndpoint(ep);
-    }
-}
+void virtser_send(const uint8_t byte) { tx_buffer_write(&virtser_tx_buffer, &byte, 1); }
 #endif
 
 /*******************************************************************************
@@ -934,8 +903,6 @@ static void setup_usb(void) {
 
     USB_Init();
 
-    // for Console_Task
-    USB_Device_EnableSOFEvents();
     print_set_sendchar(sendchar);
 }
 
@@ -996,6 +963,7 @@ int main(void) {
 #endif
 
         keyboard_task();
+        usb_event_print();
 
 #ifdef MIDI_ENABLE
         MIDI_Device_USBTask(&USB_MIDI_Interface);
@@ -1018,6 +986,10 @@ int main(void) {
         raw_hid_task();
 #endif
 
+#ifdef CONSOLE_ENABLE
+        Console_Task();
+#endif
+
 #if !defined(INTERRUPT_CONTROL_ENDPOINT)
         USB_USBTask();
 #endif
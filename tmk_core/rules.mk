@@ -345,13 +345,13 @@ $1/%.a : $1/%.o
 $1/force:
 
 $1/cflags.txt: $1/force
-	echo '$$($1_CFLAGS)' | cmp -s - $$@ || echo '$$($1_CFLAGS)' > $$@
+	echo '$$(or $$($1_FLAGS_ID),$$($1_CFLAGS))' | cmp -s - $$@ || echo '$$(or $$($1_FLAGS_ID),$$($1_CFLAGS))' > $$@
 
 $1/cppflags.txt: $1/force
-	echo '$$($1_CPPFLAGS)' | cmp -s - $$@ || echo '$$($1_CPPFLAGS)' > $$@
+	echo '$$(or $$($1_FLAGS_ID),$$($1_CPPFLAGS))' | cmp -s - $$@ || echo '$$(or $$($1_FLAGS_ID),$$($1_CPPFLAGS))' > $$@
 
 $1/asflags.txt: $1/force
-	echo '$$($1_ASFLAGS)' | cmp -s - $$@ || echo '$$($1_ASFLAGS)' > $$@
+	echo '$$(or $$($1_FLAGS_ID),$$($1_ASFLAGS))' | cmp -s - $$@ || echo '$$(or $$($1_FLAGS_ID),$$($1_ASFLAGS))' > $$@
 
 $1/compiler.txt: $1/force
 	$$(CC) --version | cmp -s - $$@ || $$(CC) --version > $$@
@@ -395,9 +395,10 @@ objs-size:
 
 ifeq ($(findstring avr-gcc,$(CC)),avr-gcc)
 SIZE_MARGIN = 1024
+AVR_MAX_SIZE = $(shell n=`$(CC) -E -mmcu=$(MCU) $(CFLAGS) $(OPT_DEFS) tmk_core/common/avr/bootloader_size.c 2> /dev/null | sed -ne 's/\r//;/^#/n;/^AVR_SIZE:/,$${s/^AVR_SIZE: //;p;}'` && echo $$(($$n)) || echo 0)
 
 check-size:
-	$(eval MAX_SIZE=$(shell n=`$(CC) -E -mmcu=$(MCU) $(CFLAGS) $(OPT_DEFS) tmk_core/common/avr/bootloader_size.c 2> /dev/null | sed -ne 's/\r//;/^#/n;/^AVR_SIZE:/,$${s/^AVR_SIZE: //;p;}'` && echo $$(($$n)) || echo 0))
+	$(eval MAX_SIZE=$(AVR_MAX_SIZE))
 	$(eval CURRENT_SIZE=$(shell if [ -f $(BUILD_DIR)/$(TARGET).hex ]; then $(SIZE) --target=$(FORMAT) $(BUILD_DIR)/$(TARGET).hex | $(AWK) 'NR==2 {print $$4}'; else printf 0; fi))
 	$(eval FREE_SIZE=$(shell expr $(MAX_SIZE) - $(CURRENT_SIZE)))
 	$(eval OVER_SIZE=$(shell expr $(CURRENT_SIZE) - $(MAX_SIZE)))
@@ -419,6 +420,20 @@ check-size:
 	$(SILENT) || echo "(Firmware size check does not yet support $(MCU) microprocessors; skipping.)"
 endif
 
+# Attribute flash and RAM to features and symbols from the linker map. Point
+# SIZE_BASELINE at the $(TARGET).size.json of an earlier build to see what changed.
+SIZE_REPORT_ARGS = --mcu $(MCU) --output $(BUILD_DIR)/$(TARGET).size.json
+ifeq ($(findstring avr-gcc,$(CC)),avr-gcc)
+    SIZE_REPORT_ARGS += --flash-size $(AVR_MAX_SIZE)
+endif
+ifneq ($(strip $(SIZE_BASELINE)),)
+    SIZE_REPORT_ARGS += --baseline $(SIZE_BASELINE)
+endif
+
+size-report: $(BUILD_DIR)/$(TARGET).elf
+	@if [ ! -f $(BUILD_DIR)/$(TARGET).map ]; then echo "size-report needs the linker map, build with CREATE_MAP=yes"; exit 1; fi
+	@bin/qmk size-report $(SIZE_REPORT_ARGS) $(BUILD_DIR)/$(TARGET).map
+
 # Create build directory
 $(shell mkdir -p $(BUILD_DIR) 2>/dev/null)
 
@@ -430,7 +445,7 @@ $(eval $(foreach OUTPUT,$(OUTPUTS),$(shell mkdir -p $(OUTPUT) 2>/dev/null)))
 
 
 # Listing of phony targets.
-.PHONY : all finish sizebefore sizeafter qmkversion \
+.PHONY : all finish sizebefore sizeafter size-report qmkversion \
 gccversion build elf hex eep lss sym coff extcoff \
 clean clean_list debug gdb-config show_path \
 program teensy dfu flip dfu-ee flip-ee dfu-start \
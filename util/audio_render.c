@@ -0,0 +1,357 @@
+//
+// render songs through the ARM audio synth into a WAV file
+//
+// this is host program for quantum/audio/audio_synth.c, the engine behind quantum/audio/audio_arm.c.
+// It can also run the float math of the previous ARM driver side by side and report where the two
+// disagree, so changes to the synth can be regression tested without hardware.
+//
+// example:
+//  $ cc -Iquantum/audio -o util/audio_render util/audio_render.c quantum/audio/audio_synth.c -lm
+//  $ ./util/audio_render STARTUP_SOUND startup.wav           # fixed-point synth
+//  $ ./util/audio_render -r STARTUP_SOUND startup_float.wav  # float reference
+//  $ ./util/audio_render -c CAMPANELLA                       # compare both, exits 1 past 12 cents
+//
+// -l plays the song legato as held notes, the way music mode does, which exercises voices and
+// -g glissando. Add -DVIBRATO_ENABLE to the build line to render with vibrato.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "audio_synth.h"
+#include "musical_notes.h"
+#include "song_list.h"
+
+#define SAMPLE_HIGH 16383
+#define MAX_SECONDS 120
+// steady notes agree within half a cent, glides drift a little more as every
+// step is rounded to 1/256 semitone
+#define MAX_CENTS 12.0
+
+extern bool  glissando;
+extern float note_timbre;
+
+// voices.c is firmware only, keep the default voice without resetting glissando
+float voice_envelope(float frequency) { return frequency; }
+
+#define SONGS(X)         \
+    X(STARTUP_SOUND)     \
+    X(GOODBYE_SOUND)     \
+    X(PLANCK_SOUND)      \
+    X(PREONIC_SOUND)     \
+    X(COLEMAK_SOUND)     \
+    X(MUSIC_ON_SOUND)    \
+    X(MUSIC_OFF_SOUND)   \
+    X(CHROMATIC_SOUND)   \
+    X(AG_SWAP_SOUND)     \
+    X(CLUEBOARD_SOUND)   \
+    X(CAMPANELLA)
+
+#define SONG_ARRAY(name) static float name##_notes[][2] = SONG(name);
+SONGS(SONG_ARRAY)
+
+#define SONG_ENTRY(name) {#name, &name##_notes, sizeof(name##_notes) / sizeof(name##_notes[0])},
+static const struct {
+    const char *name;
+    float (*notes)[][2];
+    uint16_t count;
+} songs[] = {SONGS(SONG_ENTRY)};
+
+// -----------------------------------------------------------------------------
+// Float reference, the tick math of the previous audio_arm.c gpt_cb8(). Only the
+// output stage is shared with the synth: rests are silent and a single voice is
+// played inverted on the second channel.
+
+#ifdef VIBRATO_ENABLE
+static const float ref_vibrato_lut[20] = {
+    1.0022336811487, 1.0042529943610, 1.0058584256028, 1.0068905285205, 1.0072464122237, 1.0068905285205, 1.0058584256028, 1.0042529943610, 1.0022336811487, 1.0000000000000, 0.9977712970630, 0.9957650169978, 0.9941756956510, 0.9931566259436, 0.9928057204913, 0.9931566259436, 0.9941756956510, 0.9957650169978, 0.9977712970630, 1.0000000000000,
+};
+#endif
+
+static struct {
+    int      voices, voice_place;
+    float    frequency, frequency_alt, place;
+    float    frequencies[8];
+    float    vibrato_counter;
+    bool     playing_note, playing_notes;
+    float    note_frequency, note_length;
+    uint16_t note_position, current_note, notes_count;
+    bool     note_resting, notes_repeat;
+    float (*notes)[][2];
+    float    out[2];
+    bool     inverted;
+} ref;
+
+static float ref_vibrato(float average_freq) {
+#ifdef VIBRATO_ENABLE
+#    ifdef VIBRATO_STRENGTH_ENABLE
+    float vibrated_freq = average_freq * pow(ref_vibrato_lut[(int)ref.vibrato_counter], 0.5);
+#    else
+    float vibrated_freq = average_freq * ref_vibrato_lut[(int)ref.vibrato_counter];
+#    endif
+    ref.vibrato_counter = fmod(ref.vibrato_counter + 0.125 * (1.0 + 440.0 / average_freq), 20);
+    return vibrated_freq;
+#else
+    return average_freq;
+#endif
+}
+
+static float ref_glide(float current, float target) {
+    if (glissando) {
+        if (current != 0 && current < target && current < target * pow(2, -440 / target / 12 / 2)) {
+            return current * pow(2, 440 / current / 12 / 2);
+        } else if (current != 0 && current > target && current > target * pow(2, 440 / target / 12 / 2)) {
+            return current * pow(2, -440 / current / 12 / 2);
+        }
+    }
+    return target;
+}
+
+static void ref_note_on(float freq) {
+    if (ref.voices >= 8) return;
+    if (ref.playing_notes) memset(&ref, 0, sizeof(ref));
+    ref.playing_note = true;
+    if (freq >= AUDIO_SYNTH_MIN_FREQUENCY) ref.frequencies[ref.voices++] = freq;
+}
+
+static void ref_note_off(float freq) {
+    for (int i = ref.voices - 1; i >= 0; i--) {
+        if (ref.frequencies[i] == freq) {
+            memmove(&ref.frequencies[i], &ref.frequencies[i + 1], (7 - i) * sizeof(float));
+            ref.voices--;
+            break;
+        }
+    }
+    if (ref.voice_place >= ref.voices) ref.voice_place = 0;
+    if (ref.voices == 0) {
+        ref.playing_note = false;
+        ref.frequency = ref.frequency_alt = ref.out[0] = ref.out[1] = 0;
+    }
+}
+
+static void ref_song(float (*np)[][2], uint16_t count, bool repeat) {
+    memset(&ref, 0, sizeof(ref));
+    ref.playing_notes  = true;
+    ref.notes          = np;
+    ref.notes_count    = count;
+    ref.notes_repeat   = repeat;
+    ref.note_frequency = (*np)[0][0];
+    ref.note_length    = ((*np)[0][1] / 4) * (TEMPO_DEFAULT / 100.0f);
+}
+
+static void ref_tick(void) {
+    if (ref.playing_note && ref.voices > 0) {
+        ref.inverted = true;
+        if (ref.voices > 1) {
+            ref.frequency_alt = ref_glide(ref.frequency_alt, ref.frequencies[ref.voices - 2]);
+            ref.out[1]        = ref_vibrato(ref.frequency_alt);
+            ref.inverted      = false;
+        }
+        ref.frequency = ref_glide(ref.frequency, ref.frequencies[ref.voices - 1]);
+        ref.out[0]    = ref_vibrato(ref.frequency);
+    }
+
+    if (ref.playing_notes) {
+        ref.inverted = true;
+        ref.out[0]   = ref.note_frequency >= AUDIO_SYNTH_MIN_FREQUENCY ? ref_vibrato(ref.note_frequency) : 0;
+
+        ref.note_position++;
+        bool end_of_note = ref.note_resting ? ref.note_position >= ref.note_length * 8 : ref.note_position >= ref.note_length * 8 - 1;
+        if (end_of_note) {
+            uint16_t next = ref.current_note + 1;
+            if (next >= ref.notes_count) {
+                if (!ref.notes_repeat) {
+                    ref.playing_notes = false;
+                    ref.out[0]        = 0;
+                    return;
+                }
+                next = 0;
+            }
+            if (!ref.note_resting) {
+                ref.note_resting = true;
+                if ((*ref.notes)[ref.current_note][0] == (*ref.notes)[next][0]) {
+                    ref.note_frequency = 0;
+                }
+                ref.note_length = 1;
+            } else {
+                ref.note_resting   = false;
+                ref.current_note   = next;
+                ref.note_frequency = (*ref.notes)[next][0];
+                ref.note_length    = ((*ref.notes)[next][1] / 4) * (TEMPO_DEFAULT / 100.0f);
+            }
+            ref.note_position = 0;
+        }
+    }
+}
+
+static double ref_phase[2];
+
+static void ref_render(uint16_t *out1, uint16_t *out2, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        bool on[2];
+        for (int c = 0; c < 2; c++) {
+            on[c] = ref.out[c] > 0 && ref_phase[c] < note_timbre;
+            ref_phase[c] += ref.out[c] / AUDIO_DAC_SAMPLE_RATE;
+            ref_phase[c] -= floor(ref_phase[c]);
+        }
+        out1[i] = on[0] ? SAMPLE_HIGH : 0;
+        if (ref.inverted) {
+            out2[i] = ref.out[0] > 0 && !on[0] ? SAMPLE_HIGH : 0;
+        } else {
+            out2[i] = on[1] ? SAMPLE_HIGH : 0;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Driving both engines
+
+static bool use_reference = false;
+
+static void engine_note_on(float freq) {
+    audio_synth_note_on(freq);
+    ref_note_on(freq);
+}
+
+static void engine_note_off(float freq) {
+    audio_synth_note_off(freq);
+    ref_note_off(freq);
+}
+
+static bool engine_active(void) { return use_reference ? ref.playing_notes || ref.playing_note : audio_synth_playing_song() || audio_synth_playing_note(); }
+
+static float synth_hz(uint8_t channel) { return audio_synth_increment(channel) * ((float)AUDIO_DAC_SAMPLE_RATE / 4294967296.0f); }
+
+/* Legato playback: every note is held for its length and released just after the next one starts. */
+typedef struct {
+    bool     enabled;
+    uint16_t index, count;
+    uint32_t ticks_left;
+    float (*notes)[][2];
+    float held;
+} legato_t;
+
+static void legato_tick(legato_t *l) {
+    if (!l->enabled || l->ticks_left--) return;
+
+    float previous = l->held;
+    if (l->index < l->count) {
+        l->held       = (*l->notes)[l->index][0];
+        l->ticks_left = (uint32_t)((*l->notes)[l->index][1] * 2) - 1;
+        l->index++;
+        engine_note_on(l->held);
+    } else {
+        l->enabled = false;
+    }
+    if (previous) engine_note_off(previous);
+}
+
+static void write_le(FILE *f, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) fputc((value >> (8 * i)) & 0xFF, f);
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-r] [-l] [-g] SONG OUT.wav\n       %s -c [-l] [-g] SONG\n\nsongs:", name, name);
+    for (size_t i = 0; i < sizeof(songs) / sizeof(songs[0]); i++) fprintf(stderr, " %s", songs[i].name);
+    fprintf(stderr, "\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    bool     compare = false;
+    legato_t legato  = {0};
+    int      opt;
+
+    glissando = false;
+    while ((opt = getopt(argc, argv, "crlg")) != -1) {
+        switch (opt) {
+            case 'c': compare = true; break;
+            case 'r': use_reference = true; break;
+            case 'l': legato.enabled = true; break;
+            case 'g': glissando = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (argc - optind != (compare ? 1 : 2)) usage(argv[0]);
+
+    size_t song = 0;
+    while (song < sizeof(songs) / sizeof(songs[0]) && strcmp(songs[song].name, argv[optind])) song++;
+    if (song == sizeof(songs) / sizeof(songs[0])) usage(argv[0]);
+
+    audio_synth_reset();
+    if (legato.enabled) {
+        legato.notes = songs[song].notes;
+        legato.count = songs[song].count;
+    } else {
+        audio_synth_song(songs[song].notes, songs[song].count, false);
+        ref_song(songs[song].notes, songs[song].count, false);
+    }
+
+    FILE *wav = NULL;
+    if (!compare) {
+        wav = fopen(argv[optind + 1], "wb");
+        if (!wav) {
+            perror(argv[optind + 1]);
+            return 1;
+        }
+        fwrite("RIFF\0\0\0\0WAVEfmt ", 1, 16, wav);
+        write_le(wav, 16, 4);
+        write_le(wav, 1, 2);
+        write_le(wav, 1, 2);
+        write_le(wav, AUDIO_DAC_SAMPLE_RATE, 4);
+        write_le(wav, AUDIO_DAC_SAMPLE_RATE * 2, 4);
+        write_le(wav, 2, 2);
+        write_le(wav, 16, 2);
+        fwrite("data\0\0\0\0", 1, 8, wav);
+    }
+
+    uint32_t max_ticks = MAX_SECONDS * AUDIO_DAC_SAMPLE_RATE / AUDIO_SYNTH_TICK_SAMPLES;
+    uint32_t ticks = 0, samples = 0, mismatched = 0;
+    double   max_cents = 0;
+
+    while (ticks < max_ticks && (legato.enabled || engine_active())) {
+        legato_tick(&legato);
+        audio_synth_tick();
+        ref_tick();
+        ticks++;
+
+        if (compare) {
+            for (uint8_t c = 0; c < 2; c++) {
+                float  fixed     = synth_hz(c);
+                float  reference = c && ref.inverted ? ref.out[0] : ref.out[c];
+                double cents     = fixed > 0 && reference > 0 ? fabs(1200 * log2(fixed / reference)) : 0;
+                if ((fixed > 0) != (reference > 0)) {
+                    if (mismatched++ < 10) printf("tick %u channel %u: synth %.2f Hz, reference %.2f Hz\n", ticks, c + 1, fixed, reference);
+                }
+                if (cents > max_cents) max_cents = cents;
+            }
+            continue;
+        }
+
+        uint16_t out1[AUDIO_SYNTH_TICK_SAMPLES], out2[AUDIO_SYNTH_TICK_SAMPLES];
+        if (use_reference) {
+            ref_render(out1, out2, AUDIO_SYNTH_TICK_SAMPLES);
+        } else {
+            audio_synth_render(out1, out2, AUDIO_SYNTH_TICK_SAMPLES, SAMPLE_HIGH);
+        }
+        for (size_t i = 0; i < AUDIO_SYNTH_TICK_SAMPLES; i++) write_le(wav, (uint16_t)(int16_t)(out1[i] - out2[i]), 2);
+        samples += AUDIO_SYNTH_TICK_SAMPLES;
+    }
+
+    if (compare) {
+        printf("%s: %u ticks, %u silent/sounding mismatches, max pitch error %.2f cents\n", songs[song].name, ticks, mismatched, max_cents);
+        return mismatched || max_cents > MAX_CENTS;
+    }
+
+    fseek(wav, 4, SEEK_SET);
+    write_le(wav, 36 + samples * 2, 4);
+    fseek(wav, 40, SEEK_SET);
+    write_le(wav, samples * 2, 4);
+    fclose(wav);
+    printf("%s: %u ticks, %.2f s written to %s\n", songs[song].name, ticks, (double)samples / AUDIO_DAC_SAMPLE_RATE, argv[optind + 1]);
+    return 0;
+}